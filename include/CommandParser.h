@@ -0,0 +1,83 @@
+#ifndef CommandParser_h
+#define CommandParser_h
+
+#include <stdint.h>
+
+// most arguments a command takes
+#define COMMAND_MAX_ARGS 2
+
+// longest accepted command line, longer lines are rejected as a whole
+#ifndef COMMAND_MAX_LENGTH
+#define COMMAND_MAX_LENGTH 32
+#endif
+
+// Commands, one per line, arguments separated by blanks or commas:
+//   O <offset>          calibration offset in degrees C
+//   <offset>            same, a bare number as accepted before
+//   S <setpoint>        setpoint of the PID controller in degrees C
+//   C [fan] <curve>     control law of one or all fans,
+//                       0 PID, 1.. a fan curve
+//   F <fan> <duty>      fixed duty in percent, -1 back to automatic
+//   T <mode>            output: 0 text lines, 1 binary telemetry
+//   D [0]               dump the 1-Wire bus cost counters, D 0 clears them
+//   ?                   status report
+// Fans are numbered from 1, letters are case insensitive.
+enum CommandType {
+  CMD_NONE,
+  CMD_OFFSET,
+  CMD_SETPOINT,
+  CMD_CURVE,
+  CMD_FAN_DUTY,
+  CMD_TELEMETRY,
+  CMD_STATS,
+  CMD_STATUS,
+  CMD_ERROR
+};
+
+struct Command {
+  CommandType type;
+  uint8_t argc;
+  int16_t args[COMMAND_MAX_ARGS];
+};
+
+// Incremental command parser.
+//
+// Bytes are fed one at a time as they arrive, the parser keeps only its
+// state and the arguments parsed so far, so it never blocks and never
+// allocates, whatever the input. The serial receive FIFO is the buffer.
+class CommandParser {
+public:
+
+  CommandParser();
+
+  // feeds one byte, returns true when a line was completed, the command
+  // (or CMD_ERROR) is then available from getCommand()
+  bool feed(char);
+
+  const Command& getCommand(void);
+
+  // drops a partially received line
+  void reset(void);
+
+private:
+  enum State { PARSE_START, PARSE_BLANK, PARSE_NUMBER, PARSE_ERROR };
+
+  State state;
+  CommandType type;
+  uint8_t argc;
+  int16_t args[COMMAND_MAX_ARGS];
+  uint8_t length;
+
+  // number being parsed
+  bool negative;
+  bool hasDigits;
+  int32_t number;
+
+  Command command;
+
+  bool beginArgument(char);
+  bool endArgument(void);
+  bool finish(void);
+};
+
+#endif
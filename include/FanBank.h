@@ -0,0 +1,81 @@
+#ifndef FanBank_h
+#define FanBank_h
+
+#include <Arduino.h>
+#include "FanRpm.h"
+
+// number of fan channels a bank can drive
+#ifndef FAN_BANK_MAX_FANS
+#define FAN_BANK_MAX_FANS 4
+#endif
+
+// 4 pin fans expect a 25 kHz PWM signal
+#ifndef FAN_PWM_FREQUENCY
+#define FAN_PWM_FREQUENCY 25000
+#endif
+#define FAN_PWM_RESOLUTION 8
+
+// A bank of PWM fans with interrupt driven tacho capture.
+//
+// Every tacho falling edge is timestamped in an ISR and the speed is
+// computed from the duration of the last revolution (FanTacho), so a new
+// RPM value is available after a couple of tacho periods instead of a
+// fixed one second counting window. Fans sharing one PWM pin share its
+// output, which is driven at the highest duty cycle requested for any of
+// them, getDutyCycle() reports that applied duty.
+class FanBank {
+public:
+
+  FanBank();
+
+  // adds a fan, returns its index or -1 when the bank is full
+  int8_t addFan(uint8_t tachoPin, uint8_t pwmPin);
+
+  // sets up the PWM outputs and attaches the tacho interrupts
+  void begin(void);
+
+  uint8_t getFanCount(void);
+
+  // returns the fan speed in RPM, 0 when stalled or unknown
+  unsigned int getSpeed(uint8_t);
+
+  // sets the duty cycle of a fan in percent, 0-100
+  void setDutyCycle(uint8_t, uint8_t);
+
+  // sets the same duty cycle on all fans
+  void setDutyCycle(uint8_t);
+
+  // duty cycle the fan's PWM output runs at
+  uint8_t getDutyCycle(uint8_t);
+
+  // duty cycle last set for the fan, below the applied one when a fan on
+  // the same output asks for more
+  uint8_t getRequestedDutyCycle(uint8_t);
+
+  // true when another fan drives the same PWM output
+  bool isSharedOutput(uint8_t);
+
+private:
+  struct Channel {
+    uint8_t tachoPin;
+    uint8_t pwmPin;
+    uint8_t pwmChannel;
+    uint8_t duty;
+
+    // written by the tacho ISR only
+    FanTacho tacho;
+  };
+
+  Channel channels[FAN_BANK_MAX_FANS];
+  uint8_t fanCount;
+
+  static void IRAM_ATTR onTachoEdge(void*);
+
+  // highest duty of all fans on a PWM output
+  uint8_t outputDuty(uint8_t pwmChannel);
+
+  // writes the output duty of a fan's PWM output
+  void applyDuty(uint8_t);
+};
+
+#endif
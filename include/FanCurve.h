@@ -0,0 +1,131 @@
+#ifndef FanCurve_h
+#define FanCurve_h
+
+#include <stdint.h>
+#include "FixedTemp.h"
+#include "IndexSequence.h"
+
+// The curve table is indexed by the raw 1/128 degrees C probe value shifted
+// right by FAN_CURVE_SHIFT, 6 gives 0.5 degree C steps. It starts at
+// FAN_CURVE_MIN_C and has FAN_CURVE_STEPS entries of one byte.
+#ifndef FAN_CURVE_SHIFT
+#define FAN_CURVE_SHIFT 6
+#endif
+#ifndef FAN_CURVE_MIN_C
+#define FAN_CURVE_MIN_C 0
+#endif
+#ifndef FAN_CURVE_STEPS
+#define FAN_CURVE_STEPS 256
+#endif
+
+// table step of a raw temperature, clamped to the table
+inline unsigned fanCurveStep(int16_t raw) {
+  int32_t offset = (int32_t) raw - (int32_t) FAN_CURVE_MIN_C * 128;
+  if (offset < 0)
+    return 0;
+  offset >>= FAN_CURVE_SHIFT;
+  return offset >= FAN_CURVE_STEPS ? FAN_CURVE_STEPS - 1 : (unsigned) offset;
+}
+
+// Piecewise linear fan curve, compiled into a lookup table.
+//
+// The template arguments are (degrees C, duty percent) breakpoint pairs:
+//   typedef FanCurve<30, 20, 50, 45, 70, 100> QuietCurve;
+// Below the first breakpoint the first duty applies, above the last one
+// the last duty. A disconnected probe (TEMP128_INVALID) gets the full
+// duty, never the bottom of the table its value falls into. The build fails
+// unless the temperatures rise strictly and the duties never fall.
+// Evaluating the curve is a single table load:
+//   uint8_t duty = QuietCurve::lookup(sensors.getTemp(address));
+template <int... Points>
+class FanCurve {
+public:
+  static constexpr unsigned pointCount = sizeof...(Points) / 2;
+  static constexpr int points[sizeof...(Points)] = { Points... };
+
+  static_assert(sizeof...(Points) % 2 == 0, "fan curve needs (degrees C, duty) pairs");
+  static_assert(sizeof...(Points) >= 4, "fan curve needs at least two breakpoints");
+
+  // temperature and duty of breakpoint k
+  static constexpr int32_t tempRaw(unsigned k) { return (int32_t) points[2 * k] * 128; }
+  static constexpr int duty(unsigned k) { return points[2 * k + 1]; }
+
+  static constexpr bool isMonotonic(unsigned k = 0) {
+    return k + 1 >= pointCount ? true
+        : tempRaw(k) < tempRaw(k + 1) && duty(k) <= duty(k + 1) && isMonotonic(k + 1);
+  }
+
+  static constexpr bool isInRange(unsigned k = 0) {
+    return k >= pointCount ? true
+        : duty(k) >= 0 && duty(k) <= 100 && isInRange(k + 1);
+  }
+
+  static_assert(isMonotonic(), "fan curve temperatures must rise and duties must not fall");
+  static_assert(isInRange(), "fan curve duties must be 0-100 percent");
+
+  // duty at a raw temperature, interpolated from segment k onwards
+  static constexpr uint8_t dutyAt(int32_t raw, unsigned k = 0) {
+    return raw <= tempRaw(0) ? (uint8_t) duty(0)
+        : k + 1 >= pointCount ? (uint8_t) duty(pointCount - 1)
+        : raw < tempRaw(k + 1)
+            ? (uint8_t) (duty(k) + (duty(k + 1) - duty(k)) * (raw - tempRaw(k)) / (tempRaw(k + 1) - tempRaw(k)))
+            : dutyAt(raw, k + 1);
+  }
+
+  // raw temperature at the start of table step i
+  static constexpr int32_t stepRaw(unsigned i) {
+    return (int32_t) FAN_CURVE_MIN_C * 128 + ((int32_t) i << FAN_CURVE_SHIFT);
+  }
+
+  // the lookup table, one duty per step
+  static const uint8_t* table(void);
+
+  // duty in percent for a raw temperature, 100 without a reading
+  static uint8_t lookup(int16_t raw) {
+    return raw == TEMP128_INVALID ? 100 : table()[fanCurveStep(raw)];
+  }
+};
+
+template <int... Points>
+constexpr int FanCurve<Points...>::points[sizeof...(Points)];
+
+// storage of the table of a curve, expanded over all steps
+template <class Curve, class Steps>
+struct FanCurveTable;
+
+template <class Curve, unsigned... Is>
+struct FanCurveTable<Curve, IndexSequence<Is...> > {
+  static constexpr uint8_t values[sizeof...(Is)] = { Curve::dutyAt(Curve::stepRaw(Is))... };
+};
+
+template <class Curve, unsigned... Is>
+constexpr uint8_t FanCurveTable<Curve, IndexSequence<Is...> >::values[sizeof...(Is)];
+
+template <int... Points>
+const uint8_t* FanCurve<Points...>::table(void) {
+  return FanCurveTable<FanCurve<Points...>, typename MakeIndexSequence<FAN_CURVE_STEPS>::type>::values;
+}
+
+// Follows a fan curve table with hysteresis: the duty rises as soon as the
+// curve asks for more, but only falls once the temperature dropped a
+// hysteresis band below the point that raised it.
+class FanCurveFollower {
+public:
+
+  FanCurveFollower();
+
+  // table from FanCurve<...>::table() and hysteresis in table steps
+  void setCurve(const uint8_t*, uint8_t hysteresis);
+
+  // duty in percent for a raw temperature, 100 without a reading
+  uint8_t update(int16_t raw);
+
+  uint8_t getDutyCycle(void);
+
+private:
+  const uint8_t* curve;
+  uint8_t hysteresis;
+  uint8_t duty;
+};
+
+#endif
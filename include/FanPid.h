@@ -0,0 +1,79 @@
+#ifndef FanPid_h
+#define FanPid_h
+
+#include <stdint.h>
+
+// a fan commanded to at least this duty (percent) without tacho pulses for
+// FAN_PID_STALL_MS is stalled and gets kicked at full duty for FAN_PID_KICK_MS
+#ifndef FAN_PID_STALL_DUTY
+#define FAN_PID_STALL_DUTY 30
+#endif
+#ifndef FAN_PID_STALL_MS
+#define FAN_PID_STALL_MS 3000
+#endif
+#ifndef FAN_PID_KICK_MS
+#define FAN_PID_KICK_MS 1000
+#endif
+
+// Fixed-point PID fan controller.
+//
+// The temperatures are raw DS18B20 values in 1/128 degrees C and the gains
+// are Q8 fixed-point (value * 256):
+//   kp  duty percent per degree C
+//   ki  duty percent per degree C and second
+//   kd  duty percent per degree C per second
+// The error is measured - setpoint, a hotter probe means more airflow.
+// The derivative acts on the measurement so setpoint changes cause no kick,
+// the integrator stops while the output is saturated (anti-windup) and the
+// output is slew limited and never drops below the minimum duty.
+class FanPid {
+public:
+
+  FanPid();
+
+  void setTunings(int16_t kp, int16_t ki, int16_t kd);
+
+  // target temperature in 1/128 degrees C
+  void setSetpoint(int16_t);
+  int16_t getSetpoint(void);
+
+  // duty range in percent, the minimum keeps the fans turning
+  void setOutputLimits(uint8_t minDuty, uint8_t maxDuty);
+
+  // maximum change of the duty in percent per second, 0 for no limit
+  void setSlewRate(uint16_t);
+
+  // enables the stall check on the RPM passed to update()
+  void setStallCheck(bool);
+
+  // restarts the controller from the given duty
+  void reset(uint8_t duty);
+
+  // runs one control step dt milliseconds after the previous one,
+  // returns the new duty cycle in percent
+  uint8_t update(int16_t measured, unsigned int rpm, uint16_t dt);
+
+  uint8_t getDutyCycle(void);
+
+  // true while a stalled fan is being kicked
+  bool isStalled(void);
+
+private:
+  int16_t kp, ki, kd;
+  int16_t setpoint;
+  uint8_t minDuty, maxDuty;
+  uint16_t slewRate;
+  bool stallCheck;
+
+  // controller state, duties in Q16 percent
+  int32_t integral;
+  int32_t derivative;
+  int32_t output;
+  int16_t lastMeasured;
+  bool hasLast;
+
+  uint16_t stallTime;
+  uint16_t kickTime;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef FanRpm_h
+#define FanRpm_h
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#elif !defined(IRAM_ATTR)
+#define IRAM_ATTR
+#endif
+
+// tacho pulses per revolution, 2 for standard PC fans
+#ifndef FAN_PULSES_PER_REV
+#define FAN_PULSES_PER_REV 2
+#endif
+
+// tacho edges closer than this (in us) are PWM crosstalk, not pulses
+#ifndef FAN_MIN_EDGE_US
+#define FAN_MIN_EDGE_US 1000
+#endif
+
+// without a tacho edge for this long (in us) the fan counts as stopped
+#ifndef FAN_STALL_TIMEOUT_US
+#define FAN_STALL_TIMEOUT_US 500000UL
+#endif
+
+// Tacho capture of one fan, without the hardware.
+//
+// edge() takes the time of every falling tacho edge and keeps the last
+// revolution's worth of them, the speed is computed from how long that
+// revolution took. FanBank feeds it from its ISRs, on the host it runs on
+// synthetic timestamps.
+class FanTacho {
+public:
+
+  FanTacho();
+
+  // forgets all edges
+  void reset(void);
+
+  // a falling edge at now (us), may be called from an ISR
+  void IRAM_ATTR edge(uint32_t now);
+
+  // duration of the last revolution in us, 0 until one was seen
+  uint32_t getPeriod(void);
+
+  // time of the last edge in us
+  uint32_t getLastEdge(void);
+
+  // RPM for a revolution that took the given number of microseconds
+  static unsigned int rpmFromPeriod(uint32_t);
+
+  // RPM from a tacho snapshot: the last revolution period, the time of the
+  // last edge and the current time, all in microseconds. 0 when stalled or
+  // unknown.
+  static unsigned int rpmFromEdges(uint32_t period, uint32_t lastEdge, uint32_t now);
+
+private:
+  volatile uint32_t edgeTimes[FAN_PULSES_PER_REV];
+  volatile uint8_t edgeIndex;
+  volatile uint32_t lastEdge;
+  volatile uint32_t period;
+};
+
+#endif
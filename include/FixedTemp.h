@@ -0,0 +1,60 @@
+#ifndef FixedTemp_h
+#define FixedTemp_h
+
+#include <stdint.h>
+
+// Temperature in 1/128 degrees C, the fixed-point scaling the DS18xxx
+// probes report (DallasTemperature::getTemp()). Calibration, filtering,
+// the control laws and the serial output all work on this type.
+typedef int16_t Temp128;
+
+#define TEMP128_ONE_C 128
+
+// marks a missing reading, same value as DEVICE_DISCONNECTED_RAW
+#define TEMP128_INVALID (-7040)
+
+// longest text format() writes, "-256.00" plus terminator
+#define TEMP128_TEXT_SIZE 8
+
+class FixedTemp {
+public:
+
+  // whole degrees C to fixed-point
+  static Temp128 fromCelsius(int16_t);
+
+  // adds a calibration offset, saturating, a missing reading stays missing
+  static Temp128 addOffset(Temp128, Temp128);
+
+  // rounded to 1/100 degrees C
+  static int16_t toCentiCelsius(Temp128);
+
+  // writes the temperature as text with two decimals, e.g. "-12.06",
+  // returns the number of characters written
+  static uint8_t format(char*, Temp128);
+};
+
+// First-order low pass filter, y += (x - y) / 2^shift, with the fraction
+// kept so small steps are not lost to truncation.
+class TempFilter {
+public:
+
+  TempFilter(uint8_t shift = 2);
+
+  // forgets the history, the next sample is taken as is
+  void reset(void);
+
+  // adds a sample and returns the filtered value, missing readings are
+  // passed through and restart the filter
+  Temp128 update(Temp128);
+
+  Temp128 getValue(void);
+
+private:
+  uint8_t shift;
+  bool primed;
+
+  // filtered value in 1/128 degrees C, Q8
+  int32_t value;
+};
+
+#endif
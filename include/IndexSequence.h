@@ -0,0 +1,17 @@
+#ifndef IndexSequence_h
+#define IndexSequence_h
+
+// C++11 stand-in for std::index_sequence, used to expand compile-time
+// generated lookup tables: MakeIndexSequence<3>::type is IndexSequence<0, 1, 2>
+template <unsigned... Is>
+struct IndexSequence {};
+
+template <unsigned N, unsigned... Is>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Is...> {};
+
+template <unsigned... Is>
+struct MakeIndexSequence<0, Is...> {
+  typedef IndexSequence<Is...> type;
+};
+
+#endif
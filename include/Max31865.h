@@ -0,0 +1,229 @@
+#ifndef Max31865_h
+#define Max31865_h
+
+#include <stdint.h>
+#include "SpscRing.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <SPI.h>
+#endif
+
+// samples buffered between the reader task and the loop, a power of two
+#ifndef MAX31865_QUEUE_SIZE
+#define MAX31865_QUEUE_SIZE 16
+#endif
+
+// the chip takes up to 5 MHz
+#ifndef MAX31865_SPI_CLOCK
+#define MAX31865_SPI_CLOCK 4000000
+#endif
+
+// reader task, on the core the loop doesn't run on
+#ifndef MAX31865_TASK_PRIORITY
+#define MAX31865_TASK_PRIORITY 5
+#endif
+#ifndef MAX31865_TASK_CORE
+#define MAX31865_TASK_CORE 0
+#endif
+#define MAX31865_TASK_STACK 2048
+
+// drdyPin when DRDY isn't wired, results are polled with readAll()
+#define MAX31865_NO_DRDY 0xFF
+
+// without a DRDY edge for this long (in ms) the reader task checks the pin
+// itself, covers an edge lost while the result was still unread
+#define MAX31865_DRDY_TIMEOUT_MS 50
+
+// registers, the address of a write has the top bit set
+#define MAX31865_REG_CONFIG         0x00
+#define MAX31865_REG_RTD_MSB        0x01
+#define MAX31865_REG_HIGH_FAULT_MSB 0x03
+#define MAX31865_REG_LOW_FAULT_MSB  0x05
+#define MAX31865_REG_FAULT_STATUS   0x07
+#define MAX31865_REG_COUNT          8
+#define MAX31865_WRITE              0x80
+
+// configuration register
+#define MAX31865_CONFIG_VBIAS       0x80
+#define MAX31865_CONFIG_AUTO        0x40
+#define MAX31865_CONFIG_ONE_SHOT    0x20
+#define MAX31865_CONFIG_3WIRE       0x10
+#define MAX31865_CONFIG_FAULT_CLEAR 0x02
+#define MAX31865_CONFIG_50HZ        0x01
+
+// fault detection cycle, bits 3:2 of the configuration register. They read
+// back 0 once the chip finished the cycle.
+#define MAX31865_FAULT_DETECT_MASK     0x0C
+#define MAX31865_FAULT_DETECT_AUTO     0x04
+#define MAX31865_FAULT_DETECT_MANUAL_1 0x08
+#define MAX31865_FAULT_DETECT_MANUAL_2 0x0C
+
+// fault status register
+#define MAX31865_FAULT_HIGH_THRESHOLD 0x80
+#define MAX31865_FAULT_LOW_THRESHOLD  0x40
+#define MAX31865_FAULT_REFIN          0x20
+#define MAX31865_FAULT_REFIN_FORCE    0x10
+#define MAX31865_FAULT_RTDIN_FORCE    0x08
+#define MAX31865_FAULT_VOLTAGE        0x04
+#define MAX31865_FAULT_MASK           0xFC
+
+// not a chip bit, the chip leaves bits 1:0 of the status unused: a fault
+// detection cycle that didn't finish in time
+#define MAX31865_FAULT_TIMEOUT        0x01
+
+// one conversion result
+struct RtdSample {
+  uint16_t code;   // 15 bit RTD to reference resistance ratio, 32768 = Rref
+  uint8_t fault;   // fault status register when the fault bit was set, else 0
+  uint32_t time;   // micros() of the DRDY edge
+};
+
+// SPI access to one chip, chip select is up to the implementation
+class Max31865Bus {
+public:
+
+  // clocks out length bytes of data with chip select held low and stores
+  // the bytes clocked in in their place
+  virtual void transfer(uint8_t* data, uint8_t length) = 0;
+};
+
+#ifdef ARDUINO
+
+// Max31865Bus on an Arduino SPI port
+class Max31865SpiBus : public Max31865Bus {
+public:
+
+  Max31865SpiBus(SPIClass& spi, uint8_t csPin);
+
+  // starts the port on the given pins, -1 keeps the port's default pin,
+  // and drives chip select high
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1);
+
+  void transfer(uint8_t* data, uint8_t length);
+
+private:
+  SPIClass& spi;
+  uint8_t csPin;
+};
+
+#endif
+
+// MAX31865 RTD converter running continuously.
+//
+// The chip converts on its own at the mains filter rate, 60 per second
+// with the 60 Hz filter and 50 with the 50 Hz one, and pulls DRDY low for
+// every result. The falling edge wakes a reader task that fetches the RTD
+// register and queues the sample. read() takes samples off the queue and
+// never waits, so the loop gets every conversion without blocking on SPI
+// or conversion time.
+//
+// Without DRDY wired there is no task either, the loop polls readAll()
+// instead. Auto conversion keeps the RTD register current, so a poll is one
+// burst transaction and doesn't wait for a conversion.
+//
+// Without the ESP32 core there is no task: dataReady() and service() are
+// called directly, which is how the queue logic runs on the host.
+class Max31865 {
+public:
+
+  Max31865(Max31865Bus* bus, uint8_t drdyPin);
+
+  // connection and mains filter, set before begin()
+  void setThreeWire(bool);
+  void setFilter50Hz(bool);
+
+  // fault thresholds as 15 bit ratio codes, set before begin()
+  void setFaultThresholds(uint16_t low, uint16_t high);
+
+  // configures auto conversion and starts the reader, false when the chip
+  // doesn't read back the configuration written to it
+  bool begin(void);
+
+  // stops the reader and turns off the bias voltage
+  void end(void);
+
+  // next sample, false when none is waiting
+  bool read(RtdSample*);
+
+  // samples waiting to be read
+  uint8_t available(void);
+
+  // samples dropped because the queue was full
+  uint32_t getOverruns(void);
+
+  // reads every register in one transaction, returns the fault status. For
+  // polling without DRDY, it would take results from the reader task.
+  uint8_t readAll(void);
+
+  // values of the last readAll()
+  uint16_t getCode(void);
+  uint8_t getFault(void);
+  uint16_t getLowThreshold(void);
+  uint16_t getHighThreshold(void);
+
+  // reader side: a conversion result became ready at now (micros)
+  void dataReady(uint32_t now);
+
+  // reader side: fetches the result, clears a fault and queues the sample
+  void service(void);
+
+  // resistance in milliohms of a ratio code for a reference in ohms
+  static uint32_t resistance(uint16_t code, uint16_t referenceOhms);
+
+  // stops auto conversion and starts a fault detection cycle, stage is one
+  // of MAX31865_FAULT_DETECT_..., until resume() the reader leaves the
+  // configuration alone
+  void startFaultDetection(uint8_t stage);
+
+  // true once the chip finished the fault detection cycle
+  bool isFaultDetectionDone(void);
+
+  // fault status register, MAX31865_FAULT_... bits
+  uint8_t readFaultStatus(void);
+
+  // clears the fault status and goes back to auto conversion
+  void resume(void);
+
+  // text of one MAX31865_FAULT_... bit, MAX31865_FAULT_TIMEOUT included,
+  // empty for other bits
+  static const char* faultText(uint8_t bit);
+
+  // Callendar-Van Dusen temperature in degrees C of a ratio code, in
+  // floating point, RtdConversion.h has the integer version
+  static float temperature(uint16_t code, float nominalOhms, float referenceOhms);
+
+private:
+  Max31865Bus* bus;
+  uint8_t drdyPin;
+  uint8_t config;
+  uint16_t lowThreshold;
+  uint16_t highThreshold;
+  uint8_t registers[MAX31865_REG_COUNT];
+
+  volatile bool suspended;
+  volatile uint32_t readyTime;
+  volatile uint32_t overruns;
+  SpscRing<RtdSample, MAX31865_QUEUE_SIZE> queue;
+
+#ifdef ARDUINO
+  volatile TaskHandle_t task;
+  volatile bool running;
+
+  // held around suspended and the configuration write that depends on it
+  SemaphoreHandle_t configLock;
+  StaticSemaphore_t configLockBuffer;
+
+  static void IRAM_ATTR onDataReady(void*);
+  static void readerTask(void*);
+#endif
+
+  void lockConfig(void);
+  void unlockConfig(void);
+  uint8_t readRegister(uint8_t);
+  uint16_t readRegister16(uint8_t);
+  void writeRegister(uint8_t, uint8_t);
+  void writeRegister16(uint8_t, uint16_t);
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef Mlx90614_h
+#define Mlx90614_h
+
+#include <stdint.h>
+#include "SpscRing.h"
+#include "FixedTemp.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Wire.h>
+#endif
+
+#define MLX90614_DEFAULT_ADDRESS 0x5A
+
+// RAM addresses read with the SMBus read word command
+#define MLX90614_AMBIENT_TEMP 0x06
+#define MLX90614_OBJECT_TEMP  0x07
+
+// the temperature registers set the top bit instead of a value on error
+#define MLX90614_ERROR_FLAG 0x8000
+
+// SMBus clock, the datasheet allows up to 100 kHz. Many parts run at
+// 400 kHz, out of specification.
+#ifndef MLX90614_I2C_CLOCK
+#define MLX90614_I2C_CLOCK 100000
+#endif
+
+// longest a transfer may hang on a stuck bus, in ms
+#ifndef MLX90614_TIMEOUT_MS
+#define MLX90614_TIMEOUT_MS 5
+#endif
+
+// time between reads in ms, the sensor refreshes its output about this often
+#ifndef MLX90614_PERIOD_MS
+#define MLX90614_PERIOD_MS 100
+#endif
+
+// samples buffered between the reader task and the loop, a power of two
+#ifndef MLX90614_QUEUE_SIZE
+#define MLX90614_QUEUE_SIZE 8
+#endif
+
+// reader task
+#ifndef MLX90614_TASK_PRIORITY
+#define MLX90614_TASK_PRIORITY 3
+#endif
+#ifndef MLX90614_TASK_CORE
+#define MLX90614_TASK_CORE 0
+#endif
+#define MLX90614_TASK_STACK 2048
+
+// one pair of readings, raw in 0.02 K steps
+struct IrSample {
+  uint16_t object;
+  uint16_t ambient;
+  uint32_t time;     // millis() of the read
+};
+
+// SMBus access to the sensors on one bus
+class Mlx90614Bus {
+public:
+
+  // sends command and, after a repeated start, reads length bytes into
+  // data. False when a slave doesn't answer within the timeout.
+  virtual bool read(uint8_t address, uint8_t command, uint8_t* data, uint8_t length) = 0;
+};
+
+#ifdef ARDUINO
+
+// Mlx90614Bus on an Arduino I2C port
+class Mlx90614WireBus : public Mlx90614Bus {
+public:
+
+  Mlx90614WireBus(TwoWire& wire);
+
+  // starts the port on the given pins, -1 keeps the port's default pin,
+  // at MLX90614_I2C_CLOCK with a MLX90614_TIMEOUT_MS timeout
+  void begin(int sda = -1, int scl = -1);
+
+  bool read(uint8_t address, uint8_t command, uint8_t* data, uint8_t length);
+
+private:
+  TwoWire& wire;
+};
+
+#endif
+
+// MLX90614 infrared thermometer read in the background.
+//
+// Every MLX90614_PERIOD_MS a reader task reads the object and then the
+// ambient temperature, back to back, and checks the packet error code of
+// both. A pair that passes is queued and handed to the callback, read()
+// takes pairs off the queue and never waits, so the loop doesn't block on
+// the bus. Failed reads are counted and dropped.
+//
+// Without the ESP32 core there is no task: service() is called directly,
+// which is how the driver runs on the host.
+class Mlx90614 {
+public:
+
+  // called by the reader with every good pair, in the reader's context
+  typedef void (*Callback)(const IrSample&, void*);
+
+  Mlx90614(Mlx90614Bus* bus, uint8_t address = MLX90614_DEFAULT_ADDRESS);
+
+  // ms between reads, set before begin()
+  void setPeriod(uint16_t);
+
+  // set before begin()
+  void setCallback(Callback, void*);
+
+  // reads the sensor once and starts the reader, false when it doesn't
+  // answer with a valid pair
+  bool begin(void);
+
+  // stops the reader
+  void end(void);
+
+  // next pair, false when none is waiting
+  bool read(IrSample*);
+
+  // pairs waiting to be read
+  uint8_t available(void);
+
+  // reads that failed, no answer, bad packet error code or error flag
+  uint32_t getErrors(void);
+
+  // pairs dropped because the queue was full
+  uint32_t getOverruns(void);
+
+  // reader side: reads a pair at now (ms), true when it was queued
+  bool service(uint32_t now);
+
+  // SMBus packet error code, CRC-8 with polynomial x^8 + x^2 + x + 1
+  static uint8_t pec(const uint8_t* data, uint8_t length);
+
+  // raw 0.02 K reading in 1/100 degrees C, exact
+  static int32_t toCentiCelsius(uint16_t raw);
+
+  // raw 0.02 K reading in 1/128 degrees C, saturated to the type
+  static Temp128 toTemp128(uint16_t raw);
+
+private:
+  Mlx90614Bus* bus;
+  uint8_t address;
+  uint16_t period;
+  Callback callback;
+  void* callbackArg;
+
+  volatile uint32_t errors;
+  volatile uint32_t overruns;
+  SpscRing<IrSample, MLX90614_QUEUE_SIZE> queue;
+
+#ifdef ARDUINO
+  volatile TaskHandle_t task;
+  volatile bool running;
+
+  static void readerTask(void*);
+#endif
+
+  bool readRegister(uint8_t command, uint16_t* value);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef ResolutionManager_h
+#define ResolutionManager_h
+
+#include <DallasTemperature.h>
+
+// probes whose resolution is managed
+#ifndef RESOLUTION_MAX_SENSORS
+#define RESOLUTION_MAX_SENSORS 8
+#endif
+
+// fan curve breakpoints watched
+#ifndef RESOLUTION_MAX_BREAKPOINTS
+#define RESOLUTION_MAX_BREAKPOINTS 8
+#endif
+
+// a probe that moved this far (1/128 degrees C) within RESOLUTION_WINDOW_MS
+// is changing fast, 1 degree C in 2 s. Two 9 bit steps, so quantisation
+// alone never counts as change.
+#ifndef RESOLUTION_FAST_DELTA
+#define RESOLUTION_FAST_DELTA 128
+#endif
+#ifndef RESOLUTION_WINDOW_MS
+#define RESOLUTION_WINDOW_MS 2000
+#endif
+
+// distance to a breakpoint (1/128 degrees C) that counts as near, 1 degree C
+#ifndef RESOLUTION_BREAKPOINT_MARGIN
+#define RESOLUTION_BREAKPOINT_MARGIN 128
+#endif
+
+// a probe has to be quiet this long before its resolution is raised again
+#ifndef RESOLUTION_SETTLE_MS
+#define RESOLUTION_SETTLE_MS 5000
+#endif
+
+// Adaptive probe resolution.
+//
+// A DS18B20 converts in 94 ms at 9 bits and 750 ms at 12 bits. While a
+// probe changes fast it is dropped to 9 bits, near a fan curve breakpoint
+// to 10 bits, so the fans follow quickly where it matters. After
+// RESOLUTION_SETTLE_MS without either it goes back to 12 bits. Lowering
+// happens at once, raising only after the settle time, which keeps a probe
+// from toggling. The changes skip the EEPROM copy, they cost no write
+// endurance and a power cycle restores the stored resolution.
+class ResolutionManager {
+public:
+
+  ResolutionManager(DallasTemperature*);
+
+  // temperatures (1/128 degrees C) near which fast updates count
+  void setBreakpoints(const int16_t*, uint8_t);
+
+  // takes over the probes found by sensors.begin()
+  void begin(void);
+
+  // feed a fresh sample of probe index, in getAddress() order. Returns
+  // true when the resolution of the probe was changed.
+  bool update(uint8_t index, int16_t raw, unsigned long now);
+
+  // resolution the probe runs at, 9-12 bits
+  uint8_t getResolution(uint8_t);
+
+  // resolution wanted for a probe that is changing fast or near a
+  // breakpoint, 12 bits for neither
+  static uint8_t target(bool fast, bool nearBreakpoint);
+
+private:
+  struct Sensor {
+    uint8_t resolution;
+    bool adjustable;            // the DS18S20 has a fixed resolution
+    int16_t referenceRaw;       // start of the change window
+    unsigned long referenceTime;
+    unsigned long holdSince;    // last time a lower resolution was wanted
+  };
+
+  DallasTemperature* _sensors;
+  Sensor sensors[RESOLUTION_MAX_SENSORS];
+  uint8_t sensorCount;
+
+  int16_t breakpoints[RESOLUTION_MAX_BREAKPOINTS];
+  uint8_t breakpointCount;
+
+  bool isNearBreakpoint(int16_t);
+};
+
+#endif
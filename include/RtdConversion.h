@@ -0,0 +1,81 @@
+#ifndef RtdConversion_h
+#define RtdConversion_h
+
+#include <stdint.h>
+#include "IndexSequence.h"
+
+// The table holds the ratio code of every RTD_TABLE_STEP_C degrees from
+// RTD_TABLE_MIN_C on, RTD_TABLE_STEPS entries. 5 degree steps keep the
+// linear interpolation within 0.003 degrees C of the curve.
+#define RTD_TABLE_MIN_C (-200)
+#define RTD_TABLE_STEP_C 5
+#define RTD_TABLE_STEPS 211
+
+// Callendar-Van Dusen coefficients of IEC 60751 platinum
+#define RTD_CVD_A 3.9083e-3
+#define RTD_CVD_B (-5.775e-7)
+#define RTD_CVD_C (-4.183e-12)
+
+// temperature in milli degrees C of a 15 bit ratio code, interpolated in a
+// table of RtdConversion<>, clamped to the table
+int32_t rtdTableLookup(const uint32_t* table, uint16_t code);
+
+// Integer RTD conversion for a sensor and reference resistor, compiled
+// into a lookup table:
+//   typedef RtdConversion<100, 430> Pt100;
+//   int32_t milli = Pt100::toMilliCelsius(rtd.getCode());
+// The table stores the MAX31865 ratio code of each step with 16 fraction
+// bits, so no rounding to whole codes adds to the interpolation error.
+template <unsigned NominalOhms, unsigned ReferenceOhms>
+class RtdConversion {
+public:
+
+  // resistance at t degrees C, the C term only applies below 0
+  static constexpr double resistanceAt(double t) {
+    return NominalOhms * (1 + RTD_CVD_A * t + RTD_CVD_B * t * t
+                          + (t < 0 ? RTD_CVD_C * (t - 100) * t * t * t : 0));
+  }
+
+  // ratio code with 16 fraction bits at the start of table step i
+  static constexpr uint32_t stepCode(unsigned i) {
+    return (uint32_t) (resistanceAt(RTD_TABLE_MIN_C + (double) i * RTD_TABLE_STEP_C)
+                       / ReferenceOhms * 2147483648.0 + 0.5);
+  }
+
+  static_assert(NominalOhms > 0 && ReferenceOhms > 0, "RTD resistances must be positive");
+  static_assert(resistanceAt(RTD_TABLE_MIN_C + (RTD_TABLE_STEPS - 1) * RTD_TABLE_STEP_C) < 2.0 * ReferenceOhms,
+                "reference resistor too small for the RTD table");
+
+  // the lookup table, one code per step
+  static const uint32_t* table(void);
+
+  // temperature in milli degrees C of a 15 bit ratio code
+  static int32_t toMilliCelsius(uint16_t code) {
+    return rtdTableLookup(table(), code);
+  }
+};
+
+// storage of the table of a conversion, expanded over all steps
+template <class Conversion, class Steps>
+struct RtdConversionTable;
+
+template <class Conversion, unsigned... Is>
+struct RtdConversionTable<Conversion, IndexSequence<Is...> > {
+  static constexpr uint32_t values[sizeof...(Is)] = { Conversion::stepCode(Is)... };
+};
+
+template <class Conversion, unsigned... Is>
+constexpr uint32_t RtdConversionTable<Conversion, IndexSequence<Is...> >::values[sizeof...(Is)];
+
+template <unsigned NominalOhms, unsigned ReferenceOhms>
+const uint32_t* RtdConversion<NominalOhms, ReferenceOhms>::table(void) {
+  return RtdConversionTable<RtdConversion<NominalOhms, ReferenceOhms>,
+                            typename MakeIndexSequence<RTD_TABLE_STEPS>::type>::values;
+}
+
+// the sensor and reference combinations of the breakout boards
+typedef RtdConversion<100, 430> Pt100Rref430;
+typedef RtdConversion<1000, 3900> Pt1000Rref3900;
+typedef RtdConversion<1000, 4300> Pt1000Rref4300;
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RtdFaultSupervisor_h
+#define RtdFaultSupervisor_h
+
+#include <stdint.h>
+#include "Max31865.h"
+
+// time between fault detection cycles in ms
+#ifndef RTD_FAULT_INTERVAL_MS
+#define RTD_FAULT_INTERVAL_MS 10000
+#endif
+
+// wait after the first manual stage in ms, 5 time constants of the input
+// filter. The breakout boards need about 60.
+#ifndef RTD_FAULT_SETTLE_MS
+#define RTD_FAULT_SETTLE_MS 60
+#endif
+
+// a bad reading starts a cycle no sooner than this many ms after the last
+// one, a fault that persists doesn't stop the measurement
+#ifndef RTD_FAULT_RETRY_MS
+#define RTD_FAULT_RETRY_MS 1000
+#endif
+
+// a cycle the chip doesn't finish within this many ms is given up and
+// reported as MAX31865_FAULT_TIMEOUT
+#define RTD_FAULT_TIMEOUT_MS 10
+
+// Runs the MAX31865 fault detection cycle next to the measurement.
+//
+// Auto conversion stops only for the cycle itself, about 65 ms every
+// RTD_FAULT_INTERVAL_MS, or after a reading looked wrong: a fault
+// bit, an open or shorted input, or a jump larger than the set step.
+// update() moves the cycle one stage on when its time has come and never
+// waits, the loop keeps running and only sees no new readings meanwhile.
+class RtdFaultSupervisor {
+public:
+
+  RtdFaultSupervisor(Max31865*);
+
+  // ms between cycles, 0 runs them only on request or a bad reading
+  void setInterval(uint32_t);
+
+  // ms to wait after the first manual stage
+  void setSettleTime(uint8_t);
+
+  // change in ratio code between two readings taken as implausible, 0 off
+  void setMaxStep(uint16_t);
+
+  // screens a reading, one that looks wrong requests a cycle
+  void check(uint16_t code, uint8_t fault);
+
+  // runs a cycle on the next update()
+  void request(void);
+
+  // steps the cycle, now in ms
+  void update(uint32_t now);
+
+  // false while a cycle runs, readings from the chip are stale then
+  bool isMeasuring(void);
+
+  // MAX31865_FAULT_... bits found by the last cycle, MAX31865_FAULT_TIMEOUT
+  // alone when the chip didn't finish it
+  uint8_t getFaults(void);
+
+  // cycles run since construction
+  uint32_t getCycleCount(void);
+
+private:
+  enum State { MEASURING, SETTLING, DETECTING };
+
+  Max31865* rtd;
+  State state;
+  uint32_t interval;
+  uint8_t settleTime;
+  uint16_t maxStep;
+
+  bool requested;
+  bool suspect;
+  bool primed;
+  uint16_t lastCode;
+  uint32_t lastCycle;
+  uint32_t stateStart;
+  uint8_t faults;
+  uint32_t cycles;
+};
+
+#endif
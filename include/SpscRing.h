@@ -0,0 +1,59 @@
+#ifndef SpscRing_h
+#define SpscRing_h
+
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free queue between exactly one producer and one consumer, e.g. an
+// interrupt or reader task and the loop.
+//
+// head is written by the producer only and tail by the consumer only, the
+// release store of an index publishes the slot it covers to the other
+// side. The indexes run freely and wrap at 256, so Size is a power of two
+// of at most 128.
+template <typename T, uint8_t Size>
+class SpscRing {
+  static_assert(Size >= 2 && Size <= 128 && (Size & (Size - 1)) == 0,
+                "SpscRing size must be a power of two from 2 to 128");
+
+public:
+
+  SpscRing() : head(0), tail(0) {}
+
+  // producer: appends an item, false when the queue is full
+  bool push(const T& item) {
+    uint8_t h = head.load(std::memory_order_relaxed);
+    if ((uint8_t) (h - tail.load(std::memory_order_acquire)) == Size)
+      return false;
+    items[h & (Size - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer: takes the oldest item, false when the queue is empty
+  bool pop(T* item) {
+    uint8_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+      return false;
+    *item = items[t & (Size - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer: number of items waiting
+  uint8_t available(void) const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+  }
+
+  // consumer: drops all items waiting
+  void clear(void) {
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+private:
+  T items[Size];
+  std::atomic<uint8_t> head;
+  std::atomic<uint8_t> tail;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef Telemetry_h
+#define Telemetry_h
+
+#include <stdint.h>
+
+// channels carried in every frame, unused ones are sent as 0
+#define TELEMETRY_TEMPS 4
+#define TELEMETRY_FANS 4
+
+// layout version, the first payload byte
+#define TELEMETRY_VERSION 1
+
+// flags word
+#define TELEMETRY_FLAG_NO_PROBE   0x0001  // control probe missing, fans at full speed
+#define TELEMETRY_FLAG_STALL      0x0002  // a stalled fan is being kicked
+#define TELEMETRY_FLAG_MANUAL(n)  (0x0010 << (n))  // fan n runs on a fixed duty
+#define TELEMETRY_FLAG_CURVE(n)   (0x0100 << (n))  // fan n runs on a fan curve
+#define TELEMETRY_FLAG_SHARED(n)  (0x1000 << (n))  // fan n shares its PWM output
+
+// version, timestamp, temperatures, RPM, duty, flags
+#define TELEMETRY_PAYLOAD_SIZE (1 + 4 + 2 * TELEMETRY_TEMPS + 2 * TELEMETRY_FANS + TELEMETRY_FANS + 2)
+
+// payload and CRC after COBS, plus the 0 delimiter
+#define TELEMETRY_FRAME_SIZE (TELEMETRY_PAYLOAD_SIZE + 2 + 2)
+
+struct TelemetryFrame {
+  uint32_t timestamp;                      // millis()
+  int16_t temperatures[TELEMETRY_TEMPS];   // raw 1/128 degrees C
+  uint16_t rpm[TELEMETRY_FANS];
+  uint8_t duty[TELEMETRY_FANS];            // percent, as applied
+  uint16_t flags;
+};
+
+// Binary telemetry framing.
+//
+// A frame is the payload in little endian, followed by its CRC-16/CCITT
+// (0x1021, initial value 0xFFFF), COBS encoded and terminated by a 0 byte,
+// so a receiver resynchronises at the next 0 after any loss.
+// tools/telemetry_decode.py turns a capture into CSV.
+class Telemetry {
+public:
+
+  // encodes a frame into buffer (TELEMETRY_FRAME_SIZE bytes),
+  // returns the number of bytes to send
+  static uint8_t encode(const TelemetryFrame&, uint8_t*);
+
+  static uint16_t crc16(const uint8_t*, uint8_t);
+
+  // COBS encodes length bytes (at most 254), returns the encoded length
+  static uint8_t cobsEncode(const uint8_t*, uint8_t, uint8_t*);
+};
+
+#endif
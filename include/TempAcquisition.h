@@ -0,0 +1,99 @@
+#ifndef TempAcquisition_h
+#define TempAcquisition_h
+
+#include <DallasTemperature.h>
+
+// maximum number of DS18xxx probes sampled by the acquisition engine
+#ifndef TEMP_ACQ_MAX_SENSORS
+#define TEMP_ACQ_MAX_SENSORS 8
+#endif
+
+// alarm mode: whole degrees C a probe may move and stay quiet, and the
+// period of the full read that refreshes and re-arms all probes. TH and TL
+// go TEMP_ACQ_ALARM_WINDOW + 1 degrees either side of the probe's value,
+// it alarms on reaching them.
+#ifndef TEMP_ACQ_ALARM_WINDOW
+#define TEMP_ACQ_ALARM_WINDOW 1
+#endif
+#ifndef TEMP_ACQ_REFRESH_MS
+#define TEMP_ACQ_REFRESH_MS 10000
+#endif
+
+// Non-blocking temperature acquisition.
+//
+// update() starts a conversion on all probes and returns at once, a later
+// update() collects the results when the conversion has finished. The
+// control loop keeps running during the 94..750 ms conversion time instead
+// of stalling in DallasTemperature::blockTillConversionComplete().
+//
+// In pipelined mode every probe converts on its own schedule at its own
+// resolution, see DallasTemperature::pollPipeline(), and update() delivers
+// one probe at a time.
+//
+// In alarm mode the TH/TL comparators of the probes do the watching. Each
+// probe is armed with a window around its value, after every conversion
+// one alarm search finds the probes that left their window, only those
+// are read and re-armed. A full read every TEMP_ACQ_REFRESH_MS keeps the
+// values of the quiet probes exact. Meant for large, mostly steady buses.
+class TempAcquisition {
+public:
+
+  enum Mode { MODE_BROADCAST, MODE_PIPELINED, MODE_ALARM };
+
+  TempAcquisition(DallasTemperature*);
+
+  // how the probes are sampled, set before begin(). Pipelined mode needs
+  // an externally powered bus and alarm mode the library's alarm support,
+  // without them the probes are sampled by broadcast.
+  void setMode(Mode);
+
+  // mode in use after begin()
+  Mode getMode(void);
+
+  // switch the sensors to asynchronous conversions, call after sensors.begin()
+  void begin(void);
+
+  // advance the state machine, returns true when new samples are ready
+  bool update(unsigned long now);
+
+  // number of probes sampled
+  uint8_t getSensorCount(void);
+
+  // last raw value (1/128 degrees C) of a probe or DEVICE_DISCONNECTED_RAW
+  int16_t getTemp(uint8_t);
+
+  // true if the last update() brought a new value of the probe
+  bool isFresh(uint8_t);
+
+  // true while a conversion is running on the bus
+  bool isConverting(void);
+
+private:
+  enum State { ACQ_IDLE, ACQ_CONVERTING, ACQ_PIPELINED };
+
+  DallasTemperature* _sensors;
+  State state;
+  Mode mode;
+
+  // start of the running conversion and the time it may take at most
+  unsigned long conversionStart;
+  uint16_t conversionTime;
+
+  // poll the bus for completion instead of waiting the worst case time
+  bool pollForCompletion;
+
+  // alarm mode: the probes carry a window and when they were last all read
+  bool armed;
+  unsigned long lastRefresh;
+
+  uint8_t sensorCount;
+  int16_t temperatures[TEMP_ACQ_MAX_SENSORS];
+  bool fresh[TEMP_ACQ_MAX_SENSORS];
+
+  void startConversion(void);
+  void collect(void);
+  bool collectAlarms(void);
+  void arm(uint8_t, const uint8_t*);
+};
+
+#endif
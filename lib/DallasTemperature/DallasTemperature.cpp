@@ -0,0 +1,1841 @@
+﻿// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperature.h"
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+extern "C" {
+#include "WConstants.h"
+}
+#endif
+
+// constant tables stay in flash where the core tells flash from RAM
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const uint8_t*) (addr))
+#endif
+
+// OneWire commands
+#define STARTCONVO      0x44  // Tells device to take a temperature reading and put it on the scratchpad
+#define COPYSCRATCH     0x48  // Copy scratchpad to EEPROM
+#define READSCRATCH     0xBE  // Read from scratchpad
+#define WRITESCRATCH    0x4E  // Write to scratchpad
+#define RECALLSCRATCH   0xB8  // Recall from EEPROM to scratchpad
+#define READPOWERSUPPLY 0xB4  // Determine if device needs parasite power
+#define ALARMSEARCH     0xEC  // Query bus for devices with an alarm condition
+
+// Scratchpad locations
+#define TEMP_LSB        0
+#define TEMP_MSB        1
+#define HIGH_ALARM_TEMP 2
+#define LOW_ALARM_TEMP  3
+#define CONFIGURATION   4
+#define INTERNAL_BYTE   5
+#define COUNT_REMAIN    6
+#define COUNT_PER_C     7
+#define SCRATCHPAD_CRC  8
+
+// DSROM FIELDS
+#define DSROM_FAMILY    0
+#define DSROM_CRC       7
+
+// Device resolution
+#define TEMP_9_BIT  0x1F //  9 bit
+#define TEMP_10_BIT 0x3F // 10 bit
+#define TEMP_11_BIT 0x5F // 11 bit
+#define TEMP_12_BIT 0x7F // 12 bit
+
+#define MAX_CONVERSION_TIMEOUT		750
+
+// Alarm handler
+#define NO_ALARM_HANDLER ((AlarmHandler *)0)
+
+// Bus cost instrumentation, compiles to nothing unless REQUIRESSTATS is set
+#if REQUIRESSTATS
+#define DALLAS_STATS(api) StatsScope statsScope(this, api)
+#else
+#define DALLAS_STATS(api)
+#endif
+
+#if REQUIRESSTATS
+
+static const char* const statsNames[DALLAS_STATS_COUNT] = {
+	"begin",
+	"getAddress",
+	"isConnected",
+	"readScratchPad",
+	"writeScratchPad",
+	"saveScratchPad",
+	"recallScratchPad",
+	"readPowerSupply",
+	"getResolution",
+	"setResolution",
+	"requestTemperatures",
+	"requestByAddress",
+	"conversionComplete",
+	"getTemp",
+	"readAll",
+	"pipeline",
+	"userData",
+	"alarmTemp",
+	"alarmSearch",
+	"hasAlarm",
+	"processAlarms"
+};
+
+// the outermost public function of a call chain is charged
+DallasTemperature::StatsScope::StatsScope(DallasTemperature* owner,
+		uint8_t api) : owner(owner) {
+	if (owner->statsDepth++ == 0) {
+		owner->statsApi = api;
+		owner->stats[api].calls++;
+		start = micros();
+	}
+}
+
+DallasTemperature::StatsScope::~StatsScope() {
+	if (--owner->statsDepth == 0)
+		owner->stats[owner->statsApi].micros += micros() - start;
+}
+
+inline void DallasTemperature::countTraffic(uint8_t resets,
+		uint16_t writeSlots, uint16_t readSlots, uint8_t bytes, uint8_t crcs) {
+	if (statsDepth == 0)
+		return;
+	DallasStats& s = stats[statsApi];
+	s.resets += resets;
+	s.writeSlots += writeSlots;
+	s.readSlots += readSlots;
+	s.bytes += bytes;
+	s.crcs += crcs;
+}
+
+void DallasTemperature::getStats(DallasStats* snapshot) {
+	for (uint8_t i = 0; i < DALLAS_STATS_COUNT; i++)
+		snapshot[i] = stats[i];
+}
+
+void DallasTemperature::resetStats(void) {
+	for (uint8_t i = 0; i < DALLAS_STATS_COUNT; i++)
+		stats[i] = DallasStats();
+}
+
+const char* DallasTemperature::getStatsName(uint8_t api) {
+	return api < DALLAS_STATS_COUNT ? statsNames[api] : "";
+}
+
+#endif
+
+// Dallas/Maxim CRC8, x^8 + x^5 + x^4 + 1 fed least significant bit first.
+// DALLAS_CRC8_NIBBLE trades the 256 byte table for two of 16 bytes and a
+// second lookup per byte.
+#if DALLAS_CRC8_NIBBLE
+static const uint8_t crc8Low[16] PROGMEM = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41
+};
+static const uint8_t crc8High[16] PROGMEM = {
+	0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74
+};
+#else
+static const uint8_t crc8Table[256] PROGMEM = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+	0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+	0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+	0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+	0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+	0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+	0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+	0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+	0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+	0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+	0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+	0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+	0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+	0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+	0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+	0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+#endif
+
+// OneWire access, counted when REQUIRESSTATS is set
+inline uint8_t DallasTemperature::wireReset(void) {
+#if REQUIRESSTATS
+	countTraffic(1, 0, 0, 0, 0);
+#endif
+	return _wire->reset();
+}
+
+inline void DallasTemperature::wireSelect(const uint8_t* rom) {
+#if REQUIRESSTATS
+	countTraffic(0, 72, 0, 9, 0);
+#endif
+	_wire->select(rom);
+}
+
+inline void DallasTemperature::wireSkip(void) {
+#if REQUIRESSTATS
+	countTraffic(0, 8, 0, 1, 0);
+#endif
+	_wire->skip();
+}
+
+inline void DallasTemperature::wireWrite(uint8_t v, uint8_t power) {
+#if REQUIRESSTATS
+	countTraffic(0, 8, 0, 1, 0);
+#endif
+	_wire->write(v, power);
+}
+
+inline uint8_t DallasTemperature::wireRead(void) {
+#if REQUIRESSTATS
+	countTraffic(0, 0, 8, 1, 0);
+#endif
+	return _wire->read();
+}
+
+inline void DallasTemperature::wireWriteBit(uint8_t v) {
+#if REQUIRESSTATS
+	countTraffic(0, 1, 0, 0, 0);
+#endif
+	_wire->write_bit(v);
+}
+
+inline uint8_t DallasTemperature::wireReadBit(void) {
+#if REQUIRESSTATS
+	countTraffic(0, 0, 1, 0, 0);
+#endif
+	return _wire->read_bit();
+}
+
+// the search runs inside OneWire, a full pass of reset, command byte and
+// 64 triplets of two read and one write slots is estimated
+inline bool DallasTemperature::wireSearch(uint8_t* newAddr) {
+#if REQUIRESSTATS
+	countTraffic(1, 8 + 64, 128, 1, 0);
+#endif
+	return _wire->search(newAddr);
+}
+
+inline uint8_t DallasTemperature::wireCrc8(const uint8_t* data, uint8_t len) {
+#if REQUIRESSTATS
+	countTraffic(0, 0, 0, 0, 1);
+#endif
+	return crc8(data, len);
+}
+
+// advances the CRC8 by one byte, for checking bytes as they come off the bus
+inline uint8_t DallasTemperature::crc8Update(uint8_t crc, uint8_t data) {
+	data ^= crc;
+#if DALLAS_CRC8_NIBBLE
+	return pgm_read_byte(&crc8Low[data & 0x0F]) ^ pgm_read_byte(&crc8High[data >> 4]);
+#else
+	return pgm_read_byte(&crc8Table[data]);
+#endif
+}
+
+uint8_t DallasTemperature::crc8(const uint8_t* data, uint8_t len) {
+	uint8_t crc = 0;
+	while (len--)
+		crc = crc8Update(crc, *data++);
+	return crc;
+}
+
+
+DallasTemperature::DallasTemperature() {
+#if REQUIRESSTATIC
+	descriptors = nullptr;
+	capacity = 0;
+#else
+	descriptors = table;
+	capacity = DALLAS_MAX_DEVICES;
+#endif
+#if REQUIRESALARMS
+	setAlarmHandler(NO_ALARM_HANDLER);
+#endif
+    useExternalPullup = false;
+#if REQUIRESSTATS
+	statsDepth = 0;
+	resetStats();
+#endif
+}
+
+#if !REQUIRESSTATIC
+DallasTemperature::DallasTemperature(OneWire* _oneWire) : DallasTemperature() {
+	setOneWire(_oneWire);
+}
+#endif
+
+DallasTemperature::DallasTemperature(OneWire* _oneWire, DeviceDescriptor* table,
+		uint8_t capacity) : DallasTemperature() {
+	descriptors = table;
+	this->capacity = capacity;
+	if (_oneWire != nullptr)
+		setOneWire(_oneWire);
+}
+
+bool DallasTemperature::validFamily(const uint8_t* deviceAddress) {
+	switch (deviceAddress[DSROM_FAMILY]) {
+	case DS18S20MODEL:
+	case DS18B20MODEL:
+	case DS1822MODEL:
+	case DS1825MODEL:
+	case DS28EA00MODEL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Constructs DallasTemperature with strong pull-up turned on. Strong pull-up is mandated in DS18B20 datasheet for parasitic
+ * power (2 wires) setup. (https://datasheets.maximintegrated.com/en/ds/DS18B20.pdf, p. 7, section 'Powering the DS18B20').
+ */
+#if !REQUIRESSTATIC
+DallasTemperature::DallasTemperature(OneWire* _oneWire, uint8_t _pullupPin) : DallasTemperature(_oneWire) {
+  setPullupPin(_pullupPin);
+}
+#endif
+
+void DallasTemperature::setPullupPin(uint8_t _pullupPin) {
+	useExternalPullup = true;
+	pullupPin = _pullupPin;
+	pinMode(pullupPin, OUTPUT);
+	deactivateExternalPullup();
+}
+
+void DallasTemperature::setOneWire(OneWire* _oneWire) {
+
+	_wire = _oneWire;
+	devices = 0;
+	ds18Count = 0;
+	parasite = false;
+	bitResolution = 9;
+	waitForConversion = true;
+	checkForConversion = true;
+  autoSaveScratchPad = true;
+	fastReadInterval = 0;
+	fastReadMaxStep = DALLAS_FAST_READ_MAX_STEP;
+	pipelineRunning = false;
+
+}
+
+// initialise the bus
+// one pass over the bus fills the descriptor table: address, alarm
+// registers, resolution and power mode of every device
+void DallasTemperature::begin(void) {
+	DALLAS_STATS(DALLAS_STATS_BEGIN);
+
+	DeviceAddress deviceAddress;
+
+	// the pipeline schedule refers to the old table
+	pipelineRunning = false;
+
+	_wire->reset_search();
+	devices = 0; // Reset the number of devices when we enumerate wire devices
+	ds18Count = 0; // Reset number of DS18xxx Family devices
+
+	// a single broadcast tells whether any device needs parasite power, only
+	// then the devices are asked one by one
+	bool anyParasite = readPowerSupply();
+	parasite = false;
+
+	while (wireSearch(deviceAddress)) {
+
+		if (!validAddress(deviceAddress))
+			continue;
+
+		uint8_t index = devices++;
+		if (index < capacity) {
+			DeviceDescriptor& descriptor = descriptors[index];
+			for (uint8_t i = 0; i < 8; i++)
+				descriptor.rom[i] = deviceAddress[i];
+			descriptor.parasite = false;
+			descriptor.valid = false;
+			descriptor.converting = false;
+			descriptor.pendingResolution = 0;
+			descriptor.fastReadCount = 0;
+			descriptor.lastTemperature = DEVICE_DISCONNECTED_RAW;
+		}
+
+		if (!validFamily(deviceAddress))
+			continue;
+
+		ds18Count++;
+
+		bool deviceParasite = anyParasite && readPowerSupply(deviceAddress);
+		if (deviceParasite)
+			parasite = true;
+		if (index < capacity)
+			descriptors[index].parasite = deviceParasite;
+
+		// the next search starts with a reset, the read needs no closing one
+		ScratchPad scratchPad;
+		bool valid;
+		if (fetchScratchPad(deviceAddress, scratchPad, &valid) && valid) {
+			cacheRegisters(deviceAddress, scratchPad);
+			uint8_t b = resolutionOf(deviceAddress, scratchPad);
+			if (b > bitResolution) bitResolution = b;
+		}
+	}
+}
+
+// enumerate the bus again and rebuild the address table
+void DallasTemperature::rescan(void) {
+	begin();
+}
+
+// returns the number of devices found on the bus
+uint8_t DallasTemperature::getDeviceCount(void) {
+	return devices;
+}
+
+uint8_t DallasTemperature::getDS18Count(void) {
+	return ds18Count;
+}
+
+// returns true if address is valid
+bool DallasTemperature::validAddress(const uint8_t* deviceAddress) {
+	return (wireCrc8(deviceAddress, 7) == deviceAddress[DSROM_CRC]);
+}
+
+// finds an address at a given index on the bus
+// returns true if the device was found
+// the address table built by begin() is used, only devices beyond
+// the table or not enumerated yet cost a search of the bus
+bool DallasTemperature::getAddress(uint8_t* deviceAddress, uint8_t index) {
+	DALLAS_STATS(DALLAS_STATS_GET_ADDRESS);
+
+	if (index < devices && index < capacity) {
+		for (uint8_t i = 0; i < 8; i++)
+			deviceAddress[i] = descriptors[index].rom[i];
+		return true;
+	}
+
+	uint8_t depth = 0;
+
+	_wire->reset_search();
+
+	while (depth <= index && wireSearch(deviceAddress)) {
+		if (validAddress(deviceAddress)) {
+			if (depth == index)
+				return true;
+			depth++;
+		}
+	}
+
+	return false;
+
+}
+
+// attempt to determine if the device at the given address is connected to the bus
+bool DallasTemperature::isConnected(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_IS_CONNECTED);
+
+	ScratchPad scratchPad;
+	return isConnected(deviceAddress, scratchPad);
+
+}
+
+// attempt to determine if the device at the given address is connected to the bus
+// also allows for updating the read scratchpad
+bool DallasTemperature::isConnected(const uint8_t* deviceAddress,
+		uint8_t* scratchPad) {
+	DALLAS_STATS(DALLAS_STATS_IS_CONNECTED);
+	bool valid;
+	bool b = fetchScratchPad(deviceAddress, scratchPad, &valid);
+	b = b && (wireReset() == 1) && valid;
+	if (b && validFamily(deviceAddress))
+		cacheRegisters(deviceAddress, scratchPad);
+	return b;
+}
+
+bool DallasTemperature::readScratchPad(const uint8_t* deviceAddress,
+		uint8_t* scratchPad) {
+	DALLAS_STATS(DALLAS_STATS_READ_SCRATCHPAD);
+
+	if (!fetchScratchPad(deviceAddress, scratchPad))
+		return false;
+
+	int b = wireReset();
+	return (b == 1);
+}
+
+// reads the scratchpad and leaves the bus as is, the next command's
+// reset ends the read. valid tells whether the bytes passed the CRC,
+// which is checked as they arrive, and were not all zero.
+bool DallasTemperature::fetchScratchPad(const uint8_t* deviceAddress,
+		uint8_t* scratchPad, bool* valid) {
+
+	// send the reset command and fail fast
+	int b = wireReset();
+	if (b == 0)
+		return false;
+
+	wireSelect(deviceAddress);
+	wireWrite(READSCRATCH);
+
+	// Read all registers in a simple loop
+	// byte 0: temperature LSB
+	// byte 1: temperature MSB
+	// byte 2: high alarm temp
+	// byte 3: low alarm temp
+	// byte 4: DS18S20: store for crc
+	//         DS18B20 & DS1822: configuration register
+	// byte 5: internal use & crc
+	// byte 6: DS18S20: COUNT_REMAIN
+	//         DS18B20 & DS1822: store for crc
+	// byte 7: DS18S20: COUNT_PER_C
+	//         DS18B20 & DS1822: store for crc
+	// byte 8: SCRATCHPAD_CRC
+	// the CRC over all nine bytes is 0 when they arrived intact, a bus
+	// stuck low reads all zeros and passes the CRC too
+	uint8_t crc = 0;
+	uint8_t any = 0;
+	for (uint8_t i = 0; i < 9; i++) {
+		scratchPad[i] = wireRead();
+		crc = crc8Update(crc, scratchPad[i]);
+		any |= scratchPad[i];
+	}
+
+	if (valid != nullptr) {
+#if REQUIRESSTATS
+		countTraffic(0, 0, 0, 0, 1);
+#endif
+		*valid = crc == 0 && any != 0;
+	}
+	return true;
+}
+
+// reads the first two scratchpad bytes and aborts the read with a reset
+// saves 56 read slots per device but comes without CRC protection
+bool DallasTemperature::fetchTemperature(const uint8_t* deviceAddress,
+		uint8_t* scratchPad) {
+
+	int b = wireReset();
+	if (b == 0)
+		return false;
+
+	wireSelect(deviceAddress);
+	wireWrite(READSCRATCH);
+	scratchPad[TEMP_LSB] = wireRead();
+	scratchPad[TEMP_MSB] = wireRead();
+
+	b = wireReset();
+
+	// a released bus reads all ones
+	return (b == 1) && !(scratchPad[TEMP_LSB] == 0xFF && scratchPad[TEMP_MSB] == 0xFF);
+}
+
+void DallasTemperature::writeScratchPad(const uint8_t* deviceAddress,
+		const uint8_t* scratchPad, bool saveToEeprom) {
+	DALLAS_STATS(DALLAS_STATS_WRITE_SCRATCHPAD);
+
+	// keep the cached registers in step, forget them if nobody answered
+	if (wireReset())
+		cacheRegisters(deviceAddress, scratchPad);
+	else
+		invalidateCache(deviceAddress);
+	wireSelect(deviceAddress);
+	wireWrite(WRITESCRATCH);
+	wireWrite(scratchPad[HIGH_ALARM_TEMP]); // high alarm temp
+	wireWrite(scratchPad[LOW_ALARM_TEMP]); // low alarm temp
+
+	// DS1820 and DS18S20 have no configuration register
+	if (deviceAddress[DSROM_FAMILY] != DS18S20MODEL)
+		wireWrite(scratchPad[CONFIGURATION]);
+
+  if (autoSaveScratchPad && saveToEeprom)
+    saveScratchPad(deviceAddress);
+  else
+    wireReset();
+}
+
+// returns true if parasite mode is used (2 wire)
+// returns false if normal mode is used (3 wire)
+// if no address is given (or nullptr) it checks if any device on the bus
+// uses parasite mode.
+// See issue #145
+bool DallasTemperature::readPowerSupply(const uint8_t* deviceAddress)
+{
+	DALLAS_STATS(DALLAS_STATS_READ_POWER_SUPPLY);
+	bool parasiteMode = false;
+	wireReset();
+	if (deviceAddress == nullptr)
+		wireSkip();
+	else
+		wireSelect(deviceAddress);
+
+	wireWrite(READPOWERSUPPLY);
+	if (wireReadBit() == 0)
+		parasiteMode = true;
+	wireReset();
+	return parasiteMode;
+}
+
+// set resolution of all devices to 9, 10, 11, or 12 bits
+// if new resolution is out of range, it is constrained.
+// Only devices whose cached configuration differs are written. When all
+// devices share their alarm registers one broadcast write updates the bus.
+void DallasTemperature::setResolution(uint8_t newResolution, bool saveToEeprom) {
+	DALLAS_STATS(DALLAS_STATS_SET_RESOLUTION);
+
+	newResolution = constrain(newResolution, 9, 12);
+
+	if (!broadcastResolution(newResolution, saveToEeprom)) {
+		DeviceAddress deviceAddress;
+		for (uint8_t i = 0; i < devices; i++) {
+			if (getAddress(deviceAddress, i) && validFamily(deviceAddress))
+				setResolution(deviceAddress, newResolution, true, saveToEeprom);
+		}
+	}
+
+	updateBitResolution(newResolution);
+}
+
+// set resolution of a device to 9, 10, 11, or 12 bits
+// if new resolution is out of range, it is constrained.
+// a device cached by begin() is written from the cache without reading it
+bool DallasTemperature::setResolution(const uint8_t* deviceAddress,
+                                      uint8_t newResolution, bool skipGlobalBitResolutionCalculation,
+                                      bool saveToEeprom) {
+  DALLAS_STATS(DALLAS_STATS_SET_RESOLUTION);
+
+  bool success = false;
+  newResolution = constrain(newResolution, 9, 12);
+
+  // the pipeline waits for a conversion by the resolution it started at,
+  // a change would have the device read before it is done
+  uint8_t index = pipelineRunning ? findDevice(deviceAddress) : capacity;
+
+  // DS1820 and DS18S20 have no resolution configuration register
+  if (deviceAddress[DSROM_FAMILY] == DS18S20MODEL)
+  {
+    success = true;
+  }
+  else if (index < capacity && descriptors[index].converting)
+  {
+    descriptors[index].pendingResolution = newResolution;
+    descriptors[index].pendingSave = saveToEeprom;
+    success = true;
+  }
+  else
+  {
+    // handle the sensors with configuration register
+    uint8_t newValue = configurationFor(newResolution);
+    ScratchPad scratchPad;
+
+    // we can only update the sensor if it is connected
+    success = loadRegisters(deviceAddress, scratchPad);
+
+    // if it needs to be updated we write the new value
+    if (success && scratchPad[CONFIGURATION] != newValue)
+    {
+      scratchPad[CONFIGURATION] = newValue;
+      writeScratchPad(deviceAddress, scratchPad, saveToEeprom);
+    }
+  }
+
+  // do we need to update the max resolution used?
+  if (skipGlobalBitResolutionCalculation == false)
+    updateBitResolution(newResolution);
+
+  return success;
+}
+
+// writes the resolution to all devices at once with SKIP ROM. Possible
+// when every device is a cached DS18xxx and all hold the same alarm
+// registers, so that the broadcast changes nothing else. The broadcast
+// copy to EEPROM reaches every device, so with saveToEeprom it is only
+// used when every device changes. Returns false when the devices have to
+// be written one by one.
+bool DallasTemperature::broadcastResolution(uint8_t newResolution, bool saveToEeprom) {
+
+	if (devices < 2 || devices > capacity || ds18Count != devices)
+		return false;
+
+	// devices of the pipeline are written one by one, between conversions
+	if (pipelineRunning)
+		return false;
+
+	bool copy = autoSaveScratchPad && saveToEeprom;
+	uint8_t pending = 0;
+	for (uint8_t i = 0; i < devices; i++) {
+		const DeviceDescriptor& descriptor = descriptors[i];
+		if (!descriptor.valid || descriptor.highAlarm != descriptors[0].highAlarm
+				|| descriptor.lowAlarm != descriptors[0].lowAlarm)
+			return false;
+		// a DS18S20 takes only the alarm registers and ignores the rest
+		if (descriptor.rom[DSROM_FAMILY] != DS18S20MODEL
+				&& descriptor.resolution != newResolution)
+			pending++;
+	}
+
+	// nothing to write
+	if (pending == 0)
+		return true;
+
+	// a copy would wear the EEPROM of devices that need no change
+	if (copy && pending != devices)
+		return false;
+
+	if (wireReset() == 0)
+		return false;
+	wireSkip();
+	wireWrite(WRITESCRATCH);
+	wireWrite(descriptors[0].highAlarm);
+	wireWrite(descriptors[0].lowAlarm);
+	wireWrite(configurationFor(newResolution));
+
+	if (copy)
+		saveScratchPad();
+	else
+		wireReset();
+
+	for (uint8_t i = 0; i < devices; i++) {
+		if (descriptors[i].rom[DSROM_FAMILY] != DS18S20MODEL)
+			descriptors[i].resolution = newResolution;
+	}
+
+	return true;
+}
+
+// the global resolution is the highest of all devices, at least minimum
+void DallasTemperature::updateBitResolution(uint8_t minimum) {
+
+	bitResolution = minimum;
+	for (uint8_t i = 0; i < devices; i++) {
+		if (bitResolution == 12)
+			break;
+
+		DeviceAddress deviceAddress;
+		if (!getAddress(deviceAddress, i) || !validFamily(deviceAddress))
+			continue;
+		uint8_t b = getResolution(deviceAddress);
+		if (b > bitResolution) bitResolution = b;
+	}
+}
+
+// position of a device in the descriptor table built by begin()
+// returns capacity if it isn't there
+uint8_t DallasTemperature::findDevice(const uint8_t* deviceAddress) {
+
+	for (uint8_t i = 0; i < devices && i < capacity; i++) {
+		uint8_t j = 0;
+		while (j < 8 && descriptors[i].rom[j] == deviceAddress[j])
+			j++;
+		if (j == 8)
+			return i;
+	}
+	return capacity;
+}
+
+// remembers the alarm registers and resolution of a device in the table
+void DallasTemperature::cacheRegisters(const uint8_t* deviceAddress,
+		const uint8_t* scratchPad) {
+
+	uint8_t index = findDevice(deviceAddress);
+	if (index == capacity)
+		return;
+
+	DeviceDescriptor& descriptor = descriptors[index];
+	descriptor.highAlarm = scratchPad[HIGH_ALARM_TEMP];
+	descriptor.lowAlarm = scratchPad[LOW_ALARM_TEMP];
+	descriptor.resolution = resolutionOf(deviceAddress, scratchPad);
+	descriptor.valid = true;
+}
+
+// the registers a scratchpad write needs, from the table when cached
+// returns false if the device didn't answer
+bool DallasTemperature::loadRegisters(const uint8_t* deviceAddress,
+		uint8_t* scratchPad) {
+
+	uint8_t index = findDevice(deviceAddress);
+	if (index == capacity || !descriptors[index].valid)
+		return isConnected(deviceAddress, scratchPad);
+
+	const DeviceDescriptor& descriptor = descriptors[index];
+	scratchPad[HIGH_ALARM_TEMP] = descriptor.highAlarm;
+	scratchPad[LOW_ALARM_TEMP] = descriptor.lowAlarm;
+	scratchPad[CONFIGURATION] = configurationFor(descriptor.resolution);
+	return true;
+}
+
+// forgets the cached registers of a device, or of all devices for nullptr
+void DallasTemperature::invalidateCache(const uint8_t* deviceAddress) {
+
+	for (uint8_t i = 0; i < devices && i < capacity; i++) {
+		if (deviceAddress == nullptr || findDevice(deviceAddress) == i)
+			descriptors[i].valid = false;
+	}
+}
+
+// resolution of a device from its scratchpad
+uint8_t DallasTemperature::resolutionOf(const uint8_t* deviceAddress,
+		const uint8_t* scratchPad) {
+	// DS1820 and DS18S20 have no resolution configuration register
+	if (deviceAddress[DSROM_FAMILY] == DS18S20MODEL)
+		return 12;
+	return resolutionFor(scratchPad[CONFIGURATION]);
+}
+
+// configuration register value for a resolution of 9 to 12 bits
+uint8_t DallasTemperature::configurationFor(uint8_t resolution) {
+	switch (resolution) {
+	case 12:
+		return TEMP_12_BIT;
+	case 11:
+		return TEMP_11_BIT;
+	case 10:
+		return TEMP_10_BIT;
+	case 9:
+	default:
+		return TEMP_9_BIT;
+	}
+}
+
+// resolution of a configuration register value, 0 if it isn't valid
+uint8_t DallasTemperature::resolutionFor(uint8_t configuration) {
+	switch (configuration) {
+	case TEMP_12_BIT:
+		return 12;
+	case TEMP_11_BIT:
+		return 11;
+	case TEMP_10_BIT:
+		return 10;
+	case TEMP_9_BIT:
+		return 9;
+	default:
+		return 0;
+	}
+}
+
+
+// returns the global resolution
+uint8_t DallasTemperature::getResolution() {
+	return bitResolution;
+}
+
+// returns the current resolution of the device, 9-12
+// returns 0 if device not found
+uint8_t DallasTemperature::getResolution(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_GET_RESOLUTION);
+
+	// DS1820 and DS18S20 have no resolution configuration register
+	if (deviceAddress[DSROM_FAMILY] == DS18S20MODEL)
+		return 12;
+
+	uint8_t index = findDevice(deviceAddress);
+	if (index < capacity && descriptors[index].valid)
+		return descriptors[index].resolution;
+
+	ScratchPad scratchPad;
+	if (isConnected(deviceAddress, scratchPad))
+		return resolutionFor(scratchPad[CONFIGURATION]);
+	return 0;
+
+}
+
+
+// sets the value of the waitForConversion flag
+// TRUE : function requestTemperature() etc returns when conversion is ready
+// FALSE: function requestTemperature() etc returns immediately (USE WITH CARE!!)
+//        (1) programmer has to check if the needed delay has passed
+//        (2) but the application can do meaningful things in that time
+void DallasTemperature::setWaitForConversion(bool flag) {
+	waitForConversion = flag;
+}
+
+// gets the value of the waitForConversion flag
+bool DallasTemperature::getWaitForConversion() {
+	return waitForConversion;
+}
+
+// sets the value of the checkForConversion flag
+// TRUE : function requestTemperature() etc will 'listen' to an IC to determine whether a conversion is complete
+// FALSE: function requestTemperature() etc will wait a set time (worst case scenario) for a conversion to complete
+void DallasTemperature::setCheckForConversion(bool flag) {
+	checkForConversion = flag;
+}
+
+// gets the value of the waitForConversion flag
+bool DallasTemperature::getCheckForConversion() {
+	return checkForConversion;
+}
+
+bool DallasTemperature::isConversionComplete() {
+	DALLAS_STATS(DALLAS_STATS_CONVERSION_COMPLETE);
+	uint8_t b = wireReadBit();
+	return (b == 1);
+}
+
+// sends command for all devices on the bus to perform a temperature conversion
+void DallasTemperature::requestTemperatures() {
+	DALLAS_STATS(DALLAS_STATS_REQUEST_TEMPERATURES);
+
+	wireReset();
+	wireSkip();
+	wireWrite(STARTCONVO, parasite);
+
+	// ASYNC mode?
+	if (!waitForConversion)
+		return;
+	blockTillConversionComplete(bitResolution);
+
+}
+
+// sends command for one device to perform a temperature by address
+// returns FALSE if device is disconnected
+// returns TRUE  otherwise
+bool DallasTemperature::requestTemperaturesByAddress(
+		const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_REQUEST_BY_ADDRESS);
+
+	uint8_t bitResolution = getResolution(deviceAddress);
+	if (bitResolution == 0) {
+		return false; //Device disconnected
+	}
+
+	wireReset();
+	wireSelect(deviceAddress);
+	wireWrite(STARTCONVO, parasite);
+
+	// ASYNC mode?
+	if (!waitForConversion)
+		return true;
+
+	blockTillConversionComplete(bitResolution);
+
+	return true;
+
+}
+
+// Continue to check if the IC has responded with a temperature
+void DallasTemperature::blockTillConversionComplete(uint8_t bitResolution) {
+  DALLAS_STATS(DALLAS_STATS_CONVERSION_COMPLETE);
+
+  if (checkForConversion && !parasite) {
+    unsigned long start = millis();
+    while (!isConversionComplete() && (millis() - start < MAX_CONVERSION_TIMEOUT ))
+      yield();
+  } else {
+    unsigned long delms = millisToWaitForConversion(bitResolution);
+    activateExternalPullup();
+    delay(delms);
+    deactivateExternalPullup();
+  }
+
+}
+
+// returns number of milliseconds to wait till conversion is complete (based on IC datasheet)
+uint16_t DallasTemperature::millisToWaitForConversion(uint8_t bitResolution) {
+
+	switch (bitResolution) {
+	case 9:
+		return 94;
+	case 10:
+		return 188;
+	case 11:
+		return 375;
+	default:
+		return 750;
+	}
+
+}
+
+// returns number of milliseconds to wait till conversion is complete (based on IC datasheet)
+uint16_t DallasTemperature::millisToWaitForConversion() {
+  return millisToWaitForConversion(bitResolution);
+}
+
+// Sends command to one device to save values from scratchpad to EEPROM by index
+// Returns true if no errors were encountered, false indicates failure
+bool DallasTemperature::saveScratchPadByIndex(uint8_t deviceIndex) {
+  DALLAS_STATS(DALLAS_STATS_SAVE_SCRATCHPAD);
+  
+  DeviceAddress deviceAddress;
+  if (!getAddress(deviceAddress, deviceIndex)) return false;
+  
+  return saveScratchPad(deviceAddress);
+  
+}
+
+// Sends command to one or more devices to save values from scratchpad to EEPROM
+// If optional argument deviceAddress is omitted the command is send to all devices
+// Returns true if no errors were encountered, false indicates failure
+bool DallasTemperature::saveScratchPad(const uint8_t* deviceAddress) {
+  DALLAS_STATS(DALLAS_STATS_SAVE_SCRATCHPAD);
+  
+  if (wireReset() == 0)
+    return false;
+  
+  if (deviceAddress == nullptr)
+    wireSkip();
+  else
+    wireSelect(deviceAddress);
+  
+  wireWrite(COPYSCRATCH,parasite);
+
+  // Specification: NV Write Cycle Time is typically 2ms, max 10ms
+  // Waiting 20ms to allow for sensors that take longer in practice
+  if (!parasite) {
+    delay(20);
+  } else {
+    activateExternalPullup();
+    delay(20);
+    deactivateExternalPullup();
+  }
+  
+  return wireReset() == 1;
+  
+}
+
+// Sends command to one device to recall values from EEPROM to scratchpad by index
+// Returns true if no errors were encountered, false indicates failure
+bool DallasTemperature::recallScratchPadByIndex(uint8_t deviceIndex) {
+  DALLAS_STATS(DALLAS_STATS_RECALL_SCRATCHPAD);
+
+  DeviceAddress deviceAddress;
+  if (!getAddress(deviceAddress, deviceIndex)) return false;
+  
+  return recallScratchPad(deviceAddress);
+
+}
+
+// Sends command to one or more devices to recall values from EEPROM to scratchpad
+// If optional argument deviceAddress is omitted the command is send to all devices
+// Returns true if no errors were encountered, false indicates failure
+bool DallasTemperature::recallScratchPad(const uint8_t* deviceAddress) {
+  DALLAS_STATS(DALLAS_STATS_RECALL_SCRATCHPAD);
+  
+  if (wireReset() == 0)
+    return false;
+  
+  if (deviceAddress == nullptr)
+    wireSkip();
+  else
+    wireSelect(deviceAddress);
+  
+  wireWrite(RECALLSCRATCH,parasite);
+
+  // the registers now hold the EEPROM values
+  invalidateCache(deviceAddress);
+
+  // Specification: Strong pullup only needed when writing to EEPROM (and temp conversion)
+  unsigned long start = millis();
+  while (wireReadBit() == 0) {
+    // Datasheet doesn't specify typical/max duration, testing reveals typically within 1ms
+    if (millis() - start > 20) return false;
+    yield();
+  }
+  
+  return wireReset() == 1;
+  
+}
+
+// Sets the autoSaveScratchPad flag
+void DallasTemperature::setAutoSaveScratchPad(bool flag) {
+  autoSaveScratchPad = flag;
+}
+
+// Gets the autoSaveScratchPad flag
+bool DallasTemperature::getAutoSaveScratchPad() {
+  return autoSaveScratchPad;
+}
+
+void DallasTemperature::activateExternalPullup() {
+	if(useExternalPullup)
+		digitalWrite(pullupPin, LOW);
+}
+
+void DallasTemperature::deactivateExternalPullup() {
+	if(useExternalPullup)
+		digitalWrite(pullupPin, HIGH);
+}
+
+// sends command for one device to perform a temp conversion by index
+bool DallasTemperature::requestTemperaturesByIndex(uint8_t deviceIndex) {
+	DALLAS_STATS(DALLAS_STATS_REQUEST_BY_ADDRESS);
+
+	DeviceAddress deviceAddress;
+	if (!getAddress(deviceAddress, deviceIndex))
+		return false;
+
+	return requestTemperaturesByAddress(deviceAddress);
+
+}
+
+// Fetch temperature for device index
+float DallasTemperature::getTempCByIndex(uint8_t deviceIndex) {
+	DALLAS_STATS(DALLAS_STATS_GET_TEMP);
+
+	DeviceAddress deviceAddress;
+	if (!getAddress(deviceAddress, deviceIndex)) {
+		return DEVICE_DISCONNECTED_C;
+	}
+	return getTempC((uint8_t*) deviceAddress);
+}
+
+// Fetch temperature for device index
+float DallasTemperature::getTempFByIndex(uint8_t deviceIndex) {
+	DALLAS_STATS(DALLAS_STATS_GET_TEMP);
+
+	DeviceAddress deviceAddress;
+
+	if (!getAddress(deviceAddress, deviceIndex)) {
+		return DEVICE_DISCONNECTED_F;
+	}
+
+	return getTempF((uint8_t*) deviceAddress);
+
+}
+
+// reads the temperature of all cached devices after a requestTemperatures()
+// each device costs one reset, one select and 9 bytes: the reset of the next
+// read terminates the previous one and the pad is CRC checked once.
+// returns the number of valid readings
+uint8_t DallasTemperature::readAllTemperatures(int16_t* temperatures,
+		bool* valid, uint8_t count) {
+	DALLAS_STATS(DALLAS_STATS_READ_ALL);
+
+	uint8_t cached = devices < capacity ? devices : capacity;
+	if (count > cached)
+		count = cached;
+
+	uint8_t good = 0;
+
+	for (uint8_t i = 0; i < count; i++) {
+		bool ok = readTemperature(i, &temperatures[i]);
+		if (valid != nullptr)
+			valid[i] = ok;
+		if (ok)
+			good++;
+	}
+
+	return good;
+}
+
+// reads the temperature of cached device index, fast or full as the fast
+// read policy decides
+bool DallasTemperature::readTemperature(uint8_t index, int16_t* temperature) {
+
+	const uint8_t* deviceAddress = descriptors[index].rom;
+	ScratchPad scratchPad;
+	bool ok = false;
+
+	if (!validFamily(deviceAddress)) {
+		*temperature = DEVICE_DISCONNECTED_RAW;
+		return false;
+	}
+
+	// DS18S20 needs COUNT_REMAIN and COUNT_PER_C for its extended resolution
+	// and a device without a trusted previous value can't be checked for jumps
+	bool full = fastReadInterval <= 1
+			|| deviceAddress[DSROM_FAMILY] == DS18S20MODEL
+			|| descriptors[index].lastTemperature == DEVICE_DISCONNECTED_RAW
+			|| ++descriptors[index].fastReadCount >= fastReadInterval;
+
+	if (!full) {
+		if (fetchTemperature(deviceAddress, scratchPad)) {
+			int16_t fast = calculateTemperature(deviceAddress, scratchPad);
+			int32_t step = (int32_t) fast - descriptors[index].lastTemperature;
+			if (step <= fastReadMaxStep && step >= -fastReadMaxStep) {
+				*temperature = fast;
+				ok = true;
+			}
+		}
+		// implausible or failed, confirm with a full read right away
+		full = !ok;
+	}
+
+	if (full) {
+		descriptors[index].fastReadCount = 0;
+		bool valid;
+		ok = fetchScratchPad(deviceAddress, scratchPad, &valid) && valid;
+		*temperature = ok ? calculateTemperature(deviceAddress, scratchPad)
+				: DEVICE_DISCONNECTED_RAW;
+	}
+
+	descriptors[index].lastTemperature = *temperature;
+	return ok;
+}
+
+// starts pipelined conversions, every device is started and read on its
+// own schedule. A parasite powered device needs the strong pullup for the
+// whole conversion, which leaves no room for other traffic, so the
+// pipeline runs on externally powered buses only.
+bool DallasTemperature::startPipeline(void) {
+
+	if (parasite || devices == 0)
+		return false;
+
+	for (uint8_t i = 0; i < capacity; i++)
+		descriptors[i].converting = false;
+	pipelineRunning = true;
+	return true;
+}
+
+// nobody reads the conversions still running, resolutions set meanwhile
+// are written now
+void DallasTemperature::stopPipeline(void) {
+	uint8_t count = devices < capacity ? devices : capacity;
+	for (uint8_t i = 0; i < count; i++)
+		finishConversion(i);
+	pipelineRunning = false;
+}
+
+bool DallasTemperature::isPipelineRunning(void) {
+	return pipelineRunning;
+}
+
+// advances the pipeline. The device whose conversion has been done the
+// longest is read and started again at once, so it idles as little as
+// possible. Otherwise a device that isn't converting yet is started.
+// Returns true when a sample was read.
+bool DallasTemperature::pollPipeline(uint8_t* index, int16_t* temperature) {
+	DALLAS_STATS(DALLAS_STATS_PIPELINE);
+
+	if (!pipelineRunning)
+		return false;
+
+	uint8_t count = devices < capacity ? devices : capacity;
+	unsigned long now = millis();
+
+	uint8_t ready = capacity;
+	unsigned long overdue = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		if (!descriptors[i].converting)
+			continue;
+		// unknown resolution waits as long as 12 bits
+		uint8_t resolution = descriptors[i].valid ? descriptors[i].resolution : 12;
+		unsigned long elapsed = now - descriptors[i].conversionStart;
+		unsigned long wait = millisToWaitForConversion(resolution);
+		if (elapsed >= wait && (ready == capacity || elapsed - wait > overdue)) {
+			ready = i;
+			overdue = elapsed - wait;
+		}
+	}
+
+	if (ready < capacity) {
+		*index = ready;
+		readTemperature(ready, temperature);
+		finishConversion(ready);
+		startConversion(ready);
+		return true;
+	}
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (!descriptors[i].converting && validFamily(descriptors[i].rom)) {
+			startConversion(i);
+			break;
+		}
+	}
+
+	return false;
+}
+
+// starts the conversion of one device of the pipeline
+void DallasTemperature::startConversion(uint8_t index) {
+	wireReset();
+	wireSelect(descriptors[index].rom);
+	wireWrite(STARTCONVO);
+	descriptors[index].converting = true;
+	descriptors[index].conversionStart = millis();
+}
+
+void DallasTemperature::finishConversion(uint8_t index) {
+	DeviceDescriptor& descriptor = descriptors[index];
+	descriptor.converting = false;
+	if (descriptor.pendingResolution != 0) {
+		uint8_t resolution = descriptor.pendingResolution;
+		descriptor.pendingResolution = 0;
+		setResolution(descriptor.rom, resolution, true, descriptor.pendingSave);
+	}
+}
+
+// sets the fast read policy of readAllTemperatures()
+void DallasTemperature::setFastRead(uint8_t interval, int16_t maxStep) {
+	fastReadInterval = interval;
+	fastReadMaxStep = maxStep < 0 ? -maxStep : maxStep;
+}
+
+uint8_t DallasTemperature::getFastReadInterval(void) {
+	return fastReadInterval;
+}
+
+// reads scratchpad and returns fixed-point temperature, scaling factor 2^-7
+int16_t DallasTemperature::calculateTemperature(const uint8_t* deviceAddress,
+		uint8_t* scratchPad) {
+
+	int16_t fpTemperature = (((int16_t) scratchPad[TEMP_MSB]) << 11)
+			| (((int16_t) scratchPad[TEMP_LSB]) << 3);
+
+	/*
+	 DS1820 and DS18S20 have a 9-bit temperature register.
+
+	 Resolutions greater than 9-bit can be calculated using the data from
+	 the temperature, and COUNT REMAIN and COUNT PER °C registers in the
+	 scratchpad.  The resolution of the calculation depends on the model.
+
+	 While the COUNT PER °C register is hard-wired to 16 (10h) in a
+	 DS18S20, it changes with temperature in DS1820.
+
+	 After reading the scratchpad, the TEMP_READ value is obtained by
+	 truncating the 0.5°C bit (bit 0) from the temperature data. The
+	 extended resolution temperature can then be calculated using the
+	 following equation:
+
+	                                  COUNT_PER_C - COUNT_REMAIN
+	 TEMPERATURE = TEMP_READ - 0.25 + --------------------------
+	                                         COUNT_PER_C
+
+	 Hagai Shatz simplified this to integer arithmetic for a 12 bits
+	 value for a DS18S20, and James Cameron added legacy DS1820 support.
+
+	 See - http://myarduinotoy.blogspot.co.uk/2013/02/12bit-result-from-ds18s20.html
+	 */
+
+	if ((deviceAddress[DSROM_FAMILY] == DS18S20MODEL) && (scratchPad[COUNT_PER_C] != 0)) {
+		fpTemperature = ((fpTemperature & 0xfff0) << 3) - 32
+				+ (((scratchPad[COUNT_PER_C] - scratchPad[COUNT_REMAIN]) << 7)
+						/ scratchPad[COUNT_PER_C]);
+	}
+
+	return fpTemperature;
+}
+
+// returns temperature in 1/128 degrees C or DEVICE_DISCONNECTED_RAW if the
+// device's scratch pad cannot be read successfully.
+// the numeric value of DEVICE_DISCONNECTED_RAW is defined in
+// DallasTemperature.h. It is a large negative number outside the
+// operating range of the device
+int16_t DallasTemperature::getTemp(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_GET_TEMP);
+
+	ScratchPad scratchPad;
+	if (isConnected(deviceAddress, scratchPad))
+		return calculateTemperature(deviceAddress, scratchPad);
+	return DEVICE_DISCONNECTED_RAW;
+
+}
+
+// returns temperature in degrees C or DEVICE_DISCONNECTED_C if the
+// device's scratch pad cannot be read successfully.
+// the numeric value of DEVICE_DISCONNECTED_C is defined in
+// DallasTemperature.h. It is a large negative number outside the
+// operating range of the device
+float DallasTemperature::getTempC(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_GET_TEMP);
+	return rawToCelsius(getTemp(deviceAddress));
+}
+
+// returns temperature in degrees F or DEVICE_DISCONNECTED_F if the
+// device's scratch pad cannot be read successfully.
+// the numeric value of DEVICE_DISCONNECTED_F is defined in
+// DallasTemperature.h. It is a large negative number outside the
+// operating range of the device
+float DallasTemperature::getTempF(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_GET_TEMP);
+	return rawToFahrenheit(getTemp(deviceAddress));
+}
+
+// returns true if the bus requires parasite power
+bool DallasTemperature::isParasitePowerMode(void) {
+	return parasite;
+}
+
+// returns true if the device needs parasite power
+bool DallasTemperature::isParasitePowerMode(const uint8_t* deviceAddress) {
+	uint8_t index = findDevice(deviceAddress);
+	if (index < capacity)
+		return descriptors[index].parasite;
+	return readPowerSupply(deviceAddress);
+}
+
+// IF alarm is not used one can store a 16 bit int of userdata in the alarm
+// registers. E.g. an ID of the sensor.
+// See github issue #29
+
+// note if device is not connected it will fail writing the data.
+void DallasTemperature::setUserData(const uint8_t* deviceAddress,
+		int16_t data) {
+	DALLAS_STATS(DALLAS_STATS_USER_DATA);
+	// return when stored value == new value
+	if (getUserData(deviceAddress) == data)
+		return;
+
+	ScratchPad scratchPad;
+	if (loadRegisters(deviceAddress, scratchPad)) {
+		scratchPad[HIGH_ALARM_TEMP] = data >> 8;
+		scratchPad[LOW_ALARM_TEMP] = data & 255;
+		writeScratchPad(deviceAddress, scratchPad);
+	}
+}
+
+int16_t DallasTemperature::getUserData(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_USER_DATA);
+	int16_t data = 0;
+	ScratchPad scratchPad;
+	if (loadRegisters(deviceAddress, scratchPad)) {
+		data = scratchPad[HIGH_ALARM_TEMP] << 8;
+		data += scratchPad[LOW_ALARM_TEMP];
+	}
+	return data;
+}
+
+// note If address cannot be found no error will be reported.
+int16_t DallasTemperature::getUserDataByIndex(uint8_t deviceIndex) {
+	DALLAS_STATS(DALLAS_STATS_USER_DATA);
+	DeviceAddress deviceAddress;
+	if (!getAddress(deviceAddress, deviceIndex))
+		return 0;
+	return getUserData((uint8_t*) deviceAddress);
+}
+
+void DallasTemperature::setUserDataByIndex(uint8_t deviceIndex, int16_t data) {
+	DALLAS_STATS(DALLAS_STATS_USER_DATA);
+	DeviceAddress deviceAddress;
+	if (!getAddress(deviceAddress, deviceIndex))
+		return;
+	setUserData((uint8_t*) deviceAddress, data);
+}
+
+// Convert float Celsius to Fahrenheit
+float DallasTemperature::toFahrenheit(float celsius) {
+	return (celsius * 1.8f) + 32.0f;
+}
+
+// Convert float Fahrenheit to Celsius
+float DallasTemperature::toCelsius(float fahrenheit) {
+	return (fahrenheit - 32.0f) * 0.555555556f;
+}
+
+// convert from raw to Celsius
+float DallasTemperature::rawToCelsius(int16_t raw) {
+
+	if (raw <= DEVICE_DISCONNECTED_RAW)
+		return DEVICE_DISCONNECTED_C;
+	// C = RAW/128
+	return (float) raw * 0.0078125f;
+
+}
+
+// Convert from Celsius to raw returns temperature in raw integer format.
+// The rounding error in the conversion is smaller than 0.01°C
+// where the resolution of the sensor is at best 0.0625°C (in 12 bit mode).
+// Rounding error can be verified by running:
+//  for (float t=-55.; t<125.; t+=0.01)
+//  {
+//    Serial.println( DallasTemperature::rawToCelsius(DallasTemperature::celsiusToRaw(t))-t, 4 );
+//  }
+int16_t DallasTemperature::celsiusToRaw(float celsius) {
+
+    return static_cast<uint16_t>( celsius * 128.f );
+}
+
+// convert from raw to Fahrenheit
+float DallasTemperature::rawToFahrenheit(int16_t raw) {
+
+	if (raw <= DEVICE_DISCONNECTED_RAW)
+		return DEVICE_DISCONNECTED_F;
+	// C = RAW/128
+	// F = (C*1.8)+32 = (RAW/128*1.8)+32 = (RAW*0.0140625)+32
+	return ((float) raw * 0.0140625f) + 32.0f;
+
+}
+
+#if REQUIRESALARMS
+
+/*
+
+ ALARMS:
+
+ TH and TL Register Format
+
+ BIT 7 BIT 6 BIT 5 BIT 4 BIT 3 BIT 2 BIT 1 BIT 0
+ S    2^6   2^5   2^4   2^3   2^2   2^1   2^0
+
+ Only bits 11 through 4 of the temperature register are used
+ in the TH and TL comparison since TH and TL are 8-bit
+ registers. If the measured temperature is lower than or equal
+ to TL or higher than or equal to TH, an alarm condition exists
+ and an alarm flag is set inside the DS18B20. This flag is
+ updated after every temperature measurement; therefore, if the
+ alarm condition goes away, the flag will be turned off after
+ the next temperature conversion.
+
+ */
+
+// sets the high alarm temperature for a device in degrees Celsius
+// accepts a float, but the alarm resolution will ignore anything
+// after a decimal point.  valid range is -55C - 125C
+void DallasTemperature::setHighAlarmTemp(const uint8_t* deviceAddress,
+		int8_t celsius) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_TEMP);
+
+	// return when stored value == new value
+	if (getHighAlarmTemp(deviceAddress) == celsius)
+		return;
+
+	// make sure the alarm temperature is within the device's range
+	if (celsius > 125)
+		celsius = 125;
+	else if (celsius < -55)
+		celsius = -55;
+
+	ScratchPad scratchPad;
+	if (loadRegisters(deviceAddress, scratchPad)) {
+		scratchPad[HIGH_ALARM_TEMP] = (uint8_t) celsius;
+		writeScratchPad(deviceAddress, scratchPad);
+	}
+
+}
+
+// sets the low alarm temperature for a device in degrees Celsius
+// accepts a float, but the alarm resolution will ignore anything
+// after a decimal point.  valid range is -55C - 125C
+void DallasTemperature::setLowAlarmTemp(const uint8_t* deviceAddress,
+		int8_t celsius) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_TEMP);
+
+	// return when stored value == new value
+	if (getLowAlarmTemp(deviceAddress) == celsius)
+		return;
+
+	// make sure the alarm temperature is within the device's range
+	if (celsius > 125)
+		celsius = 125;
+	else if (celsius < -55)
+		celsius = -55;
+
+	ScratchPad scratchPad;
+	if (loadRegisters(deviceAddress, scratchPad)) {
+		scratchPad[LOW_ALARM_TEMP] = (uint8_t) celsius;
+		writeScratchPad(deviceAddress, scratchPad);
+	}
+
+}
+
+// sets both alarm temperatures of a device with a single scratchpad write
+// valid range is -55C - 125C, nothing is written when they are unchanged.
+// Unlike setHighAlarmTemp() and setLowAlarmTemp() the EEPROM copy is only
+// made on request, so a device can be re-armed often.
+// returns false if the device didn't answer
+bool DallasTemperature::setAlarmWindow(const uint8_t* deviceAddress,
+		int8_t low, int8_t high, bool saveToEeprom) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_TEMP);
+
+	// make sure the alarm temperatures are within the device's range
+	low = constrain(low, -55, 125);
+	high = constrain(high, -55, 125);
+
+	ScratchPad scratchPad;
+	if (!loadRegisters(deviceAddress, scratchPad))
+		return false;
+
+	if ((int8_t) scratchPad[LOW_ALARM_TEMP] == low
+			&& (int8_t) scratchPad[HIGH_ALARM_TEMP] == high)
+		return true;
+
+	scratchPad[HIGH_ALARM_TEMP] = (uint8_t) high;
+	scratchPad[LOW_ALARM_TEMP] = (uint8_t) low;
+	writeScratchPad(deviceAddress, scratchPad, saveToEeprom);
+	return true;
+}
+
+// returns a int8_t with the current high alarm temperature or
+// DEVICE_DISCONNECTED for an address
+int8_t DallasTemperature::getHighAlarmTemp(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_TEMP);
+
+	ScratchPad scratchPad;
+	if (loadRegisters(deviceAddress, scratchPad))
+		return (int8_t) scratchPad[HIGH_ALARM_TEMP];
+	return DEVICE_DISCONNECTED_C;
+
+}
+
+// returns a int8_t with the current low alarm temperature or
+// DEVICE_DISCONNECTED for an address
+int8_t DallasTemperature::getLowAlarmTemp(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_TEMP);
+
+	ScratchPad scratchPad;
+	if (loadRegisters(deviceAddress, scratchPad))
+		return (int8_t) scratchPad[LOW_ALARM_TEMP];
+	return DEVICE_DISCONNECTED_C;
+
+}
+
+// resets internal variables used for the alarm search
+void DallasTemperature::resetAlarmSearch() {
+
+	alarmSearchJunction = -1;
+	alarmSearchExhausted = 0;
+	for (uint8_t i = 0; i < 7; i++) {
+		alarmSearchAddress[i] = 0;
+	}
+
+}
+
+// This is a modified version of the OneWire::search method.
+//
+// Also added the OneWire search fix documented here:
+// http://www.arduino.cc/cgi-bin/yabb2/YaBB.pl?num=1238032295
+//
+// Perform an alarm search. If this function returns a '1' then it has
+// enumerated the next device and you may retrieve the ROM from the
+// OneWire::address variable. If there are no devices, no further
+// devices, or something horrible happens in the middle of the
+// enumeration then a 0 is returned.  If a new device is found then
+// its address is copied to newAddr.  Use
+// DallasTemperature::resetAlarmSearch() to start over.
+bool DallasTemperature::alarmSearch(uint8_t* newAddr) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_SEARCH);
+
+	DeviceAddress alarmAddr;
+	if (alarmSweep(&alarmAddr, 1) == 0)
+		return false;
+	for (uint8_t i = 0; i < 8; i++)
+		newAddr[i] = alarmAddr[i];
+	return true;
+
+}
+
+// Every pass of the alarm search costs a reset and three time slots per
+// ROM bit walked. A pass ends as soon as its path leads to a single
+// device of the address table, the rest of the ROM is taken from the
+// table: with 16 sensors of one family that is after about 12 of the 64
+// bits. Paths no table entry follows are walked to the end and checked
+// with a CRC computed along the way. A device connected after begin()
+// is only told apart from the known ones when begin() is run again.
+uint8_t DallasTemperature::alarmSweep(DeviceAddress* addresses, uint8_t count) {
+	DALLAS_STATS(DALLAS_STATS_ALARM_SEARCH);
+
+	// the table only speaks for the whole bus when it holds every device
+	uint8_t tableDevices = devices <= capacity ? devices : 0;
+	uint8_t found = 0;
+
+	while (found < count && !alarmSearchExhausted) {
+
+		if (!wireReset())
+			break;
+
+		// send the alarm search command
+		wireWrite(0xEC, 0);
+
+		// table entries still on the path of this pass
+		// one bit per table entry, a table holds at most 255
+		uint8_t onPath[32];
+		uint8_t matches = tableDevices;
+		uint8_t match = 0;
+		for (uint8_t j = 0; j < sizeof(onPath); j++)
+			onPath[j] = 0xFF;
+
+		int8_t lastJunction = -1;
+		uint8_t done = 1;
+		uint8_t crc = 0;
+		bool single = false;
+		uint8_t i;
+
+		for (i = 0; i < 64; i++) {
+
+			uint8_t a = wireReadBit();
+			uint8_t nota = wireReadBit();
+			uint8_t ibyte = i / 8;
+			uint8_t ibit = 1 << (i & 7);
+
+			// nothing responded: no alarm at all, or a device vanished
+			if (a && nota)
+				break;
+
+			if (!a && !nota) {
+				if (i == alarmSearchJunction) {
+					// this is our time to decide differently, we went zero last time, go one.
+					a = 1;
+					alarmSearchJunction = lastJunction;
+				} else if (i < alarmSearchJunction) {
+
+					// take whatever we took last time, look in address
+					if (alarmSearchAddress[ibyte] & ibit) {
+						a = 1;
+					} else {
+						// Only 0s count as pending junctions, we've already exhausted the 0 side of 1s
+						a = 0;
+						done = 0;
+						lastJunction = i;
+					}
+				} else {
+					// we are blazing new tree, take the 0
+					a = 0;
+					alarmSearchJunction = i;
+					done = 0;
+				}
+			}
+
+			if (a)
+				alarmSearchAddress[ibyte] |= ibit;
+			else
+				alarmSearchAddress[ibyte] &= ~ibit;
+
+			wireWriteBit(a);
+			crc = crc8Bit(crc, a);
+
+			if (matches == 0)
+				continue;
+
+			matches = 0;
+			for (uint8_t j = 0; j < tableDevices; j++) {
+				uint8_t jbit = 1 << (j & 7);
+				if (!(onPath[j / 8] & jbit))
+					continue;
+				if (((descriptors[j].rom[ibyte] & ibit) != 0) != (a != 0)) {
+					onPath[j / 8] &= ~jbit;
+					continue;
+				}
+				matches++;
+				match = j;
+			}
+			if (matches == 1) {
+				single = true;
+				break;
+			}
+		}
+
+		// the pass broke off without a device
+		if (i < 64 && !single) {
+			alarmSearchExhausted = 1;
+			break;
+		}
+
+		if (done)
+			alarmSearchExhausted = 1;
+
+		// the single device left on the path completes the ROM, the later
+		// passes look up the bits before their junction in it
+		if (single) {
+			for (uint8_t j = 0; j < 8; j++)
+				alarmSearchAddress[j] = descriptors[match].rom[j];
+		} else if (crc != 0) {
+			continue;
+		}
+
+		for (uint8_t j = 0; j < 8; j++)
+			addresses[found][j] = alarmSearchAddress[j];
+		found++;
+	}
+
+	return found;
+
+}
+
+// feeds one bit, least significant first, into the CRC8 of a ROM code.
+// The CRC over all 64 bits of a valid ROM is 0.
+uint8_t DallasTemperature::crc8Bit(uint8_t crc, uint8_t bit) {
+	uint8_t mix = (crc ^ bit) & 0x01;
+	crc >>= 1;
+	if (mix)
+		crc ^= 0x8C;
+	return crc;
+}
+
+// returns true if device address might have an alarm condition
+// (only an alarm search can verify this)
+bool DallasTemperature::hasAlarm(const uint8_t* deviceAddress) {
+	DALLAS_STATS(DALLAS_STATS_HAS_ALARM);
+
+	ScratchPad scratchPad;
+	if (isConnected(deviceAddress, scratchPad)) {
+
+		int8_t temp = calculateTemperature(deviceAddress, scratchPad) >> 7;
+
+		// check low alarm
+		if (temp <= (int8_t) scratchPad[LOW_ALARM_TEMP])
+			return true;
+
+		// check high alarm
+		if (temp >= (int8_t) scratchPad[HIGH_ALARM_TEMP])
+			return true;
+	}
+
+	// no alarm
+	return false;
+
+}
+
+// returns true if any device is reporting an alarm condition on the bus
+bool DallasTemperature::hasAlarm(void) {
+	DALLAS_STATS(DALLAS_STATS_HAS_ALARM);
+
+	resetAlarmSearch();
+	if (!wireReset())
+		return false;
+	wireWrite(0xEC, 0);
+
+	// any alarming device answers the first bit pair with a 0, the next
+	// command's reset ends the search
+	uint8_t a = wireReadBit();
+	uint8_t nota = wireReadBit();
+	return !(a && nota);
+}
+
+// runs the alarm handler for all devices returned by alarmSearch()
+// unless there no _AlarmHandler exist.
+void DallasTemperature::processAlarms(void) {
+	DALLAS_STATS(DALLAS_STATS_PROCESS_ALARMS);
+
+if (!hasAlarmHandler())
+{
+	return;
+}
+
+	resetAlarmSearch();
+	DeviceAddress alarmAddr;
+
+	// the sweep only returns addresses with a good CRC
+	while (alarmSweep(&alarmAddr, 1)) {
+		_AlarmHandler(alarmAddr);
+	}
+}
+
+// sets the alarm handler
+void DallasTemperature::setAlarmHandler(const AlarmHandler *handler) {
+	_AlarmHandler = handler;
+}
+
+// checks if AlarmHandler has been set.
+bool DallasTemperature::hasAlarmHandler()
+{
+  return _AlarmHandler != NO_ALARM_HANDLER;
+}
+
+#endif
+
+#if REQUIRESNEW
+
+// MnetCS - Allocates memory for DallasTemperature. Allows us to instance a new object
+void* DallasTemperature::operator new(unsigned int size) { // Implicit NSS obj size
+
+	void * p;// void pointer
+	p = malloc(size);// Allocate memory
+	memset((DallasTemperature*)p,0,size);// Initialise memory
+
+	//!!! CANT EXPLICITLY CALL CONSTRUCTOR - workaround by using an init() methodR - workaround by using an init() method
+	return (DallasTemperature*) p;// Cast blank region to NSS pointer
+}
+
+// MnetCS 2009 -  Free the memory used by this instance
+void DallasTemperature::operator delete(void* p) {
+
+	DallasTemperature* pNss = (DallasTemperature*) p; // Cast to NSS pointer
+	pNss->~DallasTemperature();// Destruct the object
+
+	free(p);// Free the memory
+}
+
+#endif
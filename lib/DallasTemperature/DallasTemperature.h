@@ -0,0 +1,629 @@
+#ifndef DallasTemperature_h
+#define DallasTemperature_h
+
+#define DALLASTEMPLIBVERSION "3.8.1" // To be deprecated -> TODO remove in 4.0.0
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// set to true to include code for new and delete operators
+#ifndef REQUIRESNEW
+#define REQUIRESNEW false
+#endif
+
+// set to true to include code implementing alarm search functions
+#ifndef REQUIRESALARMS
+#define REQUIRESALARMS true
+#endif
+
+// set to true to count the 1-Wire traffic and time of the public functions
+#ifndef REQUIRESSTATS
+#define REQUIRESSTATS false
+#endif
+
+// set to true to compute CRC8 with two 16 byte tables instead of one of
+// 256 bytes, for builds short of flash
+#ifndef DALLAS_CRC8_NIBBLE
+#define DALLAS_CRC8_NIBBLE false
+#endif
+
+// set to true to build without dynamic allocation. The device table moves
+// out of DallasTemperature, DallasTemperatureStatic<N> brings one for N
+// devices inside the object.
+#ifndef REQUIRESSTATIC
+#define REQUIRESSTATIC false
+#endif
+
+#if REQUIRESSTATIC && REQUIRESNEW
+#error "REQUIRESNEW allocates from the heap and can't be used with REQUIRESSTATIC"
+#endif
+
+// bytes a DallasTemperatureStatic<N> may take in a REQUIRESSTATIC build,
+// checked at compile time. The REQUIRESSTATS counters come on top.
+#ifndef DALLAS_STATIC_MAX_BYTES
+#define DALLAS_STATIC_MAX_BYTES 1024
+#endif
+
+// number of device addresses cached by begin() for the *ByIndex functions,
+// DallasTemperatureStatic<N> caches N instead
+#ifndef DALLAS_MAX_DEVICES
+#define DALLAS_MAX_DEVICES 16
+#endif
+
+// default change in 1/128 degrees C between two fast reads of a device
+// that is confirmed with a full, CRC checked read (2 degrees C)
+#ifndef DALLAS_FAST_READ_MAX_STEP
+#define DALLAS_FAST_READ_MAX_STEP 256
+#endif
+
+#include <inttypes.h>
+#ifdef __STM32F1__
+#include <OneWireSTM.h>
+#else
+#include <OneWire.h>
+#endif
+
+// Model IDs
+#define DS18S20MODEL 0x10  // also DS1820
+#define DS18B20MODEL 0x28  // also MAX31820
+#define DS1822MODEL  0x22
+#define DS1825MODEL  0x3B
+#define DS28EA00MODEL 0x42
+
+// Error Codes
+#define DEVICE_DISCONNECTED_C -127
+#define DEVICE_DISCONNECTED_F -196.6
+#define DEVICE_DISCONNECTED_RAW -7040
+
+// For readPowerSupply on oneWire bus
+// definition of nullptr for C++ < 11, using official workaround:
+// http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2007/n2431.pdf
+#if __cplusplus < 201103L
+const class
+{
+public:
+	template <class T>
+	operator T *() const
+	{
+		return 0;
+	}
+	template <class C, class T>
+	operator T C::*() const
+	{
+		return 0;
+	}
+
+private:
+	void operator&() const;
+} nullptr = {};
+#endif
+
+typedef uint8_t DeviceAddress[8];
+
+#if REQUIRESSTATS
+
+// public functions with separate bus cost counters, variants of a function
+// (ByIndex, C/F, ...) share one
+enum DallasStatsApi {
+	DALLAS_STATS_BEGIN,
+	DALLAS_STATS_GET_ADDRESS,
+	DALLAS_STATS_IS_CONNECTED,
+	DALLAS_STATS_READ_SCRATCHPAD,
+	DALLAS_STATS_WRITE_SCRATCHPAD,
+	DALLAS_STATS_SAVE_SCRATCHPAD,
+	DALLAS_STATS_RECALL_SCRATCHPAD,
+	DALLAS_STATS_READ_POWER_SUPPLY,
+	DALLAS_STATS_GET_RESOLUTION,
+	DALLAS_STATS_SET_RESOLUTION,
+	DALLAS_STATS_REQUEST_TEMPERATURES,
+	DALLAS_STATS_REQUEST_BY_ADDRESS,
+	DALLAS_STATS_CONVERSION_COMPLETE,
+	DALLAS_STATS_GET_TEMP,
+	DALLAS_STATS_READ_ALL,
+	DALLAS_STATS_PIPELINE,
+	DALLAS_STATS_USER_DATA,
+	DALLAS_STATS_ALARM_TEMP,
+	DALLAS_STATS_ALARM_SEARCH,
+	DALLAS_STATS_HAS_ALARM,
+	DALLAS_STATS_PROCESS_ALARMS,
+	DALLAS_STATS_COUNT
+};
+
+// bus cost of one public function. Traffic of nested calls is charged to
+// the outermost function, search slots are estimated for a full pass.
+struct DallasStats {
+	uint32_t calls;
+	uint32_t resets;
+	uint32_t writeSlots;
+	uint32_t readSlots;
+	uint32_t bytes;
+	uint32_t crcs;
+	uint32_t micros;  // wall time including conversion waits
+};
+
+#endif
+
+class DallasTemperature {
+public:
+
+#if REQUIRESSTATIC
+	// without a device table of its own the object would silently fall back
+	// to bus searches, construct a DallasTemperatureStatic<N> instead
+	DallasTemperature(OneWire*) = delete;
+	DallasTemperature(OneWire*, uint8_t) = delete;
+#else
+	DallasTemperature();
+	DallasTemperature(OneWire*);
+	DallasTemperature(OneWire*, uint8_t);
+#endif
+
+	void setOneWire(OneWire*);
+
+    void setPullupPin(uint8_t);
+
+	// initialise bus
+	void begin(void);
+
+	// enumerate the bus again, e.g. after a sensor was (un)plugged
+	void rescan(void);
+
+	// returns the number of devices found on the bus
+	uint8_t getDeviceCount(void);
+
+	// returns the number of DS18xxx Family devices on bus
+	uint8_t getDS18Count(void);
+
+	// returns true if address is valid
+	bool validAddress(const uint8_t*);
+
+	// returns true if address is of the family of sensors the lib supports.
+	bool validFamily(const uint8_t* deviceAddress);
+
+	// finds an address at a given index on the bus
+	// served from the table built by begin(), no bus traffic
+	bool getAddress(uint8_t*, uint8_t);
+
+	// attempt to determine if the device at the given address is connected to the bus
+	bool isConnected(const uint8_t*);
+
+	// attempt to determine if the device at the given address is connected to the bus
+	// also allows for updating the read scratchpad
+	bool isConnected(const uint8_t*, uint8_t*);
+
+	// read device's scratchpad
+	bool readScratchPad(const uint8_t*, uint8_t*);
+
+	// write device's scratchpad, copied to EEPROM if saveToEeprom and the
+	// autoSaveScratchPad flag are set
+	void writeScratchPad(const uint8_t*, const uint8_t*, bool saveToEeprom = true);
+
+	// read device's power requirements
+	bool readPowerSupply(const uint8_t* deviceAddress = nullptr);
+
+	// get global resolution
+	uint8_t getResolution();
+
+	// set global resolution to 9, 10, 11, or 12 bits
+	// writes only the devices that need it, saveToEeprom = false leaves the
+	// EEPROM alone, the setting is then lost at power down
+	void setResolution(uint8_t, bool saveToEeprom = true);
+
+	// returns the device resolution: 9, 10, 11, or 12 bits
+	uint8_t getResolution(const uint8_t*);
+
+	// set resolution of a device to 9, 10, 11, or 12 bits
+	bool setResolution(const uint8_t*, uint8_t,
+			bool skipGlobalBitResolutionCalculation = false,
+			bool saveToEeprom = true);
+
+	// sets/gets the waitForConversion flag
+	void setWaitForConversion(bool);
+	bool getWaitForConversion(void);
+
+	// sets/gets the checkForConversion flag
+	void setCheckForConversion(bool);
+	bool getCheckForConversion(void);
+
+	// sends command for all devices on the bus to perform a temperature conversion
+	void requestTemperatures(void);
+
+	// sends command for one device to perform a temperature conversion by address
+	bool requestTemperaturesByAddress(const uint8_t*);
+
+	// sends command for one device to perform a temperature conversion by index
+	bool requestTemperaturesByIndex(uint8_t);
+
+	// returns temperature raw value (12 bit integer of 1/128 degrees C)
+	int16_t getTemp(const uint8_t*);
+
+	// returns temperature in degrees C
+	float getTempC(const uint8_t*);
+
+	// returns temperature in degrees F
+	float getTempF(const uint8_t*);
+
+	// Get temperature for device index
+	float getTempCByIndex(uint8_t);
+
+	// Get temperature for device index
+	float getTempFByIndex(uint8_t);
+
+	// reads the raw temperature (1/128 degrees C) of every cached device in
+	// one pass, in getAddress() order. Fills up to count values and optional
+	// validity flags, failed devices read DEVICE_DISCONNECTED_RAW.
+	// returns the number of valid readings
+	uint8_t readAllTemperatures(int16_t*, bool*, uint8_t);
+
+	// Pipelined conversions: every device converts on its own schedule at
+	// its own resolution and is read as soon as its conversion time has
+	// elapsed, reads of one device overlap the conversions of the others.
+	// Externally powered buses only, startPipeline() returns false on a
+	// parasite powered one. Don't mix with requestTemperatures(), begin()
+	// stops the pipeline. A resolution set while a device converts takes
+	// effect once that conversion was read, getResolution() reports it from
+	// then on.
+	bool startPipeline(void);
+	void stopPipeline(void);
+	bool isPipelineRunning(void);
+
+	// call often, a call reads at most one device and starts its next
+	// conversion, or starts one device that isn't converting. Returns true
+	// when a sample was read, with the device index in getAddress() order
+	// and the raw temperature (1/128 degrees C), DEVICE_DISCONNECTED_RAW if
+	// the read failed. Reads follow the fast read policy.
+	bool pollPipeline(uint8_t*, int16_t*);
+
+	// sets the fast read policy of readAllTemperatures() and pollPipeline().
+	// Fast reads clock only the two temperature bytes and carry no CRC.
+	// Every Nth sample of a device, and any sample that moved more than
+	// maxStep (1/128 degrees C) from the previous one, is taken as a full
+	// CRC checked read.
+	// an interval of 0 or 1 disables fast reads
+	void setFastRead(uint8_t, int16_t maxStep = DALLAS_FAST_READ_MAX_STEP);
+	uint8_t getFastReadInterval(void);
+
+	// returns true if the bus requires parasite power
+	bool isParasitePowerMode(void);
+
+	// returns true if the device requires parasite power, as found by begin()
+	bool isParasitePowerMode(const uint8_t*);
+
+	// begin() caches the resolution, alarm registers and power mode of every
+	// device and the library keeps them current with its own writes. Forget
+	// the registers of a device, or of all devices, when they may have
+	// changed otherwise, e.g. sensors power cycled with settings that
+	// weren't saved to EEPROM. The next query reads them from the device.
+	void invalidateCache(const uint8_t* = nullptr);
+
+	// Is a conversion complete on the wire? Only applies to the first sensor on the wire.
+	bool isConversionComplete(void);
+
+  static uint16_t millisToWaitForConversion(uint8_t);
+  
+  uint16_t millisToWaitForConversion();
+  
+  // Sends command to one device to save values from scratchpad to EEPROM by index
+  // Returns true if no errors were encountered, false indicates failure
+  bool saveScratchPadByIndex(uint8_t);
+  
+  // Sends command to one or more devices to save values from scratchpad to EEPROM
+  // Returns true if no errors were encountered, false indicates failure
+  bool saveScratchPad(const uint8_t* = nullptr);
+  
+  // Sends command to one device to recall values from EEPROM to scratchpad by index
+  // Returns true if no errors were encountered, false indicates failure
+  bool recallScratchPadByIndex(uint8_t);
+  
+  // Sends command to one or more devices to recall values from EEPROM to scratchpad
+  // Returns true if no errors were encountered, false indicates failure
+  bool recallScratchPad(const uint8_t* = nullptr);
+  
+  // Sets the autoSaveScratchPad flag
+  void setAutoSaveScratchPad(bool);
+  
+  // Gets the autoSaveScratchPad flag
+  bool getAutoSaveScratchPad(void);
+
+#if REQUIRESALARMS
+
+	typedef void AlarmHandler(const uint8_t*);
+
+	// sets the high alarm temperature for a device
+	// accepts a int8_t.  valid range is -55C - 125C
+	void setHighAlarmTemp(const uint8_t*, int8_t);
+
+	// sets the low alarm temperature for a device
+	// accepts a int8_t.  valid range is -55C - 125C
+	void setLowAlarmTemp(const uint8_t*, int8_t);
+
+	// sets both alarm temperatures of a device with one scratchpad write,
+	// copied to EEPROM only if saveToEeprom. For re-arming a device often.
+	bool setAlarmWindow(const uint8_t*, int8_t low, int8_t high,
+			bool saveToEeprom = false);
+
+	// returns a int8_t with the current high alarm temperature for a device
+	// in the range -55C - 125C
+	int8_t getHighAlarmTemp(const uint8_t*);
+
+	// returns a int8_t with the current low alarm temperature for a device
+	// in the range -55C - 125C
+	int8_t getLowAlarmTemp(const uint8_t*);
+
+	// resets internal variables used for the alarm search
+	void resetAlarmSearch(void);
+
+	// search the wire for devices with active alarms
+	bool alarmSearch(uint8_t*);
+
+	// continues the alarm search, stores up to count alarming devices in
+	// the buffer and returns how many it found. Fewer than count means the
+	// search is exhausted, a full buffer can be followed by another call.
+	// Prunes the search with the address table, run begin() again after
+	// devices were added to the bus.
+	uint8_t alarmSweep(DeviceAddress*, uint8_t count);
+
+	// returns true if ia specific device has an alarm
+	bool hasAlarm(const uint8_t*);
+
+	// returns true if any device is reporting an alarm on the bus
+	bool hasAlarm(void);
+
+	// runs the alarm handler for all devices returned by alarmSearch()
+	void processAlarms(void);
+
+	// sets the alarm handler
+	void setAlarmHandler(const AlarmHandler *);
+
+	// returns true if an AlarmHandler has been set
+	bool hasAlarmHandler();
+
+#endif
+
+#if REQUIRESSTATS
+
+	// copies the counters of all public functions, DALLAS_STATS_COUNT
+	// entries indexed by DallasStatsApi
+	void getStats(DallasStats*);
+
+	// clears the counters
+	void resetStats(void);
+
+	// name of a DallasStatsApi entry
+	static const char* getStatsName(uint8_t);
+
+#endif
+
+	// if no alarm handler is used the two bytes can be used as user data
+	// example of such usage is an ID.
+	// note if device is not connected it will fail writing the data.
+	// note if address cannot be found no error will be reported.
+	// in short use carefully
+	void setUserData(const uint8_t*, int16_t);
+	void setUserDataByIndex(uint8_t, int16_t);
+	int16_t getUserData(const uint8_t*);
+	int16_t getUserDataByIndex(uint8_t);
+
+	// convert from Celsius to Fahrenheit
+	static float toFahrenheit(float);
+
+	// convert from Fahrenheit to Celsius
+	static float toCelsius(float);
+
+	// convert from raw to Celsius
+	static float rawToCelsius(int16_t);
+
+    // convert from Celsius to raw
+	static int16_t celsiusToRaw(float);
+
+	// convert from raw to Fahrenheit
+	static float rawToFahrenheit(int16_t);
+
+#if REQUIRESNEW
+
+	// initialize memory area
+	void* operator new (unsigned int);
+
+	// delete memory reference
+	void operator delete(void*);
+
+#endif
+
+	void blockTillConversionComplete(uint8_t);
+
+	// the device table belongs to one object
+	DallasTemperature(const DallasTemperature&) = delete;
+	DallasTemperature& operator=(const DallasTemperature&) = delete;
+
+protected:
+
+	// what begin() learned about a valid device and the state kept for it.
+	// The registers are kept in step with the library's own writes, valid
+	// is cleared when they may have changed otherwise.
+	struct DeviceDescriptor {
+		DeviceAddress rom;
+		uint8_t resolution;  // 9-12, always 12 for the DS18S20
+		bool parasite;
+		uint8_t highAlarm;
+		uint8_t lowAlarm;
+		bool valid;          // resolution and alarm registers are known
+
+		// pipeline schedule, a resolution set during a conversion waits
+		// until that conversion was read, 0 for none
+		bool converting;
+		uint8_t pendingResolution;
+		bool pendingSave;
+		unsigned long conversionStart;
+
+		// fast read policy
+		uint8_t fastReadCount;
+		int16_t lastTemperature;
+	};
+
+#if REQUIRESSTATIC
+	DallasTemperature();
+#endif
+
+	// uses capacity entries of table as the device table
+	DallasTemperature(OneWire*, DeviceDescriptor* table, uint8_t capacity);
+
+private:
+	typedef uint8_t ScratchPad[9];
+
+	// parasite power on or off
+	bool parasite;
+
+	// external pullup
+	bool useExternalPullup;
+	uint8_t pullupPin;
+
+	// used to determine the delay amount needed to allow for the
+	// temperature conversion to take place
+	uint8_t bitResolution;
+
+	// used to requestTemperature with or without delay
+	bool waitForConversion;
+
+	// used to requestTemperature to dynamically check if a conversion is complete
+	bool checkForConversion;
+
+  // used to determine if values will be saved from scratchpad to EEPROM on every scratchpad write
+  bool autoSaveScratchPad;
+
+	// count of devices on the bus
+	uint8_t devices;
+
+	// count of DS18xxx Family devices on bus
+	uint8_t ds18Count;
+
+	// the valid devices in search order, the first capacity of them
+	DeviceDescriptor* descriptors;
+	uint8_t capacity;
+#if !REQUIRESSTATIC
+	DeviceDescriptor table[DALLAS_MAX_DEVICES];
+#endif
+
+	// pipeline schedule
+	bool pipelineRunning;
+
+	// fast read policy
+	uint8_t fastReadInterval;
+	int16_t fastReadMaxStep;
+
+	// Take a pointer to one wire instance
+	OneWire* _wire;
+
+	// reads scratchpad and returns the raw temperature
+	int16_t calculateTemperature(const uint8_t*, uint8_t*);
+
+	// reads all 9 scratchpad bytes without the closing reset
+	bool fetchScratchPad(const uint8_t*, uint8_t*, bool* valid = nullptr);
+
+	// reads only TEMP_LSB and TEMP_MSB and resets the bus
+	bool fetchTemperature(const uint8_t*, uint8_t*);
+
+	// one device of readAllTemperatures(), honouring the fast read policy
+	bool readTemperature(uint8_t, int16_t*);
+
+	// starts the conversion of a pipelined device
+	void startConversion(uint8_t);
+
+	// ends the conversion of a pipelined device and applies a resolution
+	// set meanwhile
+	void finishConversion(uint8_t);
+
+	// descriptor table
+	bool broadcastResolution(uint8_t, bool);
+	void updateBitResolution(uint8_t);
+	uint8_t findDevice(const uint8_t*);
+	void cacheRegisters(const uint8_t*, const uint8_t*);
+	bool loadRegisters(const uint8_t*, uint8_t*);
+	static uint8_t resolutionOf(const uint8_t*, const uint8_t*);
+	static uint8_t configurationFor(uint8_t);
+	static uint8_t resolutionFor(uint8_t);
+
+
+	// OneWire access, counted when REQUIRESSTATS is set
+	uint8_t wireReset(void);
+	void wireSelect(const uint8_t*);
+	void wireSkip(void);
+	void wireWrite(uint8_t, uint8_t power = 0);
+	uint8_t wireRead(void);
+	void wireWriteBit(uint8_t);
+	uint8_t wireReadBit(void);
+	bool wireSearch(uint8_t*);
+	uint8_t wireCrc8(const uint8_t*, uint8_t);
+
+	// table driven CRC8, independent of how OneWire was built
+	static uint8_t crc8Update(uint8_t, uint8_t);
+	static uint8_t crc8(const uint8_t*, uint8_t);
+
+#if REQUIRESSTATS
+
+	// charges the bus traffic of the public function it is created in
+	class StatsScope {
+	public:
+		StatsScope(DallasTemperature*, uint8_t);
+		~StatsScope();
+	private:
+		DallasTemperature* owner;
+		unsigned long start;
+	};
+
+	DallasStats stats[DALLAS_STATS_COUNT];
+	uint8_t statsDepth;
+	uint8_t statsApi;
+
+	void countTraffic(uint8_t, uint16_t, uint16_t, uint8_t, uint8_t);
+
+#endif
+
+    // External pullup control
+    void activateExternalPullup(void);
+    void deactivateExternalPullup(void);
+
+#if REQUIRESALARMS
+
+	// required for alarmSearch
+	uint8_t alarmSearchAddress[8];
+	int8_t alarmSearchJunction;
+	uint8_t alarmSearchExhausted;
+
+	// Dallas CRC8 advanced by a single bit
+	static uint8_t crc8Bit(uint8_t, uint8_t);
+
+	// the alarm handler function pointer
+	AlarmHandler *_AlarmHandler;
+
+#endif
+
+};
+
+// DallasTemperature carrying the table for maxDevices devices inside the
+// object, nothing is allocated at run time. Meant for REQUIRESSTATIC builds
+// and defined as a global like the OneWire instance.
+template <uint8_t maxDevices>
+class DallasTemperatureStatic : public DallasTemperature {
+public:
+
+	DallasTemperatureStatic(OneWire* _oneWire = nullptr)
+			: DallasTemperature(_oneWire, table, maxDevices) {
+		static_assert(maxDevices > 0, "DallasTemperatureStatic needs room for a device");
+#if REQUIRESSTATIC
+		static_assert(sizeof(DallasTemperatureStatic) <= DALLAS_STATIC_MAX_BYTES + statsBytes,
+				"DallasTemperatureStatic exceeds DALLAS_STATIC_MAX_BYTES");
+#endif
+	}
+
+private:
+	DeviceDescriptor table[maxDevices];
+
+#if REQUIRESSTATS
+	static constexpr size_t statsBytes = sizeof(DallasStats) * DALLAS_STATS_COUNT;
+#else
+	static constexpr size_t statsBytes = 0;
+#endif
+};
+
+#endif
@@ -0,0 +1,736 @@
+#include "OneWire.h"
+#include "WConstants.h"
+
+// ROM commands
+#define SEARCHROM   0xF0
+#define READROM     0x33
+#define MATCHROM    0x55
+#define SKIPROM     0xCC
+#define ALARMSEARCH 0xEC
+
+// Function commands
+#define STARTCONVO      0x44
+#define COPYSCRATCH     0x48
+#define READSCRATCH     0xBE
+#define WRITESCRATCH    0x4E
+#define RECALLSCRATCH   0xB8
+#define READPOWERSUPPLY 0xB4
+
+// Scratchpad locations
+#define TEMP_LSB        0
+#define TEMP_MSB        1
+#define HIGH_ALARM_TEMP 2
+#define LOW_ALARM_TEMP  3
+#define CONFIGURATION   4
+#define COUNT_REMAIN    6
+#define COUNT_PER_C     7
+#define SCRATCHPAD_CRC  8
+
+// datasheet maximum of the EEPROM copy and recall
+#define COPY_US   10000
+#define RECALL_US 100
+
+// the simulated clock behind millis() and micros()
+static uint32_t simClock = 0;
+
+void simAdvanceMicros(uint32_t us) {
+	simClock += us;
+}
+
+unsigned long millis(void) {
+	return simClock / 1000;
+}
+
+unsigned long micros(void) {
+	return simClock;
+}
+
+void delay(unsigned long ms) {
+	simClock += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+	simClock += us;
+}
+
+void yield(void) {
+	simClock += 1;
+}
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t, uint8_t) {
+}
+
+/*
+ * Simulated sensor
+ */
+
+void OneWireSimDevice::init(uint8_t family, uint32_t serial) {
+	rom[0] = family;
+	for (uint8_t i = 1; i < 7; i++) {
+		rom[i] = serial & 0xFF;
+		serial >>= 8;
+	}
+	rom[7] = OneWire::crc8(rom, 7);
+
+	// factory defaults, the temperature register holds +85 C after power-up
+	eeprom[0] = 0x4B;
+	eeprom[1] = 0x46;
+	eeprom[2] = 0x7F;
+	if (family == ONEWIRE_SIM_DS18S20) {
+		scratchPad[TEMP_LSB] = 0xAA;
+		scratchPad[TEMP_MSB] = 0x00;
+		scratchPad[CONFIGURATION] = 0xFF;
+		scratchPad[COUNT_REMAIN] = 0x0C;
+	} else {
+		scratchPad[TEMP_LSB] = 0x50;
+		scratchPad[TEMP_MSB] = 0x05;
+		scratchPad[CONFIGURATION] = eeprom[2];
+		scratchPad[COUNT_REMAIN] = 0x0C;
+	}
+	scratchPad[HIGH_ALARM_TEMP] = eeprom[0];
+	scratchPad[LOW_ALARM_TEMP] = eeprom[1];
+	scratchPad[5] = 0xFF;
+	scratchPad[COUNT_PER_C] = 0x10;
+	updateCrc();
+
+	temperature = 25 * 128;
+	parasite = false;
+	present = true;
+	alarm = false;
+	converting = false;
+	convertPowered = false;
+	conversionEnd = 0;
+	crcErrors = 0;
+	bitErrorRate = 0;
+	eepromWrites = 0;
+	active = false;
+}
+
+const uint8_t* OneWireSimDevice::getAddress(void) const {
+	return rom;
+}
+
+uint8_t OneWireSimDevice::getFamily(void) const {
+	return rom[0];
+}
+
+void OneWireSimDevice::setTemperature(int16_t raw) {
+	temperature = raw;
+}
+
+int16_t OneWireSimDevice::getTemperature(void) const {
+	return temperature;
+}
+
+uint8_t OneWireSimDevice::getResolution(void) const {
+	if (rom[0] == ONEWIRE_SIM_DS18S20)
+		return 9;
+	return 9 + ((scratchPad[CONFIGURATION] >> 5) & 0x03);
+}
+
+void OneWireSimDevice::setParasite(bool flag) {
+	parasite = flag;
+}
+
+bool OneWireSimDevice::isParasite(void) const {
+	return parasite;
+}
+
+void OneWireSimDevice::setPresent(bool flag) {
+	present = flag;
+}
+
+bool OneWireSimDevice::isPresent(void) const {
+	return present;
+}
+
+void OneWireSimDevice::injectCrcErrors(uint8_t count) {
+	crcErrors = count;
+}
+
+void OneWireSimDevice::setBitErrorRate(uint32_t perMillion) {
+	bitErrorRate = perMillion;
+}
+
+const uint8_t* OneWireSimDevice::getScratchPad(void) const {
+	return scratchPad;
+}
+
+uint32_t OneWireSimDevice::getEepromWrites(void) const {
+	return eepromWrites;
+}
+
+bool OneWireSimDevice::hasAlarm(void) const {
+	return alarm;
+}
+
+// datasheet maximum conversion time in microseconds
+uint32_t OneWireSimDevice::conversionTime(void) const {
+	switch (getResolution()) {
+	case 9:
+		return rom[0] == ONEWIRE_SIM_DS18S20 ? 750000 : 93750;
+	case 10:
+		return 187500;
+	case 11:
+		return 375000;
+	default:
+		return 750000;
+	}
+}
+
+void OneWireSimDevice::finishConversion(uint32_t now) {
+	if (!converting || (int32_t) (now - conversionEnd) < 0)
+		return;
+	converting = false;
+
+	// without the strong pullup a parasite sensor browns out and the
+	// register keeps its power-up value
+	if (parasite && !convertPowered) {
+		if (rom[0] == ONEWIRE_SIM_DS18S20) {
+			scratchPad[TEMP_LSB] = 0xAA;
+			scratchPad[TEMP_MSB] = 0x00;
+		} else {
+			scratchPad[TEMP_LSB] = 0x50;
+			scratchPad[TEMP_MSB] = 0x05;
+		}
+		updateCrc();
+		return;
+	}
+
+	latchTemperature();
+}
+
+// stores the measured temperature in the scratchpad and evaluates the alarm
+void OneWireSimDevice::latchTemperature(void) {
+	int16_t t16 = temperature >> 3;
+	int16_t whole;
+
+	if (rom[0] == ONEWIRE_SIM_DS18S20) {
+		// 0.5 C register plus COUNT_REMAIN, so that
+		// T = whole - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+		whole = (t16 + 4) >> 4;
+		int16_t fraction = t16 - whole * 16;
+		int16_t reg = whole * 2;
+		scratchPad[TEMP_LSB] = reg & 0xFF;
+		scratchPad[TEMP_MSB] = (reg >> 8) & 0xFF;
+		scratchPad[COUNT_REMAIN] = 12 - fraction;
+		scratchPad[COUNT_PER_C] = 0x10;
+	} else {
+		// undefined low bits read as 0 below 12 bits
+		t16 &= ~((1 << (12 - getResolution())) - 1);
+		scratchPad[TEMP_LSB] = t16 & 0xFF;
+		scratchPad[TEMP_MSB] = (t16 >> 8) & 0xFF;
+		whole = t16 >> 4;
+	}
+
+	// TH and TL compare against the integer part
+	alarm = whole >= (int8_t) scratchPad[HIGH_ALARM_TEMP]
+			|| whole <= (int8_t) scratchPad[LOW_ALARM_TEMP];
+
+	updateCrc();
+}
+
+void OneWireSimDevice::updateCrc(void) {
+	scratchPad[SCRATCHPAD_CRC] = OneWire::crc8(scratchPad, 8);
+}
+
+/*
+ * Simulated bus
+ */
+
+OneWire::OneWire(uint8_t) {
+	deviceCount = 0;
+	state = BUS_IDLE;
+	shift = 0;
+	bitCount = 0;
+	byteCount = 0;
+	searchPhase = 0;
+	power = false;
+	busyUntil = 0;
+	random = 0x12345678;
+	resetStats();
+	reset_search();
+}
+
+OneWireSimDevice* OneWire::addDevice(uint8_t family, uint32_t serial) {
+	if (deviceCount >= ONEWIRE_SIM_MAX_DEVICES)
+		return nullptr;
+	OneWireSimDevice* device = &devices[deviceCount++];
+	device->init(family, serial);
+	return device;
+}
+
+uint8_t OneWire::getDeviceCount(void) {
+	return deviceCount;
+}
+
+OneWireSimDevice* OneWire::getDevice(uint8_t index) {
+	return index < deviceCount ? &devices[index] : nullptr;
+}
+
+const OneWireSimStats& OneWire::getStats(void) {
+	return stats;
+}
+
+void OneWire::resetStats(void) {
+	stats.resets = 0;
+	stats.writeSlots = 0;
+	stats.readSlots = 0;
+	stats.conversions = 0;
+	stats.eepromWrites = 0;
+	stats.micros = 0;
+}
+
+// finishes the conversions that are due
+void OneWire::update(void) {
+	for (uint8_t i = 0; i < deviceCount; i++)
+		devices[i].finishConversion(micros());
+}
+
+void OneWire::slot(void) {
+	simAdvanceMicros(ONEWIRE_SIM_SLOT_US);
+	stats.micros += ONEWIRE_SIM_SLOT_US;
+	update();
+}
+
+uint8_t OneWire::reset(void) {
+	simAdvanceMicros(ONEWIRE_SIM_RESET_US);
+	stats.micros += ONEWIRE_SIM_RESET_US;
+	stats.resets++;
+	update();
+
+	uint8_t presence = 0;
+	for (uint8_t i = 0; i < deviceCount; i++) {
+		devices[i].active = false;
+		if (devices[i].present)
+			presence = 1;
+	}
+
+	state = BUS_ROM_COMMAND;
+	shift = 0;
+	bitCount = 0;
+	power = false;
+	return presence;
+}
+
+void OneWire::select(const uint8_t rom[8]) {
+	write(MATCHROM);
+	for (uint8_t i = 0; i < 8; i++)
+		write(rom[i]);
+}
+
+void OneWire::skip(void) {
+	write(SKIPROM);
+}
+
+void OneWire::write(uint8_t v, uint8_t strongPullup) {
+	power = strongPullup;
+	for (uint8_t mask = 0x01; mask; mask <<= 1)
+		write_bit((v & mask) ? 1 : 0);
+}
+
+void OneWire::write_bytes(const uint8_t *buf, uint16_t count, bool strongPullup) {
+	for (uint16_t i = 0; i < count; i++)
+		write(buf[i], strongPullup);
+}
+
+uint8_t OneWire::read(void) {
+	uint8_t r = 0;
+	for (uint8_t mask = 0x01; mask; mask <<= 1) {
+		if (read_bit())
+			r |= mask;
+	}
+	return r;
+}
+
+void OneWire::read_bytes(uint8_t *buf, uint16_t count) {
+	for (uint16_t i = 0; i < count; i++)
+		buf[i] = read();
+}
+
+void OneWire::depower(void) {
+	power = false;
+}
+
+// wired-AND of a bit of all active sensors, 1 when none drives the bus
+uint8_t OneWire::activeBit(const uint8_t* data, uint8_t bit, bool complement) {
+	uint8_t result = 1;
+	for (uint8_t i = 0; i < deviceCount; i++) {
+		OneWireSimDevice& d = devices[i];
+		if (!d.active || !d.present)
+			continue;
+		const uint8_t* bytes = data != nullptr ? data : d.rom;
+		uint8_t b = (bytes[bit / 8] >> (bit % 8)) & 1;
+		if (complement)
+			b ^= 1;
+		if (b == 0)
+			result = 0;
+	}
+	return result;
+}
+
+// true when the bit error model flips a bit sent by this sensor
+bool OneWire::flip(const OneWireSimDevice& d) {
+	if (d.bitErrorRate == 0)
+		return false;
+	random = random * 1103515245 + 12345;
+	return ((random >> 8) % 1000000) < d.bitErrorRate;
+}
+
+void OneWire::write_bit(uint8_t v) {
+	slot();
+	stats.writeSlots++;
+	v &= 1;
+
+	switch (state) {
+	case BUS_ROM_COMMAND:
+	case BUS_FUNCTION_COMMAND:
+	case BUS_WRITE_SCRATCH:
+		shift |= v << bitCount;
+		if (++bitCount < 8)
+			return;
+		bitCount = 0;
+		if (state == BUS_ROM_COMMAND) {
+			romCommand(shift);
+		} else if (state == BUS_FUNCTION_COMMAND) {
+			functionCommand(shift);
+		} else {
+			for (uint8_t i = 0; i < deviceCount; i++) {
+				OneWireSimDevice& d = devices[i];
+				if (!d.active || !d.present)
+					continue;
+				// TH, TL and, except on the DS18S20, the configuration
+				if (byteCount == 2 && d.rom[0] == ONEWIRE_SIM_DS18S20)
+					continue;
+				if (byteCount == 2)
+					d.scratchPad[CONFIGURATION] = (shift & 0x60) | 0x1F;
+				else if (byteCount < 2)
+					d.scratchPad[HIGH_ALARM_TEMP + byteCount] = shift;
+				d.updateCrc();
+			}
+			byteCount++;
+		}
+		shift = 0;
+		return;
+
+	case BUS_MATCH_ROM:
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (d.active && ((d.rom[bitCount / 8] >> (bitCount % 8)) & 1) != v)
+				d.active = false;
+		}
+		if (++bitCount == 64) {
+			state = BUS_FUNCTION_COMMAND;
+			bitCount = 0;
+			shift = 0;
+		}
+		return;
+
+	case BUS_SEARCH:
+		if (searchPhase != 2) {
+			state = BUS_IDLE;
+			return;
+		}
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (d.active && ((d.rom[bitCount / 8] >> (bitCount % 8)) & 1) != v)
+				d.active = false;
+		}
+		searchPhase = 0;
+		if (++bitCount == 64) {
+			state = BUS_FUNCTION_COMMAND;
+			bitCount = 0;
+			shift = 0;
+		}
+		return;
+
+	default:
+		return;
+	}
+}
+
+uint8_t OneWire::read_bit(void) {
+	slot();
+	stats.readSlots++;
+
+	switch (state) {
+	case BUS_SEARCH:
+		if (searchPhase > 1)
+			return 1;
+		return activeBit(nullptr, bitCount, searchPhase++ == 1);
+
+	case BUS_READ_ROM: {
+		if (bitCount >= 64)
+			return 1;
+		uint8_t b = activeBit(nullptr, bitCount, false);
+		bitCount++;
+		return b;
+	}
+
+	case BUS_READ_SCRATCH: {
+		if (byteCount >= 9)
+			return 1;
+		uint8_t result = 1;
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (!d.active || !d.present)
+				continue;
+			uint8_t b = (d.tx[byteCount] >> bitCount) & 1;
+			if (flip(d))
+				b ^= 1;
+			if (b == 0)
+				result = 0;
+		}
+		if (++bitCount == 8) {
+			bitCount = 0;
+			byteCount++;
+		}
+		return result;
+	}
+
+	case BUS_CONVERTING:
+		// externally powered sensors hold the bus low while converting,
+		// parasite powered ones can't answer
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (d.active && d.present && d.converting && !d.parasite)
+				return 0;
+		}
+		return 1;
+
+	case BUS_COPYING:
+	case BUS_RECALLING:
+		return (int32_t) (micros() - busyUntil) < 0 ? 0 : 1;
+
+	case BUS_READ_POWER:
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (d.active && d.present && d.parasite)
+				return 0;
+		}
+		return 1;
+
+	default:
+		return 1;
+	}
+}
+
+void OneWire::romCommand(uint8_t command) {
+	for (uint8_t i = 0; i < deviceCount; i++)
+		devices[i].active = devices[i].present;
+
+	bitCount = 0;
+	searchPhase = 0;
+
+	switch (command) {
+	case MATCHROM:
+		state = BUS_MATCH_ROM;
+		break;
+	case SKIPROM:
+		state = BUS_FUNCTION_COMMAND;
+		break;
+	case SEARCHROM:
+		state = BUS_SEARCH;
+		break;
+	case ALARMSEARCH:
+		for (uint8_t i = 0; i < deviceCount; i++)
+			devices[i].active = devices[i].present && devices[i].alarm;
+		state = BUS_SEARCH;
+		break;
+	case READROM:
+		state = BUS_READ_ROM;
+		break;
+	default:
+		state = BUS_IDLE;
+		break;
+	}
+}
+
+void OneWire::functionCommand(uint8_t command) {
+	byteCount = 0;
+	bitCount = 0;
+
+	switch (command) {
+	case STARTCONVO:
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (!d.active)
+				continue;
+			d.converting = true;
+			d.convertPowered = power;
+			d.conversionEnd = micros() + d.conversionTime();
+			stats.conversions++;
+		}
+		state = BUS_CONVERTING;
+		break;
+
+	case READSCRATCH:
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (!d.active)
+				continue;
+			for (uint8_t j = 0; j < 9; j++)
+				d.tx[j] = d.scratchPad[j];
+			if (d.crcErrors > 0) {
+				d.tx[TEMP_LSB] ^= 0x01;
+				d.crcErrors--;
+			}
+		}
+		state = BUS_READ_SCRATCH;
+		break;
+
+	case WRITESCRATCH:
+		state = BUS_WRITE_SCRATCH;
+		break;
+
+	case COPYSCRATCH:
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (!d.active)
+				continue;
+			for (uint8_t j = 0; j < 3; j++)
+				d.eeprom[j] = d.scratchPad[HIGH_ALARM_TEMP + j];
+			d.eepromWrites++;
+			stats.eepromWrites++;
+		}
+		busyUntil = micros() + COPY_US;
+		state = BUS_COPYING;
+		break;
+
+	case RECALLSCRATCH:
+		for (uint8_t i = 0; i < deviceCount; i++) {
+			OneWireSimDevice& d = devices[i];
+			if (!d.active)
+				continue;
+			d.scratchPad[HIGH_ALARM_TEMP] = d.eeprom[0];
+			d.scratchPad[LOW_ALARM_TEMP] = d.eeprom[1];
+			if (d.rom[0] != ONEWIRE_SIM_DS18S20)
+				d.scratchPad[CONFIGURATION] = d.eeprom[2];
+			d.updateCrc();
+		}
+		busyUntil = micros() + RECALL_US;
+		state = BUS_RECALLING;
+		break;
+
+	case READPOWERSUPPLY:
+		state = BUS_READ_POWER;
+		break;
+
+	default:
+		state = BUS_IDLE;
+		break;
+	}
+}
+
+/*
+ * ROM search, the algorithm of Maxim application note 187
+ */
+
+void OneWire::reset_search(void) {
+	lastDiscrepancy = 0;
+	lastDeviceFlag = false;
+	lastFamilyDiscrepancy = 0;
+	for (uint8_t i = 0; i < 8; i++)
+		searchAddress[i] = 0;
+}
+
+void OneWire::target_search(uint8_t family_code) {
+	searchAddress[0] = family_code;
+	for (uint8_t i = 1; i < 8; i++)
+		searchAddress[i] = 0;
+	lastDiscrepancy = 64;
+	lastFamilyDiscrepancy = 0;
+	lastDeviceFlag = false;
+}
+
+bool OneWire::search(uint8_t *newAddr, bool search_mode) {
+	uint8_t idBitNumber = 1;
+	uint8_t lastZero = 0;
+	uint8_t romByteNumber = 0;
+	uint8_t romByteMask = 1;
+	bool result = false;
+
+	if (!lastDeviceFlag) {
+		if (!reset()) {
+			reset_search();
+			return false;
+		}
+
+		write(search_mode ? SEARCHROM : ALARMSEARCH);
+
+		do {
+			uint8_t idBit = read_bit();
+			uint8_t cmpIdBit = read_bit();
+			uint8_t direction;
+
+			// no device left in the search
+			if (idBit && cmpIdBit)
+				break;
+
+			if (idBit != cmpIdBit) {
+				direction = idBit;
+			} else {
+				if (idBitNumber < lastDiscrepancy)
+					direction = (searchAddress[romByteNumber] & romByteMask) ? 1 : 0;
+				else
+					direction = (idBitNumber == lastDiscrepancy) ? 1 : 0;
+
+				if (direction == 0) {
+					lastZero = idBitNumber;
+					if (lastZero < 9)
+						lastFamilyDiscrepancy = lastZero;
+				}
+			}
+
+			if (direction)
+				searchAddress[romByteNumber] |= romByteMask;
+			else
+				searchAddress[romByteNumber] &= ~romByteMask;
+
+			write_bit(direction);
+
+			idBitNumber++;
+			romByteMask <<= 1;
+			if (romByteMask == 0) {
+				romByteNumber++;
+				romByteMask = 1;
+			}
+		} while (romByteNumber < 8);
+
+		if (idBitNumber == 65) {
+			lastDiscrepancy = lastZero;
+			if (lastDiscrepancy == 0)
+				lastDeviceFlag = true;
+			result = true;
+		}
+	}
+
+	if (!result || !searchAddress[0]) {
+		reset_search();
+		return false;
+	}
+
+	for (uint8_t i = 0; i < 8; i++)
+		newAddr[i] = searchAddress[i];
+	return true;
+}
+
+// Dallas/Maxim CRC-8, polynomial x^8 + x^5 + x^4 + 1
+uint8_t OneWire::crc8(const uint8_t *addr, uint8_t len) {
+	uint8_t crc = 0;
+
+	while (len--) {
+		uint8_t inbyte = *addr++;
+		for (uint8_t i = 8; i; i--) {
+			uint8_t mix = (crc ^ inbyte) & 0x01;
+			crc >>= 1;
+			if (mix)
+				crc ^= 0x8C;
+			inbyte >>= 1;
+		}
+	}
+	return crc;
+}
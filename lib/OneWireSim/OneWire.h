@@ -0,0 +1,190 @@
+#ifndef OneWire_h
+#define OneWire_h
+
+// Host-side stand-in for the OneWire library.
+//
+// Simulates a 1-Wire bus with DS18B20, DS18S20 and DS1822 temperature
+// sensors at bit slot level, so DallasTemperature and the code on top of
+// it run unchanged on the native platform. Time is simulated too: every
+// reset and bit slot advances the clock by its standard speed duration and
+// millis()/micros()/delay() from WConstants.h follow that clock, which makes
+// runs deterministic. Every reset and slot is counted, see OneWireSimStats.
+//
+// The sensors model ROM search and alarm search, scratchpad and EEPROM
+// contents, conversion time per resolution, parasite power and injectable
+// CRC and bit errors.
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// devices a simulated bus can hold
+#ifndef ONEWIRE_SIM_MAX_DEVICES
+#define ONEWIRE_SIM_MAX_DEVICES 32
+#endif
+
+// standard speed timing in microseconds
+#define ONEWIRE_SIM_RESET_US 960
+#define ONEWIRE_SIM_SLOT_US  70
+
+// family codes of the simulated sensors
+#define ONEWIRE_SIM_DS18S20 0x10
+#define ONEWIRE_SIM_DS18B20 0x28
+#define ONEWIRE_SIM_DS1822  0x22
+
+// bus cost counters
+struct OneWireSimStats {
+	uint32_t resets;
+	uint32_t writeSlots;
+	uint32_t readSlots;
+	uint32_t conversions;
+	uint32_t eepromWrites;
+	uint32_t micros;        // time spent on the bus
+};
+
+class OneWire;
+
+class OneWireSimDevice {
+public:
+
+	const uint8_t* getAddress(void) const;
+	uint8_t getFamily(void) const;
+
+	// temperature the next conversion measures, in 1/128 degrees C
+	void setTemperature(int16_t);
+	int16_t getTemperature(void) const;
+
+	// resolution from the configuration register, 9-12 bits
+	uint8_t getResolution(void) const;
+
+	// a parasite powered sensor needs the strong pullup during conversion
+	// and EEPROM copy and answers 0 to READ POWER SUPPLY
+	void setParasite(bool);
+	bool isParasite(void) const;
+
+	// an absent sensor doesn't answer, e.g. to simulate unplugging
+	void setPresent(bool);
+	bool isPresent(void) const;
+
+	// flips one bit of the next count scratchpad transfers
+	void injectCrcErrors(uint8_t);
+
+	// probability per million read slots that a bit of this sensor flips
+	void setBitErrorRate(uint32_t);
+
+	// scratchpad contents as the sensor would send them
+	const uint8_t* getScratchPad(void) const;
+
+	// EEPROM copies done by this sensor, the part of interest for endurance
+	uint32_t getEepromWrites(void) const;
+
+	// true when the last conversion set the alarm flag
+	bool hasAlarm(void) const;
+
+private:
+	friend class OneWire;
+
+	uint8_t rom[8];
+	uint8_t scratchPad[9];
+	uint8_t eeprom[3];
+	int16_t temperature;
+	bool parasite;
+	bool present;
+	bool alarm;
+
+	// running conversion
+	bool converting;
+	bool convertPowered;
+	uint32_t conversionEnd;
+
+	uint8_t crcErrors;
+	uint32_t bitErrorRate;
+	uint32_t eepromWrites;
+
+	// bus transaction state
+	bool active;
+	uint8_t tx[9];
+
+	void init(uint8_t family, uint32_t serial);
+	uint32_t conversionTime(void) const;
+	void finishConversion(uint32_t now);
+	void latchTemperature(void);
+	void updateCrc(void);
+};
+
+class OneWire {
+public:
+
+	OneWire(uint8_t pin);
+
+	// Simulation control
+	// adds a sensor with a serial number unique on the bus, returns nullptr
+	// when the bus is full
+	OneWireSimDevice* addDevice(uint8_t family, uint32_t serial);
+	uint8_t getDeviceCount(void);
+	OneWireSimDevice* getDevice(uint8_t);
+
+	const OneWireSimStats& getStats(void);
+	void resetStats(void);
+
+	// OneWire API
+	uint8_t reset(void);
+	void select(const uint8_t rom[8]);
+	void skip(void);
+	void write(uint8_t v, uint8_t power = 0);
+	void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0);
+	uint8_t read(void);
+	void read_bytes(uint8_t *buf, uint16_t count);
+	void write_bit(uint8_t v);
+	uint8_t read_bit(void);
+	void depower(void);
+
+	void reset_search(void);
+	void target_search(uint8_t family_code);
+	bool search(uint8_t *newAddr, bool search_mode = true);
+
+	static uint8_t crc8(const uint8_t *addr, uint8_t len);
+
+private:
+	enum State {
+		BUS_IDLE,
+		BUS_ROM_COMMAND,
+		BUS_MATCH_ROM,
+		BUS_SEARCH,
+		BUS_READ_ROM,
+		BUS_FUNCTION_COMMAND,
+		BUS_CONVERTING,
+		BUS_READ_SCRATCH,
+		BUS_WRITE_SCRATCH,
+		BUS_COPYING,
+		BUS_RECALLING,
+		BUS_READ_POWER
+	};
+
+	OneWireSimDevice devices[ONEWIRE_SIM_MAX_DEVICES];
+	uint8_t deviceCount;
+	OneWireSimStats stats;
+
+	State state;
+	uint8_t shift;      // byte being assembled from written bits
+	uint8_t bitCount;   // bits of the current byte or ROM
+	uint8_t byteCount;  // bytes of the current transfer
+	uint8_t searchPhase;
+	bool power;
+	uint32_t busyUntil;
+	uint32_t random;
+
+	// search state
+	uint8_t searchAddress[8];
+	uint8_t lastDiscrepancy;
+	uint8_t lastFamilyDiscrepancy;
+	bool lastDeviceFlag;
+
+	void slot(void);
+	void update(void);
+	void romCommand(uint8_t);
+	void functionCommand(uint8_t);
+	uint8_t activeBit(const uint8_t*, uint8_t bit, bool complement);
+	bool flip(const OneWireSimDevice&);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef WConstants_h
+#define WConstants_h
+
+// Minimal Arduino core for the native platform, running on the simulated
+// clock of the OneWireSim bus. DallasTemperature.cpp includes this header
+// when it isn't built by an Arduino core.
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0
+#define OUTPUT 1
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+// moves the simulated clock forward
+void simAdvanceMicros(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+#include "CommandParser.h"
+
+// numbers are clamped to the int16_t range
+#define NUMBER_LIMIT 32767
+
+CommandParser::CommandParser() {
+  command.type = CMD_NONE;
+  command.argc = 0;
+  reset();
+}
+
+void CommandParser::reset(void) {
+  state = PARSE_START;
+  type = CMD_NONE;
+  argc = 0;
+  length = 0;
+  negative = false;
+  hasDigits = false;
+  number = 0;
+}
+
+const Command& CommandParser::getCommand(void) {
+  return command;
+}
+
+bool CommandParser::feed(char c) {
+
+  if (c == '\n' || c == '\r') {
+    // blank lines, and the \n of a \r\n, are no commands
+    if (state == PARSE_START && type == CMD_NONE) {
+      reset();
+      return false;
+    }
+    return finish();
+  }
+
+  if (state == PARSE_ERROR)
+    return false;
+
+  if (++length > COMMAND_MAX_LENGTH) {
+    state = PARSE_ERROR;
+    return false;
+  }
+
+  bool blank = (c == ' ' || c == '\t' || c == ',');
+
+  switch (state) {
+  case PARSE_START:
+    if (blank)
+      return false;
+    switch (c) {
+    case 'O': case 'o': type = CMD_OFFSET; break;
+    case 'S': case 's': type = CMD_SETPOINT; break;
+    case 'C': case 'c': type = CMD_CURVE; break;
+    case 'F': case 'f': type = CMD_FAN_DUTY; break;
+    case 'T': case 't': type = CMD_TELEMETRY; break;
+    case 'D': case 'd': type = CMD_STATS; break;
+    case '?': type = CMD_STATUS; break;
+    default:
+      // a bare number sets the offset
+      type = CMD_OFFSET;
+      if (!beginArgument(c))
+        state = PARSE_ERROR;
+      return false;
+    }
+    state = PARSE_BLANK;
+    return false;
+
+  case PARSE_BLANK:
+    if (!blank && !beginArgument(c))
+      state = PARSE_ERROR;
+    return false;
+
+  case PARSE_NUMBER:
+    if (blank) {
+      if (!endArgument())
+        state = PARSE_ERROR;
+      else
+        state = PARSE_BLANK;
+    } else if (c >= '0' && c <= '9') {
+      hasDigits = true;
+      number = number * 10 + (c - '0');
+      if (number > NUMBER_LIMIT)
+        number = NUMBER_LIMIT;
+    } else {
+      state = PARSE_ERROR;
+    }
+    return false;
+
+  default:
+    return false;
+  }
+}
+
+bool CommandParser::beginArgument(char c) {
+  if (argc >= COMMAND_MAX_ARGS)
+    return false;
+
+  negative = false;
+  hasDigits = false;
+  number = 0;
+
+  if (c == '-' || c == '+') {
+    negative = (c == '-');
+  } else if (c >= '0' && c <= '9') {
+    hasDigits = true;
+    number = c - '0';
+  } else {
+    return false;
+  }
+
+  state = PARSE_NUMBER;
+  return true;
+}
+
+bool CommandParser::endArgument(void) {
+  if (!hasDigits)
+    return false;
+  args[argc++] = (int16_t) (negative ? -number : number);
+  return true;
+}
+
+// completes the line: checks the argument count and publishes the command
+bool CommandParser::finish(void) {
+  bool ok = (state != PARSE_ERROR) && (state != PARSE_NUMBER || endArgument());
+
+  if (ok) {
+    switch (type) {
+    case CMD_OFFSET:
+    case CMD_SETPOINT:
+    case CMD_TELEMETRY:
+      ok = (argc == 1);
+      break;
+    case CMD_CURVE:
+      ok = (argc == 1 || argc == 2);
+      break;
+    case CMD_FAN_DUTY:
+      ok = (argc == 2);
+      break;
+    case CMD_STATS:
+      ok = (argc == 0 || (argc == 1 && args[0] == 0));
+      break;
+    case CMD_STATUS:
+      ok = (argc == 0);
+      break;
+    default:
+      ok = false;
+      break;
+    }
+  }
+
+  command.type = ok ? type : CMD_ERROR;
+  command.argc = ok ? argc : 0;
+  for (uint8_t i = 0; i < COMMAND_MAX_ARGS; i++)
+    command.args[i] = (ok && i < argc) ? args[i] : 0;
+
+  reset();
+  return true;
+}
@@ -0,0 +1,122 @@
+#include "FanBank.h"
+
+// guards the tacho snapshot against the ISRs
+static portMUX_TYPE tachoMux = portMUX_INITIALIZER_UNLOCKED;
+
+FanBank::FanBank() {
+  fanCount = 0;
+}
+
+int8_t FanBank::addFan(uint8_t tachoPin, uint8_t pwmPin) {
+  if (fanCount >= FAN_BANK_MAX_FANS)
+    return -1;
+
+  Channel& c = channels[fanCount];
+  c.tachoPin = tachoPin;
+  c.pwmPin = pwmPin;
+  c.duty = 0;
+  c.tacho.reset();
+
+  // fans on a PWM pin already in use share its LEDC channel
+  c.pwmChannel = fanCount;
+  for (uint8_t i = 0; i < fanCount; i++) {
+    if (channels[i].pwmPin == pwmPin) {
+      c.pwmChannel = channels[i].pwmChannel;
+      break;
+    }
+  }
+
+  return fanCount++;
+}
+
+void FanBank::begin(void) {
+  for (uint8_t i = 0; i < fanCount; i++) {
+    Channel& c = channels[i];
+
+    if (c.pwmChannel == i) {
+      ledcSetup(c.pwmChannel, FAN_PWM_FREQUENCY, FAN_PWM_RESOLUTION);
+      ledcAttachPin(c.pwmPin, c.pwmChannel);
+    }
+    applyDuty(i);
+
+    pinMode(c.tachoPin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(c.tachoPin), onTachoEdge, &c, FALLING);
+  }
+}
+
+void IRAM_ATTR FanBank::onTachoEdge(void* arg) {
+  Channel* c = (Channel*) arg;
+  uint32_t now = micros();
+
+  portENTER_CRITICAL_ISR(&tachoMux);
+  c->tacho.edge(now);
+  portEXIT_CRITICAL_ISR(&tachoMux);
+}
+
+uint8_t FanBank::getFanCount(void) {
+  return fanCount;
+}
+
+unsigned int FanBank::getSpeed(uint8_t fan) {
+  if (fan >= fanCount)
+    return 0;
+
+  portENTER_CRITICAL(&tachoMux);
+  uint32_t period = channels[fan].tacho.getPeriod();
+  uint32_t lastEdge = channels[fan].tacho.getLastEdge();
+  portEXIT_CRITICAL(&tachoMux);
+
+  return FanTacho::rpmFromEdges(period, lastEdge, micros());
+}
+
+void FanBank::setDutyCycle(uint8_t fan, uint8_t duty) {
+  if (fan >= fanCount)
+    return;
+  channels[fan].duty = constrain(duty, 0, 100);
+  applyDuty(fan);
+}
+
+void FanBank::setDutyCycle(uint8_t duty) {
+  for (uint8_t i = 0; i < fanCount; i++)
+    setDutyCycle(i, duty);
+}
+
+uint8_t FanBank::getDutyCycle(uint8_t fan) {
+  if (fan >= fanCount)
+    return 0;
+  return outputDuty(channels[fan].pwmChannel);
+}
+
+uint8_t FanBank::getRequestedDutyCycle(uint8_t fan) {
+  if (fan >= fanCount)
+    return 0;
+  return channels[fan].duty;
+}
+
+bool FanBank::isSharedOutput(uint8_t fan) {
+  if (fan >= fanCount)
+    return false;
+  for (uint8_t i = 0; i < fanCount; i++) {
+    if (i != fan && channels[i].pwmChannel == channels[fan].pwmChannel)
+      return true;
+  }
+  return false;
+}
+
+uint8_t FanBank::outputDuty(uint8_t pwmChannel) {
+  uint8_t duty = 0;
+
+  for (uint8_t i = 0; i < fanCount; i++) {
+    if (channels[i].pwmChannel == pwmChannel && channels[i].duty > duty)
+      duty = channels[i].duty;
+  }
+
+  return duty;
+}
+
+void FanBank::applyDuty(uint8_t fan) {
+  uint8_t pwmChannel = channels[fan].pwmChannel;
+  uint32_t duty = outputDuty(pwmChannel);
+
+  ledcWrite(pwmChannel, duty * ((1 << FAN_PWM_RESOLUTION) - 1) / 100);
+}
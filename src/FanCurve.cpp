@@ -0,0 +1,44 @@
+#include "FanCurve.h"
+
+FanCurveFollower::FanCurveFollower() {
+  curve = 0;
+  hysteresis = 0;
+  duty = 0;
+}
+
+void FanCurveFollower::setCurve(const uint8_t* table, uint8_t steps) {
+  curve = table;
+  hysteresis = steps;
+}
+
+uint8_t FanCurveFollower::update(int16_t raw) {
+  if (curve == 0)
+    return duty;
+
+  // a lost probe runs the fan flat out, the curve resumes from there once
+  // readings return and falls through the hysteresis band as usual
+  if (raw == TEMP128_INVALID) {
+    duty = 100;
+    return duty;
+  }
+
+  unsigned step = fanCurveStep(raw);
+  uint8_t up = curve[step];
+
+  if (up >= duty) {
+    duty = up;
+  } else {
+    // evaluate the curve shifted up by the hysteresis band
+    unsigned shifted = step + hysteresis;
+    if (shifted >= FAN_CURVE_STEPS)
+      shifted = FAN_CURVE_STEPS - 1;
+    if (curve[shifted] < duty)
+      duty = curve[shifted];
+  }
+
+  return duty;
+}
+
+uint8_t FanCurveFollower::getDutyCycle(void) {
+  return duty;
+}
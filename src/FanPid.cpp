@@ -0,0 +1,143 @@
+#include "FanPid.h"
+
+// duties are kept in Q16 percent
+#define DUTY_ONE 65536L
+
+FanPid::FanPid() {
+  kp = 4 * 256;
+  ki = 26;      // 0.1 %/(C s)
+  kd = 0;
+  setpoint = 45 * 128;
+  minDuty = 20;
+  maxDuty = 100;
+  slewRate = 0;
+  stallCheck = false;
+  reset(minDuty);
+}
+
+void FanPid::setTunings(int16_t p, int16_t i, int16_t d) {
+  kp = p;
+  ki = i;
+  kd = d;
+}
+
+void FanPid::setSetpoint(int16_t raw) {
+  setpoint = raw;
+}
+
+int16_t FanPid::getSetpoint(void) {
+  return setpoint;
+}
+
+void FanPid::setOutputLimits(uint8_t low, uint8_t high) {
+  if (high > 100)
+    high = 100;
+  if (low > high)
+    low = high;
+  minDuty = low;
+  maxDuty = high;
+  reset(getDutyCycle());
+}
+
+void FanPid::setSlewRate(uint16_t percentPerSecond) {
+  slewRate = percentPerSecond;
+}
+
+void FanPid::setStallCheck(bool flag) {
+  stallCheck = flag;
+  stallTime = 0;
+  kickTime = 0;
+}
+
+// bumpless restart: the integrator carries the whole duty
+void FanPid::reset(uint8_t duty) {
+  if (duty < minDuty)
+    duty = minDuty;
+  if (duty > maxDuty)
+    duty = maxDuty;
+  output = (int32_t) duty * DUTY_ONE;
+  integral = output;
+  derivative = 0;
+  hasLast = false;
+  stallTime = 0;
+  kickTime = 0;
+}
+
+uint8_t FanPid::update(int16_t measured, unsigned int rpm, uint16_t dt) {
+  if (dt == 0)
+    return getDutyCycle();
+
+  int32_t error = (int32_t) measured - setpoint;
+  int32_t low = (int32_t) minDuty * DUTY_ONE;
+  int32_t high = (int32_t) maxDuty * DUTY_ONE;
+
+  // P: kp/256 %/C * error/128 C
+  int64_t p = (int64_t) kp * error * 2;
+
+  // I: ki/256 %/(C s) * error/128 C * dt/1000 s
+  int32_t lastIntegral = integral;
+  integral += (int32_t) (((int64_t) ki * error * dt) / 500);
+  if (integral > high)
+    integral = high;
+  if (integral < 0)
+    integral = 0;
+
+  // D on measurement, smoothed as the probes step in 1/16 C quanta
+  if (hasLast) {
+    int32_t delta = (int32_t) measured - lastMeasured;
+    int32_t d = (int32_t) (((int64_t) kd * delta * 2000) / dt);
+    derivative += (d - derivative) / 4;
+  }
+  lastMeasured = measured;
+  hasLast = true;
+
+  int64_t u = p + integral + derivative;
+
+  // anti-windup: don't integrate further into a saturated output
+  if ((u > high && error > 0) || (u < low && error < 0)) {
+    u -= integral - lastIntegral;
+    integral = lastIntegral;
+  }
+
+  if (u > high)
+    u = high;
+  if (u < low)
+    u = low;
+
+  if (slewRate != 0) {
+    int64_t step = ((int64_t) slewRate * DUTY_ONE * dt) / 1000;
+    if (u > output + step)
+      u = output + step;
+    if (u < output - step)
+      u = output - step;
+  }
+  output = (int32_t) u;
+
+  // a fan that doesn't turn at a duty it should turn at gets a full kick
+  if (stallCheck) {
+    if (kickTime > 0) {
+      kickTime = kickTime > dt ? kickTime - dt : 0;
+      return 100;
+    }
+    if (rpm == 0 && getDutyCycle() >= FAN_PID_STALL_DUTY) {
+      stallTime += dt;
+      if (stallTime >= FAN_PID_STALL_MS) {
+        stallTime = 0;
+        kickTime = FAN_PID_KICK_MS;
+        return 100;
+      }
+    } else {
+      stallTime = 0;
+    }
+  }
+
+  return getDutyCycle();
+}
+
+uint8_t FanPid::getDutyCycle(void) {
+  return (uint8_t) ((output + DUTY_ONE / 2) / DUTY_ONE);
+}
+
+bool FanPid::isStalled(void) {
+  return kickTime > 0;
+}
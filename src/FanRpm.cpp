@@ -0,0 +1,61 @@
+#include "FanRpm.h"
+
+FanTacho::FanTacho() {
+  reset();
+}
+
+void FanTacho::reset(void) {
+  for (uint8_t i = 0; i < FAN_PULSES_PER_REV; i++)
+    edgeTimes[i] = 0;
+  edgeIndex = 0;
+  lastEdge = 0;
+  period = 0;
+}
+
+void IRAM_ATTR FanTacho::edge(uint32_t now) {
+  uint32_t sinceLast = now - lastEdge;
+
+  if (sinceLast < FAN_MIN_EDGE_US)
+    return;
+
+  if (sinceLast > FAN_STALL_TIMEOUT_US) {
+    // restarting from a stall, the history is stale
+    for (uint8_t i = 0; i < FAN_PULSES_PER_REV; i++)
+      edgeTimes[i] = 0;
+    period = 0;
+  } else if (edgeTimes[edgeIndex] != 0) {
+    // the oldest edge was one revolution ago
+    period = now - edgeTimes[edgeIndex];
+  }
+  edgeTimes[edgeIndex] = now;
+  edgeIndex = (edgeIndex + 1) % FAN_PULSES_PER_REV;
+  lastEdge = now;
+}
+
+uint32_t FanTacho::getPeriod(void) {
+  return period;
+}
+
+uint32_t FanTacho::getLastEdge(void) {
+  return lastEdge;
+}
+
+unsigned int FanTacho::rpmFromPeriod(uint32_t period) {
+  if (period == 0)
+    return 0;
+  return 60000000UL / period;
+}
+
+unsigned int FanTacho::rpmFromEdges(uint32_t period, uint32_t lastEdge, uint32_t now) {
+  uint32_t sinceLast = now - lastEdge;
+
+  if (period == 0 || sinceLast > FAN_STALL_TIMEOUT_US)
+    return 0;
+
+  // a fan slowing down already spent longer on this revolution than the
+  // last one took, report the lower bound instead of the stale value
+  if (sinceLast * FAN_PULSES_PER_REV > period)
+    period = sinceLast * FAN_PULSES_PER_REV;
+
+  return rpmFromPeriod(period);
+}
@@ -0,0 +1,92 @@
+#include "FixedTemp.h"
+
+Temp128 FixedTemp::fromCelsius(int16_t celsius) {
+  int32_t t = (int32_t) celsius * TEMP128_ONE_C;
+  if (t > INT16_MAX)
+    return INT16_MAX;
+  if (t <= TEMP128_INVALID)
+    return TEMP128_INVALID + 1;
+  return t;
+}
+
+Temp128 FixedTemp::addOffset(Temp128 t, Temp128 offset) {
+  if (t == TEMP128_INVALID)
+    return TEMP128_INVALID;
+  int32_t sum = (int32_t) t + offset;
+  if (sum > INT16_MAX)
+    return INT16_MAX;
+  if (sum <= TEMP128_INVALID)
+    return TEMP128_INVALID + 1;
+  return sum;
+}
+
+int16_t FixedTemp::toCentiCelsius(Temp128 t) {
+  // t * 100 / 128, rounded half away from zero
+  int32_t c = (int32_t) t * 100;
+  return c >= 0 ? (c + 64) / 128 : -((-c + 64) / 128);
+}
+
+uint8_t FixedTemp::format(char* text, Temp128 t) {
+  // a missing reading reads as DEVICE_DISCONNECTED_C like rawToCelsius()
+  if (t == TEMP128_INVALID)
+    t = -127 * TEMP128_ONE_C;
+
+  int32_t centi = (int32_t) t * 100;
+  centi = centi >= 0 ? (centi + 64) / 128 : -((-centi + 64) / 128);
+
+  char digits[8];
+  uint8_t n = 0;
+  uint8_t length = 0;
+
+  if (centi < 0) {
+    text[length++] = '-';
+    centi = -centi;
+  }
+
+  // at least "0.00"
+  do {
+    digits[n++] = '0' + centi % 10;
+    centi /= 10;
+  } while (centi > 0 || n < 3);
+
+  while (n > 0) {
+    if (n == 2)
+      text[length++] = '.';
+    text[length++] = digits[--n];
+  }
+  text[length] = '\0';
+
+  return length;
+}
+
+TempFilter::TempFilter(uint8_t filterShift) {
+  shift = filterShift;
+  reset();
+}
+
+void TempFilter::reset(void) {
+  primed = false;
+  value = (int32_t) TEMP128_INVALID * 256;
+}
+
+Temp128 TempFilter::update(Temp128 sample) {
+  if (sample == TEMP128_INVALID) {
+    reset();
+    return TEMP128_INVALID;
+  }
+
+  int32_t x = (int32_t) sample * 256;
+  if (!primed) {
+    value = x;
+    primed = true;
+  } else {
+    value += (x - value) >> shift;
+  }
+
+  return getValue();
+}
+
+Temp128 TempFilter::getValue(void) {
+  // round the Q8 value to the nearest 1/128 degree C
+  return (Temp128) ((value + 128) >> 8);
+}
@@ -0,0 +1,334 @@
+#include "Max31865.h"
+#include <math.h>
+#include <string.h>
+
+// fault status bits from the top, the two low bits aren't faults
+static const char* const faultTexts[] = {
+  "RTD high threshold exceeded",
+  "RTD low threshold exceeded",
+  "REFIN- > 0.85 x VBIAS",
+  "REFIN- < 0.85 x VBIAS, FORCE- open",
+  "RTDIN- < 0.85 x VBIAS, FORCE- open",
+  "Overvoltage or undervoltage",
+};
+
+#ifdef ARDUINO
+
+Max31865SpiBus::Max31865SpiBus(SPIClass& spi, uint8_t csPin) : spi(spi) {
+  this->csPin = csPin;
+}
+
+void Max31865SpiBus::begin(int8_t sck, int8_t miso, int8_t mosi) {
+  pinMode(csPin, OUTPUT);
+  digitalWrite(csPin, HIGH);
+  spi.begin(sck, miso, mosi);
+}
+
+// the transaction locks the port, the reader task shares it with the loop.
+// A whole buffer goes through the hardware FIFO in one go.
+void Max31865SpiBus::transfer(uint8_t* data, uint8_t length) {
+  spi.beginTransaction(SPISettings(MAX31865_SPI_CLOCK, MSBFIRST, SPI_MODE1));
+  digitalWrite(csPin, LOW);
+  spi.transfer(data, length);
+  digitalWrite(csPin, HIGH);
+  spi.endTransaction();
+}
+
+#endif
+
+Max31865::Max31865(Max31865Bus* bus, uint8_t drdyPin) {
+  this->bus = bus;
+  this->drdyPin = drdyPin;
+  config = MAX31865_CONFIG_VBIAS | MAX31865_CONFIG_AUTO;
+  lowThreshold = 0x0000;
+  highThreshold = 0x7FFF;
+  readyTime = 0;
+  overruns = 0;
+  suspended = false;
+  memset(registers, 0, sizeof(registers));
+#ifdef ARDUINO
+  task = nullptr;
+  running = false;
+  configLock = nullptr;
+#endif
+}
+
+void Max31865::setThreeWire(bool threeWire) {
+  if (threeWire)
+    config |= MAX31865_CONFIG_3WIRE;
+  else
+    config &= ~MAX31865_CONFIG_3WIRE;
+}
+
+void Max31865::setFilter50Hz(bool filter50Hz) {
+  if (filter50Hz)
+    config |= MAX31865_CONFIG_50HZ;
+  else
+    config &= ~MAX31865_CONFIG_50HZ;
+}
+
+void Max31865::setFaultThresholds(uint16_t low, uint16_t high) {
+  lowThreshold = low;
+  highThreshold = high;
+}
+
+bool Max31865::begin(void) {
+
+  // the filter may only change while the chip doesn't convert
+  uint8_t stopped = config & ~MAX31865_CONFIG_AUTO;
+  writeRegister(MAX31865_REG_CONFIG, 0);
+  writeRegister(MAX31865_REG_CONFIG, stopped);
+
+  writeRegister16(MAX31865_REG_LOW_FAULT_MSB, lowThreshold << 1);
+  writeRegister16(MAX31865_REG_HIGH_FAULT_MSB, highThreshold << 1);
+
+  // an absent chip reads all zeros or all ones, a bad connection garbles,
+  // the bias bit makes the configuration written neither
+  readAll();
+  if (registers[MAX31865_REG_CONFIG] != stopped ||
+      getLowThreshold() != lowThreshold || getHighThreshold() != highThreshold)
+    return false;
+
+  writeRegister(MAX31865_REG_CONFIG, config | MAX31865_CONFIG_FAULT_CLEAR);
+  suspended = false;
+  queue.clear();
+
+#ifdef ARDUINO
+  if (configLock == nullptr)
+    configLock = xSemaphoreCreateMutexStatic(&configLockBuffer);
+  if (drdyPin == MAX31865_NO_DRDY)
+    return true;
+
+  pinMode(drdyPin, INPUT_PULLUP);
+  running = true;
+  TaskHandle_t handle;
+  xTaskCreatePinnedToCore(readerTask, "max31865", MAX31865_TASK_STACK, this,
+                          MAX31865_TASK_PRIORITY, &handle, MAX31865_TASK_CORE);
+  task = handle;
+  attachInterruptArg(digitalPinToInterrupt(drdyPin), onDataReady, this, FALLING);
+#endif
+
+  return true;
+}
+
+void Max31865::end(void) {
+#ifdef ARDUINO
+  // the task may hold the SPI port, it has to leave on its own. It parks
+  // itself once out of service(), its handle stays valid until deleted here.
+  if (drdyPin != MAX31865_NO_DRDY)
+    detachInterrupt(digitalPinToInterrupt(drdyPin));
+  running = false;
+  TaskHandle_t handle = task;
+  if (handle != nullptr) {
+    while (task != nullptr) {
+      xTaskNotifyGive(handle);
+      vTaskDelay(1);
+    }
+    vTaskDelete(handle);
+  }
+#endif
+  writeRegister(MAX31865_REG_CONFIG, config & ~(MAX31865_CONFIG_VBIAS | MAX31865_CONFIG_AUTO));
+}
+
+bool Max31865::read(RtdSample* sample) {
+  return queue.pop(sample);
+}
+
+uint8_t Max31865::available(void) {
+  return queue.available();
+}
+
+uint32_t Max31865::getOverruns(void) {
+  return overruns;
+}
+
+// the address auto-increments, one read from the configuration register
+// covers them all
+uint8_t Max31865::readAll(void) {
+  uint8_t data[MAX31865_REG_COUNT + 1];
+
+  data[0] = MAX31865_REG_CONFIG;
+  memset(data + 1, 0, MAX31865_REG_COUNT);
+  bus->transfer(data, sizeof(data));
+  memcpy(registers, data + 1, MAX31865_REG_COUNT);
+  return getFault();
+}
+
+uint16_t Max31865::getCode(void) {
+  return ((registers[MAX31865_REG_RTD_MSB] << 8) | registers[MAX31865_REG_RTD_MSB + 1]) >> 1;
+}
+
+uint8_t Max31865::getFault(void) {
+  return registers[MAX31865_REG_FAULT_STATUS];
+}
+
+uint16_t Max31865::getLowThreshold(void) {
+  return ((registers[MAX31865_REG_LOW_FAULT_MSB] << 8) | registers[MAX31865_REG_LOW_FAULT_MSB + 1]) >> 1;
+}
+
+uint16_t Max31865::getHighThreshold(void) {
+  return ((registers[MAX31865_REG_HIGH_FAULT_MSB] << 8) | registers[MAX31865_REG_HIGH_FAULT_MSB + 1]) >> 1;
+}
+
+void Max31865::dataReady(uint32_t now) {
+  readyTime = now;
+}
+
+// reading the RTD register releases DRDY, the next conversion pulls it low
+// again. A full queue drops the new sample, the loop keeps the older ones.
+void Max31865::service(void) {
+  RtdSample sample;
+  uint16_t rtd = readRegister16(MAX31865_REG_RTD_MSB);
+
+  sample.code = rtd >> 1;
+  sample.time = readyTime;
+  sample.fault = 0;
+
+  // the fault status latches until cleared, auto conversion goes on. A
+  // fault detection cycle owns the configuration until resume(), the lock
+  // keeps it from starting between the check and the write.
+  if (rtd & 0x0001) {
+    sample.fault = readRegister(MAX31865_REG_FAULT_STATUS);
+    lockConfig();
+    if (!suspended)
+      writeRegister(MAX31865_REG_CONFIG, config | MAX31865_CONFIG_FAULT_CLEAR);
+    unlockConfig();
+  }
+
+  if (!queue.push(sample))
+    overruns++;
+}
+
+// the cycle runs with the bias on and auto conversion off
+void Max31865::startFaultDetection(uint8_t stage) {
+  uint8_t detect = (config & ~(MAX31865_CONFIG_AUTO | MAX31865_FAULT_DETECT_MASK)) | MAX31865_CONFIG_VBIAS;
+  lockConfig();
+  suspended = true;
+  writeRegister(MAX31865_REG_CONFIG, detect | (stage & MAX31865_FAULT_DETECT_MASK));
+  unlockConfig();
+}
+
+bool Max31865::isFaultDetectionDone(void) {
+  return (readRegister(MAX31865_REG_CONFIG) & MAX31865_FAULT_DETECT_MASK) == 0;
+}
+
+uint8_t Max31865::readFaultStatus(void) {
+  return readRegister(MAX31865_REG_FAULT_STATUS) & MAX31865_FAULT_MASK;
+}
+
+void Max31865::resume(void) {
+  lockConfig();
+  writeRegister(MAX31865_REG_CONFIG, config | MAX31865_CONFIG_FAULT_CLEAR);
+  suspended = false;
+  unlockConfig();
+}
+
+const char* Max31865::faultText(uint8_t bit) {
+  if (bit == MAX31865_FAULT_TIMEOUT)
+    return "Fault detection cycle timed out";
+  for (uint8_t i = 0; i < sizeof(faultTexts) / sizeof(faultTexts[0]); i++)
+    if (bit == (MAX31865_FAULT_HIGH_THRESHOLD >> i))
+      return faultTexts[i];
+  return "";
+}
+
+uint32_t Max31865::resistance(uint16_t code, uint16_t referenceOhms) {
+  return ((uint64_t) code * referenceOhms * 1000) >> 15;
+}
+
+// the quadratic solves the equation above 0 C, below it a fit of the
+// inverse normalised to 100 ohm takes over
+float Max31865::temperature(uint16_t code, float nominalOhms, float referenceOhms) {
+  const float a = 3.9083e-3;
+  const float b = -5.775e-7;
+  float rt = code * referenceOhms / 32768.0f;
+
+  float t = (sqrtf(a * a - 4 * b + 4 * b / nominalOhms * rt) - a) / (2 * b);
+  if (t >= 0)
+    return t;
+
+  rt = rt / nominalOhms * 100;
+  float power = rt;
+  t = -242.02f;
+  t += 2.2228f * power;
+  power *= rt;
+  t += 2.5859e-3f * power;
+  power *= rt;
+  t -= 4.8260e-6f * power;
+  power *= rt;
+  t -= 2.8183e-8f * power;
+  power *= rt;
+  t += 1.5243e-10f * power;
+  return t;
+}
+
+#ifdef ARDUINO
+
+void IRAM_ATTR Max31865::onDataReady(void* arg) {
+  Max31865* rtd = (Max31865*) arg;
+  BaseType_t woken = pdFALSE;
+
+  rtd->dataReady(micros());
+  vTaskNotifyGiveFromISR(rtd->task, &woken);
+  if (woken)
+    portYIELD_FROM_ISR();
+}
+
+// SPI can't run in the ISR, the task does the transfer right after the edge
+void Max31865::readerTask(void* arg) {
+  Max31865* rtd = (Max31865*) arg;
+
+  while (rtd->running) {
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MAX31865_DRDY_TIMEOUT_MS)) == 0) {
+      // no edge, a result left unread keeps DRDY low and never falls again
+      if (digitalRead(rtd->drdyPin) != LOW)
+        continue;
+      rtd->dataReady(micros());
+    }
+    if (rtd->running)
+      rtd->service();
+  }
+
+  rtd->task = nullptr;
+  vTaskSuspend(nullptr);
+}
+
+#endif
+
+// a mutex, not a critical section: the write goes over SPI. Nothing to
+// lock without the task.
+void Max31865::lockConfig(void) {
+#ifdef ARDUINO
+  if (configLock != nullptr)
+    xSemaphoreTake(configLock, portMAX_DELAY);
+#endif
+}
+
+void Max31865::unlockConfig(void) {
+#ifdef ARDUINO
+  if (configLock != nullptr)
+    xSemaphoreGive(configLock);
+#endif
+}
+
+uint8_t Max31865::readRegister(uint8_t address) {
+  uint8_t data[2] = { address, 0 };
+  bus->transfer(data, 2);
+  return data[1];
+}
+
+uint16_t Max31865::readRegister16(uint8_t address) {
+  uint8_t data[3] = { address, 0, 0 };
+  bus->transfer(data, 3);
+  return (data[1] << 8) | data[2];
+}
+
+void Max31865::writeRegister(uint8_t address, uint8_t value) {
+  uint8_t data[2] = { (uint8_t) (address | MAX31865_WRITE), value };
+  bus->transfer(data, 2);
+}
+
+void Max31865::writeRegister16(uint8_t address, uint16_t value) {
+  uint8_t data[3] = { (uint8_t) (address | MAX31865_WRITE), (uint8_t) (value >> 8), (uint8_t) value };
+  bus->transfer(data, 3);
+}
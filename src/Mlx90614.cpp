@@ -0,0 +1,180 @@
+#include "Mlx90614.h"
+
+// CRC-8 of a nibble shifted through polynomial 0x07, a byte takes two steps
+static const uint8_t pecNibble[16] = {
+  0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+  0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+#ifdef ARDUINO
+
+Mlx90614WireBus::Mlx90614WireBus(TwoWire& wire) : wire(wire) {}
+
+void Mlx90614WireBus::begin(int sda, int scl) {
+  wire.begin(sda, scl, MLX90614_I2C_CLOCK);
+  wire.setTimeOut(MLX90614_TIMEOUT_MS);
+}
+
+// the repeated start keeps the bus between command and data, the port
+// lock of each call keeps other users out
+bool Mlx90614WireBus::read(uint8_t address, uint8_t command, uint8_t* data, uint8_t length) {
+  wire.beginTransmission(address);
+  wire.write(command);
+  if (wire.endTransmission(false) != 0)
+    return false;
+  if (wire.requestFrom(address, length) != length)
+    return false;
+  for (uint8_t i = 0; i < length; i++)
+    data[i] = wire.read();
+  return true;
+}
+
+#endif
+
+Mlx90614::Mlx90614(Mlx90614Bus* bus, uint8_t address) {
+  this->bus = bus;
+  this->address = address;
+  period = MLX90614_PERIOD_MS;
+  callback = nullptr;
+  callbackArg = nullptr;
+  errors = 0;
+  overruns = 0;
+#ifdef ARDUINO
+  task = nullptr;
+  running = false;
+#endif
+}
+
+void Mlx90614::setPeriod(uint16_t ms) {
+  period = ms;
+}
+
+void Mlx90614::setCallback(Callback callback, void* arg) {
+  this->callback = callback;
+  callbackArg = arg;
+}
+
+// the first pair only proves the sensor is there, it isn't queued
+bool Mlx90614::begin(void) {
+  uint16_t value;
+  if (!readRegister(MLX90614_OBJECT_TEMP, &value) || !readRegister(MLX90614_AMBIENT_TEMP, &value))
+    return false;
+  queue.clear();
+
+#ifdef ARDUINO
+  running = true;
+  TaskHandle_t handle;
+  xTaskCreatePinnedToCore(readerTask, "mlx90614", MLX90614_TASK_STACK, this,
+                          MLX90614_TASK_PRIORITY, &handle, MLX90614_TASK_CORE);
+  task = handle;
+#endif
+
+  return true;
+}
+
+void Mlx90614::end(void) {
+#ifdef ARDUINO
+  // the task may be in the middle of a transfer, it has to leave on its own
+  running = false;
+  while (task != nullptr)
+    vTaskDelay(1);
+#endif
+}
+
+bool Mlx90614::read(IrSample* sample) {
+  return queue.pop(sample);
+}
+
+uint8_t Mlx90614::available(void) {
+  return queue.available();
+}
+
+uint32_t Mlx90614::getErrors(void) {
+  return errors;
+}
+
+uint32_t Mlx90614::getOverruns(void) {
+  return overruns;
+}
+
+// object and ambient back to back, a pair is only good as a whole
+bool Mlx90614::service(uint32_t now) {
+  IrSample sample;
+
+  if (!readRegister(MLX90614_OBJECT_TEMP, &sample.object) ||
+      !readRegister(MLX90614_AMBIENT_TEMP, &sample.ambient)) {
+    errors++;
+    return false;
+  }
+  sample.time = now;
+
+  if (!queue.push(sample)) {
+    overruns++;
+    return false;
+  }
+  if (callback != nullptr)
+    callback(sample, callbackArg);
+  return true;
+}
+
+uint8_t Mlx90614::pec(const uint8_t* data, uint8_t length) {
+  uint8_t crc = 0;
+  while (length--) {
+    crc ^= *data++;
+    crc = (crc << 4) ^ pecNibble[crc >> 4];
+    crc = (crc << 4) ^ pecNibble[crc >> 4];
+  }
+  return crc;
+}
+
+// 0.02 K is exactly 2/100 K
+int32_t Mlx90614::toCentiCelsius(uint16_t raw) {
+  return (int32_t) raw * 2 - 27315;
+}
+
+// c * 128 / 100, rounded half away from zero like FixedTemp
+Temp128 Mlx90614::toTemp128(uint16_t raw) {
+  int32_t c = toCentiCelsius(raw) * 128;
+  int32_t t = c >= 0 ? (c + 50) / 100 : -((-c + 50) / 100);
+  if (t > INT16_MAX)
+    return INT16_MAX;
+  if (t < INT16_MIN)
+    return INT16_MIN;
+  return (Temp128) t;
+}
+
+#ifdef ARDUINO
+
+// fixed rate, a slow transfer doesn't shift the following reads
+void Mlx90614::readerTask(void* arg) {
+  Mlx90614* ir = (Mlx90614*) arg;
+  TickType_t wake = xTaskGetTickCount();
+
+  while (ir->running) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(ir->period));
+    if (ir->running)
+      ir->service(millis());
+  }
+
+  ir->task = nullptr;
+  vTaskDelete(nullptr);
+}
+
+#endif
+
+// SMBus read word: LSB, MSB and the packet error code over the whole
+// transfer, both addresses included
+bool Mlx90614::readRegister(uint8_t command, uint16_t* value) {
+  uint8_t packet[6];
+
+  packet[0] = address << 1;
+  packet[1] = command;
+  packet[2] = (address << 1) | 1;
+  if (!bus->read(address, command, packet + 3, 3))
+    return false;
+  if (pec(packet, 5) != packet[5])
+    return false;
+
+  *value = packet[3] | (packet[4] << 8);
+  return (*value & MLX90614_ERROR_FLAG) == 0;
+}
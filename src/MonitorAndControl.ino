@@ -1,35 +1,37 @@
 
-#include <FanController.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "TempAcquisition.h"
+#include "ResolutionManager.h"
+#include "FanBank.h"
+#include "FanPid.h"
+#include "FanCurve.h"
+#include "FixedTemp.h"
+#include "CommandParser.h"
+#include "Telemetry.h"
 
 //set drivers 
   #include <SPI.h>
   #include <Wire.h>
   #include <SD.h>
 
-// Sensor wire is plugged into port 2 on the Arduino.
+// Tacho (sensor) pins, one per fan header.
 // For a list of available pins on your board,
 // please refer to: https://www.arduino.cc/en/Reference/AttachInterrupt
-#define SENSOR_PIN 21 //pin IO04
-
-//For other sensor pins:
 // tacho 1  pin 21
 // tacho 2  pin 33
 // tacho 3  pin 23
 // tacho 4  pin 19
+#define FAN_COUNT 4
+const uint8_t tachoPins[FAN_COUNT] = { 21, 33, 23, 19 };
 
-// Choose a threshold in milliseconds between readings.
-// A smaller value will give more updated results,
-// while a higher value will give more accurate and smooth readings
-#define SENSOR_THRESHOLD 1000
-
-
-// PWM pin (4th on 4 pin fans)
-#define PWM_PIN 25 // pin IO33
+// PWM pins (4th on 4 pin fans)
+// All headers share the PWM net on IO25 on the current board, give each
+// fan its own pin here once the headers are wired separately.
+const uint8_t pwmPins[FAN_COUNT] = { 25, 25, 25, 25 };
 
-// Initialize library
-FanController fan(SENSOR_PIN, SENSOR_THRESHOLD, PWM_PIN);
+// Fans with interrupt driven speed measurement
+FanBank fans;
 
 // GPIO where the DS18B20 is connected to
 const int oneWireBus = 22;     
@@ -37,89 +39,404 @@ const int oneWireBus = 22;
 // Setup a oneWire instance to communicate with any OneWire devices
 OneWire oneWire(oneWireBus);
 
-// Pass our oneWire reference to Dallas Temperature sensor 
-DallasTemperature sensors(&oneWire);
+// Pass our oneWire reference to Dallas Temperature sensor, the device
+// table is part of the object so nothing comes from the heap
+DallasTemperatureStatic<TEMP_ACQ_MAX_SENSORS> sensors(&oneWire);
+
+// Sample the sensors in the background while the loop keeps running
+TempAcquisition acquisition(&sensors);
+
+// Fan control period in milliseconds, independent of the conversion time
+#define CONTROL_INTERVAL 100
+
+// Period of the human readable status line, the pass of the old blocking
+// loop. Samples come in much faster than anyone reads.
+#define STATUS_INTERVAL 1000
+
+// Read only the temperature bytes of a probe, with a full CRC checked read
+// every FAST_READ_INTERVAL samples or when the value jumps
+#define FAST_READ_INTERVAL 8
+
+// Temperature the fans hold the NUC at, and the duty range they run in
+#define SETPOINT_C 45
+#define MIN_DUTY 20
+#define MAX_DUTY 100
+
+// Largest change of the fan duty in percent per second, keeps the fans
+// from audibly hunting
+#define DUTY_SLEW_RATE 10
+
+// Closed loop fan control
+FanPid pid;
+
+// Fan curves as (degrees C, duty percent) breakpoints, checked at build time
+typedef FanCurve<30, 20, 70, 100> LinearCurve;
+typedef FanCurve<35, 20, 50, 35, 60, 60, 70, 100> QuietCurve;
+
+// Curves follow the temperature down only after it dropped this many
+// 0.5 degree C table steps
+#define CURVE_HYSTERESIS 4
+
+// Control law a fan starts on: 0 the PID controller, 1.. a curve of curveTables
+#define DEFAULT_CURVE 0
+#define CURVE_COUNT 2
+const uint8_t* const curveTables[CURVE_COUNT] = { LinearCurve::table(), QuietCurve::table() };
+
+// Probes switch to fast, coarse conversions near these temperatures
+const int16_t curveBreakpoints[] = {
+  (int16_t) LinearCurve::tempRaw(0), (int16_t) LinearCurve::tempRaw(1),
+  (int16_t) QuietCurve::tempRaw(0), (int16_t) QuietCurve::tempRaw(1),
+  (int16_t) QuietCurve::tempRaw(2), (int16_t) QuietCurve::tempRaw(3)
+};
+
+// Coarse and fast probes while the temperature moves, fine ones when steady
+ResolutionManager resolution(&sensors);
+
+FanCurveFollower curves[FAN_COUNT];
+uint8_t fanCurve[FAN_COUNT];
+
+// Duty set over serial per fan, -1 for automatic control
+int8_t manualDuty[FAN_COUNT];
+
+// Operator commands from the serial port
+CommandParser parser;
+
+// Binary telemetry instead of the text lines, and its period in milliseconds
+#define TELEMETRY_INTERVAL 50
+bool telemetryMode = false;
+unsigned long lastTelemetry = 0;
 
 int speed =20;
 int adjustetemp=0;
 
+// Temperatures stay in 1/128 degrees C from the probe to the fans
+Temp128 temperatureOffset = 0;
+Temp128 temperature = TEMP128_INVALID;
+TempFilter temperatureFilter;
+unsigned long lastControl = 0;
+unsigned long lastStatus = 0;
+
 /*
    The setup function. We only start the library here
 */
 void setup(void)
 {
-  // setup Tacho pins.
-  pinMode(21,INPUT_PULLUP);
-  pinMode(33,INPUT_PULLUP);
-  pinMode(23,INPUT_PULLUP);
-  pinMode(19,INPUT_PULLUP);
-
   // start serial port
   Serial.begin(115200);
 
-  // Start up Fan library
-  fan.begin();
+  // Start up the fans, this also sets up the tacho pins
+  for (uint8_t i = 0; i < FAN_COUNT; i++)
+    fans.addFan(tachoPins[i], pwmPins[i]);
+  fans.begin();
 
   // set min speed at startup
-  fan.setDutyCycle(speed);
+  fans.setDutyCycle(speed);
+
+  // Start the controller at the startup speed
+  pid.setSetpoint(SETPOINT_C * 128);
+  pid.setOutputLimits(MIN_DUTY, MAX_DUTY);
+  pid.setSlewRate(DUTY_SLEW_RATE);
+  pid.setStallCheck(true);
+  pid.reset(speed);
+
+  // Curves start on the former linear 30-70 degree C law
+  for (uint8_t i = 0; i < FAN_COUNT; i++) {
+    fanCurve[i] = DEFAULT_CURVE;
+    curves[i].setCurve(curveTables[DEFAULT_CURVE > 0 ? DEFAULT_CURVE - 1 : 0], CURVE_HYSTERESIS);
+    manualDuty[i] = -1;
+  }
 
   // Start the DS18B20 sensor
   sensors.begin();
+  sensors.setFastRead(FAST_READ_INTERVAL);
+  acquisition.setMode(TempAcquisition::MODE_PIPELINED);
+  acquisition.begin();
+  resolution.setBreakpoints(curveBreakpoints, sizeof(curveBreakpoints) / sizeof(curveBreakpoints[0]));
+  resolution.begin();
+
+  lastControl = millis();
 }
 
 /*
-   Main function, get and show the temperature, duty cycle and speed
+   Print duty cycles and settings
 */
-void loop(void)
+void printStatus(void)
 {
-    //Call temperature sensors data
-  sensors.requestTemperatures(); 
-  float temperatureC = sensors.getTempCByIndex(0);
-
-  // Call fan.getSpeed() to get fan RPM.
-  unsigned int rpms = fan.getSpeed(); // Send the command to get RPM
+  char text[TEMP128_TEXT_SIZE];
 
-  //Serial print data  
-  Serial.print("Current speed: ");
-  Serial.print(rpms);
-  Serial.print("RPM");
+  Serial.print("Duty cycle: ");
+  for (uint8_t i = 0; i < FAN_COUNT; i++) {
+    if (i > 0)
+      Serial.print("/");
+    Serial.print(fans.getDutyCycle(i), DEC);
+    // a fan on a shared output runs at the highest duty asked for on it
+    if (fans.getRequestedDutyCycle(i) != fans.getDutyCycle(i)) {
+      Serial.print("(");
+      Serial.print(fans.getRequestedDutyCycle(i), DEC);
+      Serial.print(")");
+    }
+  }
   Serial.print("\t");
-  Serial.print("Real temperature:");
-  Serial.print(temperatureC);
+  Serial.print("Curve: ");
+  for (uint8_t i = 0; i < FAN_COUNT; i++) {
+    if (i > 0)
+      Serial.print("/");
+    if (manualDuty[i] >= 0)
+      Serial.print("F");
+    else
+      Serial.print(fanCurve[i], DEC);
+  }
+  Serial.print("\t");
+  Serial.print("Setpoint: ");
+  FixedTemp::format(text, pid.getSetpoint());
+  Serial.print(text);
   Serial.print("ºC");
+  Serial.print("\t");
+  Serial.print("Adjusted temperature: ");
+  Serial.println(adjustetemp, DEC);
+}
 
-  //calculate adjusted temperature
-  temperatureC =temperatureC+adjustetemp;
+/*
+   Print the 1-Wire bus cost of the DallasTemperature functions called so far
+*/
+void printBusStats(void)
+{
+#if REQUIRESSTATS
+  DallasStats stats[DALLAS_STATS_COUNT];
+  sensors.getStats(stats);
 
-  //Print new data
-  Serial.print("\t");
-  Serial.print("Adjusted temperature:");
-  Serial.print(temperatureC);
-  Serial.println("ºC");
+  Serial.println("function\tcalls\tresets\twrite\tread\tbytes\tcrc\tus");
+  for (uint8_t i = 0; i < DALLAS_STATS_COUNT; i++) {
+    if (stats[i].calls == 0)
+      continue;
+    Serial.print(DallasTemperature::getStatsName(i));
+    Serial.print("\t");
+    Serial.print(stats[i].calls);
+    Serial.print("\t");
+    Serial.print(stats[i].resets);
+    Serial.print("\t");
+    Serial.print(stats[i].writeSlots);
+    Serial.print("\t");
+    Serial.print(stats[i].readSlots);
+    Serial.print("\t");
+    Serial.print(stats[i].bytes);
+    Serial.print("\t");
+    Serial.print(stats[i].crcs);
+    Serial.print("\t");
+    Serial.println(stats[i].micros);
+  }
+#else
+  Serial.println("Bus statistics not compiled in");
+#endif
+}
+
+/*
+   Apply a command received on the serial port
+*/
+void handleCommand(const Command& command)
+{
+  int16_t fan = -1;
+  int16_t value = command.args[command.argc > 0 ? command.argc - 1 : 0];
+
+  // commands for one fan carry its number, 1 to FAN_COUNT, first
+  if (command.type == CMD_FAN_DUTY || (command.type == CMD_CURVE && command.argc == 2)) {
+    fan = command.args[0] - 1;
+    if (fan < 0 || fan >= FAN_COUNT) {
+      Serial.println("Unknown fan");
+      return;
+    }
+  }
+
+  switch (command.type) {
+  case CMD_OFFSET:
+    adjustetemp = value;
+    temperatureOffset = FixedTemp::fromCelsius(adjustetemp);
+    temperatureFilter.reset();
+    break;
+
+  case CMD_SETPOINT:
+    pid.setSetpoint(FixedTemp::fromCelsius(value));
+    break;
+
+  case CMD_CURVE:
+    if (value < 0 || value > CURVE_COUNT) {
+      Serial.println("Unknown curve");
+      return;
+    }
+    for (uint8_t i = 0; i < FAN_COUNT; i++) {
+      if (fan >= 0 && i != fan)
+        continue;
+      fanCurve[i] = value;
+      if (value > 0)
+        curves[i].setCurve(curveTables[value - 1], CURVE_HYSTERESIS);
+    }
+    break;
+
+  case CMD_FAN_DUTY:
+    if (value < -1 || value > 100) {
+      Serial.println("Duty out of range");
+      return;
+    }
+    manualDuty[fan] = value;
+    break;
+
+  case CMD_TELEMETRY:
+    telemetryMode = (value != 0);
+    break;
+
+  case CMD_STATS:
+#if REQUIRESSTATS
+    if (command.argc == 1) {
+      sensors.resetStats();
+      return;
+    }
+#endif
+    printBusStats();
+    return;
+
+  case CMD_STATUS:
+    break;
+
+  default:
+    Serial.println("Unknown command");
+    return;
+  }
+
+  printStatus();
+}
+
+/*
+   Send one binary telemetry frame, skipped when the UART can't take it
+   without waiting
+*/
+void sendTelemetry(unsigned long now)
+{
+  TelemetryFrame frame;
+  uint8_t buffer[TELEMETRY_FRAME_SIZE];
 
+  frame.timestamp = now;
+  frame.flags = 0;
+  for (uint8_t i = 0; i < TELEMETRY_TEMPS; i++)
+    frame.temperatures[i] = i < acquisition.getSensorCount() ? acquisition.getTemp(i) : 0;
+  for (uint8_t i = 0; i < TELEMETRY_FANS; i++) {
+    frame.rpm[i] = i < FAN_COUNT ? fans.getSpeed(i) : 0;
+    frame.duty[i] = i < FAN_COUNT ? fans.getDutyCycle(i) : 0;
+    if (i < FAN_COUNT && fans.isSharedOutput(i))
+      frame.flags |= TELEMETRY_FLAG_SHARED(i);
+    if (i < FAN_COUNT && manualDuty[i] >= 0)
+      frame.flags |= TELEMETRY_FLAG_MANUAL(i);
+    else if (i < FAN_COUNT && fanCurve[i] > 0)
+      frame.flags |= TELEMETRY_FLAG_CURVE(i);
+  }
+  if (temperature == TEMP128_INVALID)
+    frame.flags |= TELEMETRY_FLAG_NO_PROBE;
+  if (pid.isStalled())
+    frame.flags |= TELEMETRY_FLAG_STALL;
+
+  uint8_t length = Telemetry::encode(frame, buffer);
+  if (Serial.availableForWrite() >= length)
+    Serial.write(buffer, length);
+}
+
+/*
+   Main function, get and show the temperature, duty cycle and speed
+*/
+void loop(void)
+{
+  unsigned long now = millis();
+
+  //Collect a finished conversion and start the next one, never waits
+  acquisition.update(now);
+  bool fresh = acquisition.isFresh(0);
+
+  //Adapt the resolution of every probe that delivered a sample
+  for (uint8_t i = 0; i < acquisition.getSensorCount(); i++) {
+    if (acquisition.isFresh(i))
+      resolution.update(i, FixedTemp::addOffset(acquisition.getTemp(i), temperatureOffset), now);
+  }
 
-  //Map temperature form 30-70 to fanspeed PWM from 20 to 100
-  speed=map(temperatureC, 30,70,20,100);
+  if (fresh) {
+    Temp128 raw = acquisition.getTemp(0);
 
-  // Set fan duty cycle
-  fan.setDutyCycle(speed);
+    //calculate adjusted and smoothed temperature
+    temperature = temperatureFilter.update(FixedTemp::addOffset(raw, temperatureOffset));
+  }
 
-  // Get new temperature from Serial (0-50 degree)
-  if (Serial.available() > 0) {
-    // Parse adjustment for temperature
-    adjustetemp = Serial.parseInt();
+  //Human readable status line with the latest sample, once per STATUS_INTERVAL
+  if (fresh && !telemetryMode && now - lastStatus >= STATUS_INTERVAL) {
+    char text[TEMP128_TEXT_SIZE];
+    lastStatus = now;
+    Temp128 raw = acquisition.getTemp(0);
 
-    // Print obtained value
-    Serial.print("Duty cycle: ");
-    Serial.print(speed, DEC);
+    //Serial print data, fans.getSpeed() returns the RPM of a fan
+    Serial.print("Current speed: ");
+    for (uint8_t i = 0; i < FAN_COUNT; i++) {
+      if (i > 0)
+        Serial.print("/");
+      Serial.print(fans.getSpeed(i));
+    }
+    Serial.print("RPM");
     Serial.print("\t");
-    Serial.print("Adjusted temperature: ");
-    Serial.println(adjustetemp, DEC);
-    
-    // set new speed
-    fan.setDutyCycle(speed);
+    Serial.print("Real temperature:");
+    FixedTemp::format(text, raw);
+    Serial.print(text);
+    Serial.print("ºC");
 
+    //Print new data
+    Serial.print("\t");
+    Serial.print("Adjusted temperature:");
+    FixedTemp::format(text, temperature);
+    Serial.print(text);
+    Serial.println("ºC");
   }
 
-  delay(1000);
+  // Fan control tick
+  if (now - lastControl >= CONTROL_INTERVAL) {
+    uint16_t dt = now - lastControl;
+    lastControl = now;
+
+    // Fastest fan on the controller tells it whether its fans turn at all,
+    // its stall check then sees the duty they actually run at. Fans on a
+    // curve or a fixed duty don't count.
+    bool pidInUse = false;
+    unsigned int rpms = 0;
+    for (uint8_t i = 0; i < FAN_COUNT; i++) {
+      if (manualDuty[i] >= 0 || fanCurve[i] > 0)
+        continue;
+      pidInUse = true;
+      if (fans.getSpeed(i) > rpms)
+        rpms = fans.getSpeed(i);
+    }
+
+    // Hold the adjusted temperature at the setpoint, full speed without a
+    // probe. A controller without fans restarts from its last duty.
+    if (temperature == TEMP128_INVALID)
+      speed = MAX_DUTY;
+    else if (pidInUse)
+      speed = pid.update(temperature, rpms, dt);
+    else
+      pid.reset(speed);
+
+    // Each fan runs on the controller, its curve or a fixed duty
+    for (uint8_t i = 0; i < FAN_COUNT; i++) {
+      uint8_t duty = speed;
+      if (manualDuty[i] >= 0)
+        duty = manualDuty[i];
+      else if (fanCurve[i] > 0 && temperature != TEMP128_INVALID)
+        duty = curves[i].update(temperature);
+      fans.setDutyCycle(i, duty);
+    }
+  }
+
+  // Stream telemetry at a fixed rate
+  if (telemetryMode && now - lastTelemetry >= TELEMETRY_INTERVAL) {
+    lastTelemetry = now;
+    sendTelemetry(now);
+  }
+
+  // Handle operator commands, only the bytes already received
+  while (Serial.available() > 0) {
+    if (parser.feed(Serial.read()))
+      handleCommand(parser.getCommand());
+  }
 }
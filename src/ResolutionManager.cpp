@@ -0,0 +1,95 @@
+#include "ResolutionManager.h"
+
+ResolutionManager::ResolutionManager(DallasTemperature* sensors) {
+  _sensors = sensors;
+  sensorCount = 0;
+  breakpointCount = 0;
+}
+
+void ResolutionManager::setBreakpoints(const int16_t* raw, uint8_t count) {
+  if (count > RESOLUTION_MAX_BREAKPOINTS)
+    count = RESOLUTION_MAX_BREAKPOINTS;
+  for (uint8_t i = 0; i < count; i++)
+    breakpoints[i] = raw[i];
+  breakpointCount = count;
+}
+
+void ResolutionManager::begin(void) {
+
+  sensorCount = _sensors->getDeviceCount();
+  if (sensorCount > RESOLUTION_MAX_SENSORS)
+    sensorCount = RESOLUTION_MAX_SENSORS;
+
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    Sensor& sensor = sensors[i];
+    DeviceAddress address;
+    sensor.adjustable = _sensors->getAddress(address, i)
+        && _sensors->validFamily(address) && address[0] != DS18S20MODEL;
+    sensor.resolution = sensor.adjustable ? _sensors->getResolution(address) : 12;
+    sensor.referenceRaw = DEVICE_DISCONNECTED_RAW;
+    sensor.referenceTime = 0;
+    sensor.holdSince = 0;
+  }
+}
+
+bool ResolutionManager::update(uint8_t index, int16_t raw, unsigned long now) {
+
+  if (index >= sensorCount || !sensors[index].adjustable || raw == DEVICE_DISCONNECTED_RAW)
+    return false;
+
+  Sensor& sensor = sensors[index];
+
+  // the first sample only opens the change window
+  if (sensor.referenceRaw == DEVICE_DISCONNECTED_RAW) {
+    sensor.referenceRaw = raw;
+    sensor.referenceTime = now;
+    sensor.holdSince = now;
+    return false;
+  }
+
+  int32_t delta = (int32_t) raw - sensor.referenceRaw;
+  bool fast = delta >= RESOLUTION_FAST_DELTA || delta <= -RESOLUTION_FAST_DELTA;
+  if (fast || now - sensor.referenceTime >= RESOLUTION_WINDOW_MS) {
+    sensor.referenceRaw = raw;
+    sensor.referenceTime = now;
+  }
+
+  uint8_t wanted = target(fast, isNearBreakpoint(raw));
+  if (wanted <= sensor.resolution)
+    sensor.holdSince = now;
+  if (wanted == sensor.resolution || (wanted > sensor.resolution && now - sensor.holdSince < RESOLUTION_SETTLE_MS))
+    return false;
+
+  DeviceAddress address;
+  if (!_sensors->getAddress(address, index))
+    return false;
+
+  // the global resolution is recomputed from the library's cache, no bus
+  // traffic beyond the write itself
+  if (!_sensors->setResolution(address, wanted, false, false))
+    return false;
+
+  sensor.resolution = wanted;
+  return true;
+}
+
+uint8_t ResolutionManager::getResolution(uint8_t index) {
+  return index < sensorCount ? sensors[index].resolution : 12;
+}
+
+uint8_t ResolutionManager::target(bool fast, bool nearBreakpoint) {
+  if (fast)
+    return 9;
+  if (nearBreakpoint)
+    return 10;
+  return 12;
+}
+
+bool ResolutionManager::isNearBreakpoint(int16_t raw) {
+  for (uint8_t i = 0; i < breakpointCount; i++) {
+    int32_t distance = (int32_t) raw - breakpoints[i];
+    if (distance <= RESOLUTION_BREAKPOINT_MARGIN && distance >= -RESOLUTION_BREAKPOINT_MARGIN)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,27 @@
+#include "RtdConversion.h"
+
+#define RTD_STEP_MILLI ((int32_t) RTD_TABLE_STEP_C * 1000)
+
+// binary search for the step around the code, a fixed number of rounds
+// whatever the code, then linear interpolation. Both differences drop 8
+// fraction bits so the product stays in 32 bits.
+int32_t rtdTableLookup(const uint32_t* table, uint16_t code) {
+  uint32_t x = (uint32_t) code << 16;
+
+  if (x <= table[0])
+    return (int32_t) RTD_TABLE_MIN_C * 1000;
+  if (x >= table[RTD_TABLE_STEPS - 1])
+    return (int32_t) RTD_TABLE_MIN_C * 1000 + (int32_t) (RTD_TABLE_STEPS - 1) * RTD_STEP_MILLI;
+
+  // last step starting at or below the code
+  unsigned step = 0;
+  for (unsigned count = RTD_TABLE_STEPS; count > 1; count -= count / 2) {
+    unsigned half = count / 2;
+    step = table[step + half] <= x ? step + half : step;
+  }
+
+  uint32_t span = (table[step + 1] - table[step]) >> 8;
+  uint32_t offset = (x - table[step]) >> 8;
+  return (int32_t) RTD_TABLE_MIN_C * 1000 + (int32_t) step * RTD_STEP_MILLI
+         + (int32_t) ((RTD_STEP_MILLI * offset + span / 2) / span);
+}
@@ -0,0 +1,104 @@
+#include "RtdFaultSupervisor.h"
+
+RtdFaultSupervisor::RtdFaultSupervisor(Max31865* rtd) {
+  this->rtd = rtd;
+  state = MEASURING;
+  interval = RTD_FAULT_INTERVAL_MS;
+  settleTime = RTD_FAULT_SETTLE_MS;
+  maxStep = 0;
+  requested = true;
+  suspect = false;
+  primed = false;
+  lastCode = 0;
+  lastCycle = 0;
+  stateStart = 0;
+  faults = 0;
+  cycles = 0;
+}
+
+void RtdFaultSupervisor::setInterval(uint32_t ms) {
+  interval = ms;
+}
+
+void RtdFaultSupervisor::setSettleTime(uint8_t ms) {
+  settleTime = ms;
+}
+
+void RtdFaultSupervisor::setMaxStep(uint16_t codes) {
+  maxStep = codes;
+}
+
+// an open input reads full scale, a shorted one zero
+void RtdFaultSupervisor::check(uint16_t code, uint8_t fault) {
+  if (state != MEASURING)
+    return;
+
+  if (fault != 0 || code == 0 || code >= 0x7FFF)
+    suspect = true;
+
+  if (primed && maxStep != 0) {
+    uint16_t step = code > lastCode ? code - lastCode : lastCode - code;
+    if (step > maxStep)
+      suspect = true;
+  }
+
+  lastCode = code;
+  primed = true;
+}
+
+void RtdFaultSupervisor::request(void) {
+  requested = true;
+}
+
+// manual detection: stage 1 charges the input filter, stage 2 checks the
+// inputs once it settled, the chip clears the stage bits when it is done
+void RtdFaultSupervisor::update(uint32_t now) {
+  switch (state) {
+  case MEASURING:
+    if (!requested && !(suspect && now - lastCycle >= RTD_FAULT_RETRY_MS)
+        && (interval == 0 || now - lastCycle < interval))
+      return;
+    requested = false;
+    suspect = false;
+    rtd->startFaultDetection(MAX31865_FAULT_DETECT_MANUAL_1);
+    stateStart = now;
+    state = SETTLING;
+    break;
+
+  case SETTLING:
+    if (now - stateStart < settleTime)
+      return;
+    rtd->startFaultDetection(MAX31865_FAULT_DETECT_MANUAL_2);
+    stateStart = now;
+    state = DETECTING;
+    break;
+
+  case DETECTING:
+    if (rtd->isFaultDetectionDone())
+      faults = rtd->readFaultStatus();
+    else if (now - stateStart >= RTD_FAULT_TIMEOUT_MS)
+      // the status of a cycle that didn't finish means nothing
+      faults = MAX31865_FAULT_TIMEOUT;
+    else
+      return;
+    rtd->resume();
+    // the reading after the cycle is compared with nothing
+    primed = false;
+    lastCycle = now;
+    cycles++;
+    state = MEASURING;
+    break;
+  }
+}
+
+bool RtdFaultSupervisor::isMeasuring(void) {
+  return state == MEASURING;
+}
+
+uint8_t RtdFaultSupervisor::getFaults(void) {
+  return faults;
+}
+
+uint32_t RtdFaultSupervisor::getCycleCount(void) {
+  return cycles;
+}
@@ -0,0 +1,59 @@
+#include "Telemetry.h"
+
+static uint8_t put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return 2;
+}
+
+uint8_t Telemetry::encode(const TelemetryFrame& frame, uint8_t* buffer) {
+  uint8_t payload[TELEMETRY_PAYLOAD_SIZE + 2];
+  uint8_t n = 0;
+
+  payload[n++] = TELEMETRY_VERSION;
+  n += put16(payload + n, frame.timestamp & 0xFFFF);
+  n += put16(payload + n, frame.timestamp >> 16);
+  for (uint8_t i = 0; i < TELEMETRY_TEMPS; i++)
+    n += put16(payload + n, (uint16_t) frame.temperatures[i]);
+  for (uint8_t i = 0; i < TELEMETRY_FANS; i++)
+    n += put16(payload + n, frame.rpm[i]);
+  for (uint8_t i = 0; i < TELEMETRY_FANS; i++)
+    payload[n++] = frame.duty[i];
+  n += put16(payload + n, frame.flags);
+
+  n += put16(payload + n, crc16(payload, n));
+
+  uint8_t length = cobsEncode(payload, n, buffer);
+  buffer[length++] = 0;
+  return length;
+}
+
+uint16_t Telemetry::crc16(const uint8_t* data, uint8_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc ^= (uint16_t) *data++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+uint8_t Telemetry::cobsEncode(const uint8_t* data, uint8_t length, uint8_t* out) {
+  uint8_t code = 1;
+  uint8_t codeIndex = 0;
+  uint8_t n = 1;
+
+  for (uint8_t i = 0; i < length; i++) {
+    if (data[i] == 0) {
+      out[codeIndex] = code;
+      codeIndex = n++;
+      code = 1;
+    } else {
+      out[n++] = data[i];
+      code++;
+    }
+  }
+  out[codeIndex] = code;
+
+  return n;
+}
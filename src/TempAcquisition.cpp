@@ -0,0 +1,181 @@
+#include "TempAcquisition.h"
+
+#include <string.h>
+
+#if ARDUINO >= 100
+#include <Arduino.h>
+#else
+#include <WConstants.h>
+#endif
+
+TempAcquisition::TempAcquisition(DallasTemperature* sensors) {
+  _sensors = sensors;
+  state = ACQ_IDLE;
+  mode = MODE_BROADCAST;
+  conversionStart = 0;
+  conversionTime = 0;
+  pollForCompletion = false;
+  armed = false;
+  lastRefresh = 0;
+  sensorCount = 0;
+  for (uint8_t i = 0; i < TEMP_ACQ_MAX_SENSORS; i++) {
+    temperatures[i] = DEVICE_DISCONNECTED_RAW;
+    fresh[i] = false;
+  }
+}
+
+void TempAcquisition::setMode(Mode newMode) {
+  mode = newMode;
+}
+
+TempAcquisition::Mode TempAcquisition::getMode(void) {
+  return mode;
+}
+
+void TempAcquisition::begin(void) {
+
+  // requestTemperatures() returns right after the convert command
+  _sensors->setWaitForConversion(false);
+
+  sensorCount = _sensors->getDeviceCount();
+  if (sensorCount > TEMP_ACQ_MAX_SENSORS)
+    sensorCount = TEMP_ACQ_MAX_SENSORS;
+
+  // a parasite powered bus can't signal completion, the data line is held
+  // by the conversion current, so wait the datasheet time instead
+  pollForCompletion = _sensors->getCheckForConversion() && !_sensors->isParasitePowerMode();
+
+#if !REQUIRESALARMS
+  if (mode == MODE_ALARM)
+    mode = MODE_BROADCAST;
+#endif
+  if (mode == MODE_PIPELINED && !_sensors->startPipeline())
+    mode = MODE_BROADCAST;
+
+  armed = false;
+  state = mode == MODE_PIPELINED ? ACQ_PIPELINED : ACQ_IDLE;
+}
+
+bool TempAcquisition::update(unsigned long now) {
+
+  for (uint8_t i = 0; i < sensorCount; i++)
+    fresh[i] = false;
+
+  switch (state) {
+  case ACQ_IDLE:
+    startConversion();
+    return false;
+
+  case ACQ_CONVERTING: {
+    // isConversionComplete() costs a single read slot, it is only valid
+    // while nothing else talks on the bus during the conversion. now may
+    // predate conversionStart when it was taken before the last update()
+    if ((long) (now - conversionStart) < (long) conversionTime &&
+        !(pollForCompletion && _sensors->isConversionComplete()))
+      return false;
+
+    bool updated = true;
+    if (mode == MODE_ALARM && armed && now - lastRefresh < TEMP_ACQ_REFRESH_MS) {
+      updated = collectAlarms();
+    } else {
+      collect();
+      if (mode == MODE_ALARM) {
+        DeviceAddress address;
+        for (uint8_t i = 0; i < sensorCount; i++) {
+          if (_sensors->getAddress(address, i))
+            arm(i, address);
+        }
+        armed = true;
+        lastRefresh = now;
+      }
+    }
+    startConversion();
+    return updated;
+  }
+
+  case ACQ_PIPELINED: {
+    uint8_t index;
+    int16_t raw;
+    if (!_sensors->pollPipeline(&index, &raw) || index >= sensorCount)
+      return false;
+    temperatures[index] = raw;
+    fresh[index] = true;
+    return true;
+  }
+  }
+
+  return false;
+}
+
+void TempAcquisition::startConversion(void) {
+  _sensors->requestTemperatures();
+  // timed from the end of the convert command, not from the update() that
+  // may have spent tens of ms collecting the previous results, or the bus
+  // is read before the probes have latched the new values and alarm flags
+  conversionStart = millis();
+  conversionTime = _sensors->millisToWaitForConversion();
+  state = ACQ_CONVERTING;
+}
+
+void TempAcquisition::collect(void) {
+  _sensors->readAllTemperatures(temperatures, nullptr, sensorCount);
+  for (uint8_t i = 0; i < sensorCount; i++)
+    fresh[i] = true;
+}
+
+// reads and re-arms only the probes that raised their alarm, one alarm
+// search instead of a read per probe when nothing moved
+bool TempAcquisition::collectAlarms(void) {
+  bool updated = false;
+#if REQUIRESALARMS
+  DeviceAddress alarming[TEMP_ACQ_MAX_SENSORS];
+  DeviceAddress probe;
+  uint8_t count;
+
+  _sensors->resetAlarmSearch();
+  do {
+    count = _sensors->alarmSweep(alarming, TEMP_ACQ_MAX_SENSORS);
+    for (uint8_t n = 0; n < count; n++) {
+      for (uint8_t i = 0; i < sensorCount; i++) {
+        if (!_sensors->getAddress(probe, i) || memcmp(probe, alarming[n], sizeof(DeviceAddress)) != 0)
+          continue;
+        temperatures[i] = _sensors->getTemp(alarming[n]);
+        fresh[i] = true;
+        updated = true;
+        arm(i, alarming[n]);
+        break;
+      }
+    }
+  } while (count == TEMP_ACQ_MAX_SENSORS);
+#endif
+  return updated;
+}
+
+// alarm window of whole degrees around the probe's value, the probe
+// compares the integer part of its reading against TH and TL
+void TempAcquisition::arm(uint8_t index, const uint8_t* address) {
+#if REQUIRESALARMS
+  if (temperatures[index] == DEVICE_DISCONNECTED_RAW)
+    return;
+  int16_t whole = temperatures[index] >> 7;
+  _sensors->setAlarmWindow(address, whole - TEMP_ACQ_ALARM_WINDOW - 1, whole + TEMP_ACQ_ALARM_WINDOW + 1);
+#endif
+}
+
+uint8_t TempAcquisition::getSensorCount(void) {
+  return sensorCount;
+}
+
+int16_t TempAcquisition::getTemp(uint8_t index) {
+  if (index >= sensorCount)
+    return DEVICE_DISCONNECTED_RAW;
+  return temperatures[index];
+}
+
+bool TempAcquisition::isFresh(uint8_t index) {
+  return index < sensorCount && fresh[index];
+}
+
+bool TempAcquisition::isConverting(void) {
+  return state != ACQ_IDLE;
+}
@@ -14,35 +14,59 @@
   BSD license, all text above must be included in any redistribution
  ****************************************************/
 
-#include <Adafruit_MAX31865.h>
+#include <SPI.h>
 #include <M5StickC.h>
+#include "Max31865.h"
+#include "RtdConversion.h"
 
-// Use software SPI: CS, DI, DO, CLK
+// Hardware SPI on VSPI, the chip is the only device on the port
 // Modified for M5StickC:
-// original: Adafruit_MAX31865 thermo = Adafruit_MAX31865(10, 11, 12, 13);
-//Connect the CLK pin to Digital #13 but any pin can be used later   M5StickC G26               ESP32-dev-v4.1 IO18
-//Connect the SDO pin to Digital #12 but any pin can be used later   M5StickC G36 (input only)  ESP32-dev-v4.1 IO5
-//Connect the SDI pin to Digital #11 but any pin can be used later   M5StickC G33               ESP32-dev-v4.1 IO10
-//Connect the CS pin Digital #10 but any pin can be used later       M5StickC G32               ESP32-dev-v4.1 IO9
-
-// Use software SPI: CS, DI, DO, CLK
-// Adafruit_MAX31865 thermo = Adafruit_MAX31865(32, 33, 36, 26);//for M5stickC
-Adafruit_MAX31865 thermo = Adafruit_MAX31865(9,10,5,18);//for ESP32Pico-dev-V4.1
-// use hardware SPI, just pass in the CS pin
-//Adafruit_MAX31865 thermo = Adafruit_MAX31865(10);
-
-// The value of the Rref resistor. Use 430.0 for PT100 and 4300.0 for PT1000
-#define RREF      430.0
+//Connect the CLK pin                M5StickC G26               ESP32-dev-v4.1 IO18
+//Connect the SDO pin                M5StickC G36 (input only)  ESP32-dev-v4.1 IO5
+//Connect the SDI pin                M5StickC G33               ESP32-dev-v4.1 IO10
+//Connect the CS pin                 M5StickC G32               ESP32-dev-v4.1 IO9
+// DRDY isn't connected, the chip converts continuously and is polled
+
+// CS, SDI, SDO, CLK
+// #define RTD_CS 32
+// #define RTD_MOSI 33
+// #define RTD_MISO 36
+// #define RTD_SCK 26 //for M5stickC
+#define RTD_CS 9
+#define RTD_MOSI 10
+#define RTD_MISO 5
+#define RTD_SCK 18 //for ESP32Pico-dev-V4.1
+
+SPIClass vspi(VSPI);
+Max31865SpiBus rtdBus(vspi, RTD_CS);
+Max31865 thermo(&rtdBus, MAX31865_NO_DRDY);
+
+// The value of the Rref resistor. Use 430 for PT100 and 4300 for PT1000
+#define RREF      430
 // The 'nominal' 0-degrees-C resistance of the sensor
-// 100.0 for PT100, 1000.0 for PT1000
-#define RNOMINAL  100.0
+// 100 for PT100, 1000 for PT1000
+#define RNOMINAL  100
+
+// integer conversion table for this sensor and reference
+typedef RtdConversion<RNOMINAL, RREF> Rtd;
+
+// milli degrees C as text with two decimals
+void formatMilli(char* text, int32_t milli) {
+  int32_t centi = (milli + (milli < 0 ? -5 : 5)) / 10;
+  uint32_t magnitude = centi < 0 ? -centi : centi;
+  sprintf(text, "%s%lu.%02lu", centi < 0 ? "-" : "", (unsigned long) (magnitude / 100), (unsigned long) (magnitude % 100));
+}
 
 void setup() {
   //serial setup
   Serial.begin(9600);
-  Serial.println("Adafruit MAX31865 PT100 Sensor Test!");
-  //termocouple init
-  thermo.begin(MAX31865_3WIRE);  // set to 2WIRE or 4WIRE as necessary
+  Serial.println("MAX31865 PT100 Sensor Test!");
+  //termocouple init, 3 wire with the 50 Hz filter
+  rtdBus.begin(RTD_SCK, RTD_MISO, RTD_MOSI);
+  thermo.setThreeWire(true);
+  thermo.setFilter50Hz(true);
+  if (!thermo.begin())
+    Serial.println("No MAX31865 found, check the wiring");
   // M5 init
   M5.begin();
   //OLED setup and startup display
@@ -67,16 +91,19 @@ void setup() {
 }
 
 void loop() {
-  //setup termocouple reading
-  uint16_t rtd = thermo.readRTD();
+  //one burst read per refresh, everything below works on the cached value
+  uint8_t fault = thermo.readAll();
+  uint16_t rtd = thermo.getCode();
+  char temperature[12];
+  formatMilli(temperature, Rtd::toMilliCelsius(rtd));
 
   //serial print
   Serial.print("RTD value: "); Serial.println(rtd);
-  float ratio = rtd;
-  ratio /= 32768;
-  Serial.print("Ratio = "); Serial.println(ratio,8);
-  Serial.print("Resistance = "); Serial.println(RREF*ratio,8);
-  Serial.print("Temperature = "); Serial.println(thermo.temperature(RNOMINAL, RREF));
+  Serial.print("Resistance (mOhm) = "); Serial.println(Max31865::resistance(rtd, RREF));
+  Serial.print("Temperature = "); Serial.println(temperature);
+  if (fault) {
+    Serial.print("Fault 0x"); Serial.println(fault, HEX);
+  }
 
   //setup display
   M5.Lcd.fillRect(0,0,160,80,BLACK);
@@ -85,13 +112,13 @@ void loop() {
 
   //display data
    M5.Lcd.setTextSize(2);
-  if(ratio== 0){
+  if(rtd== 0){
       M5.Lcd.setCursor(5, 30);
       M5.Lcd.print("NO DATA !!");
   }
   else {
     M5.Lcd.setCursor(40, 30);
-    M5.Lcd.print(thermo.temperature(RNOMINAL, RREF));
+    M5.Lcd.print(temperature);
     M5.Lcd.print("C");
     }
 
@@ -10,19 +10,25 @@
 
 #include <M5StickC.h>
 #include <Wire.h>
+#include "Mlx90614.h"
 
+// The sensor is read in the background, object and ambient temperature in
+// one go with the packet error code checked, see Mlx90614.h
+Mlx90614WireBus irBus(Wire);
+Mlx90614 ir(&irBus);
 
-//        Inits for reading the data out of the MLX90614 RAM , will be used in Wire.write(OBJECT_TEMP) in the loop   //
-#define   MLX90614_ADDRESS    0x00
-#define   MLX90614_ADDR_WRITE   0x00	
-#define   MLX90614_ADDR_READ    0x01
-#define   MLX90614_RAM    0x00
-#define   AMBIENT_TEMP    0x06
-#define   OBJECT_TEMP     0x07
+// Refresh the display every 500 ms
+#define DISPLAY_INTERVAL 500
+
+// 1/100 degrees C as text with two decimals
+void formatCenti(char* text, int32_t centi) {
+  uint32_t magnitude = centi < 0 ? -centi : centi;
+  sprintf(text, "%s%lu.%02lu", centi < 0 ? "-" : "", (unsigned long) (magnitude / 100), (unsigned long) (magnitude % 100));
+}
 
 void setup() {
    M5.begin();
-  Wire.begin(0,26);
+  irBus.begin(0,26);
   Serial.begin(9600);
 
 //OLED setup and startup display
@@ -40,6 +46,10 @@ void setup() {
 
   delay(3000);
 
+  //start reading, fails when the sensor doesn't answer correctly
+  if (!ir.begin())
+    Serial.println("No MLX90614 found");
+
 //clear the screen
   M5.Lcd.fillRect(0,0,160,80,BLACK);
   M5.Lcd.setTextColor(WHITE);
@@ -47,31 +57,43 @@ void setup() {
 
 
 //inits
-uint16_t result;
-float temperature;
+IrSample sample;
+bool valid = false;
+unsigned long lastDisplayed = 0;
+char text[12];
 
 void loop() {
-  //connect to sensor I2C
-  Wire.beginTransmission(0x5A);          // Send Initial Signal and I2C Bus Address
-  Wire.write(OBJECT_TEMP);               // Send data for getting the temparture sensor selection and add one address automatically. 
-  Wire.endTransmission(false);           // Stop signal
-  Wire.requestFrom(0x5A, 2);             // Get 2 consecutive data from 0x5A, and the data is stored only.
-  result = Wire.read();                  // Receive DATA
-  result |= Wire.read() << 8;            // Receive DATA
-  
-  temperature = result * 0.02 - 273.15;
+  //take whatever the reader got meanwhile, never waits on I2C
+  while (ir.read(&sample))
+    valid = true;
+
+  // a reading older than a few periods means the sensor stopped answering
+  if (valid && millis() - sample.time > 5 * MLX90614_PERIOD_MS)
+    valid = false;
+
+  if (millis() - lastDisplayed < DISPLAY_INTERVAL) {
+    M5.update();
+    return;
+  }
+  lastDisplayed = millis();
   
   M5.Lcd.fillRect(0,0,160,80,BLACK);
   M5.Lcd.setCursor(40, 30);
   M5.Lcd.setTextColor(WHITE);
 
-  if(temperature >1000){
+  if(!valid){
       M5.Lcd.setCursor(5, 30);
       M5.Lcd.print("No data I2C");
   }
   else {
-    M5.Lcd.print(temperature);
+    formatCenti(text, Mlx90614::toCentiCelsius(sample.object));
+    M5.Lcd.print(text);
     M5.Lcd.print("C");
+    formatCenti(text, Mlx90614::toCentiCelsius(sample.ambient));
+    M5.Lcd.setTextSize(1);
+    M5.Lcd.setCursor(40, 50);
+    M5.Lcd.print("ambient ");
+    M5.Lcd.print(text);
     }
     
   M5.Lcd.setTextSize(1);
@@ -81,8 +103,7 @@ void loop() {
   M5.Lcd.print("2020");
 
   M5.Lcd.setTextSize(2);
-  // Serial.println(temperature);
+  // Serial.println(text);
 
-  delay(500);
   M5.update();
 }
\ No newline at end of file
@@ -62,8 +62,11 @@
 // *****************************************************************************
 
 
-#include <MAX31865.h>
+#include <SPI.h>
 #include <M5StickC.h>
+#include "Max31865.h"
+#include "RtdConversion.h"
+#include "RtdFaultSupervisor.h"
 
 // define here PT1000 or PT100
 // ===========================
@@ -79,28 +82,23 @@
 
 // Led on MAX31865 Break-out Board
 #define LED_MAX31865  8
-// Data Ready Signal on MAX31865 Break-out Board 
-// Comment if you did not connected te IRQ signal of
-// breakout board to a IO, else set IO here
-// #define DRDY_MAX31865 2
 
 // Chip Select Pin
+// DRDY isn't needed, the chip converts continuously and is polled
 #define RTD_CS_PIN   10
 
-// MAX31865 device status seen on SPI bus or not
-// This is before device internal status register
-#define MAX31865_STATE_NOT_FOUND       0
-#define MAX31865_STATE_TRANSMIT_ERROR  1
-#define MAX31865_STATE_OK              2
-#define MAX31865_RTD_CONFIG_FAULT      3
-
-// Do measure every 2 seconds
+// Print a measure every 2 seconds
 #define MEASURE_INTERVAL 2000L
 
-// mask to know where to print data
-#define PRINT_MODE_SERIAL 0x01
-#define PRINT_MODE_OLED   0x02
-#define PRINT_MODE_BOTH  (PRINT_MODE_SERIAL | PRINT_MODE_OLED)
+// Poll once per conversion, 50 Hz filter
+#define SAMPLE_INTERVAL 20
+
+// Check the RTD connection every 10 seconds, and soon after a reading
+// looks wrong
+#define FAULT_CHECK_INTERVAL 10000L
+
+// Reading change per sample taken as implausible, about 30 C
+#define MAX_CODE_STEP 1000
 
 // Got some of old Arduinode revisions and prototype boards
 // so I need specifc setup to define board type to adjust the pin
@@ -141,60 +139,109 @@
 #endif
 
 // see MAX31865 datasheet page 20/21 
-// Table 9. Temperature Example for PT100 with 400Ω RREF
-// to set Min Max temps (value)
-#define FAULT_HIGH_THRESHOLD  0x9304  /* +350C */
-#define FAULT_LOW_THRESHOLD   0x2690  /* -100C */
-//#define FAULT_HIGH_THRESHOLD  0xBE64  /* +550C */
-//#define FAULT_LOW_THRESHOLD   0x0BDA  /* -200C */
+// Table 9. Temperature Example for PT100 with 400Ω RREF
+// to set Min Max temps (15 bit ratio code)
+#define FAULT_HIGH_THRESHOLD  (0x9304 >> 1)  /* +350C */
+#define FAULT_LOW_THRESHOLD   (0x2690 >> 1)  /* -100C */
+//#define FAULT_HIGH_THRESHOLD  (0xBE64 >> 1)  /* +550C */
+//#define FAULT_LOW_THRESHOLD   (0x0BDA >> 1)  /* -200C */
 
 #ifdef PT1000
   // For PT 1000 (Ref on breakout board = 3900 Ohms 0.1%)
-  MAX31865_RTD rtd( MAX31865_RTD::RTD_PT1000, RTD_CS_PIN, 3900 );
+  #define RREF 3900
+  typedef Pt1000Rref3900 Rtd;
 #endif
 
 #ifdef PT100
   // For PT 100  (Ref Ref on breakout board = 390 Ohms 0.1%)
-  MAX31865_RTD rtd( MAX31865_RTD::RTD_PT100, RTD_CS_PIN, 390 );
+  #define RREF 390
+  typedef RtdConversion<100, 390> Rtd;
 #endif
 
-// Error message associated to status
-uint8_t status;
-String status_text;
+Max31865SpiBus rtdBus(SPI, RTD_CS_PIN);
+Max31865 rtd(&rtdBus, MAX31865_NO_DRDY);
+RtdFaultSupervisor supervisor(&rtd);
+
+// MAX31865 seen on the SPI bus
+bool max31865_found = false;
 char buffer[32]; // Temp buffer for formating string/display text
-// MAX31865 device status seen on SPI bus or not
-uint8_t max31865_state = MAX31865_STATE_NOT_FOUND;
+
+// last reading and readings taken since the last print
+uint16_t rtd_code = 0;
+uint8_t rtd_fault = 0;
+uint16_t samples = 0;
 
 /* ======================================================================
-Function: status2text
-Purpose : convert status to human readable text
+Function: printStatus
+Purpose : print fault status as human readable text
 Input   : status register of MAX31865
-Output  : pointer to error string  
-Comments: -
+Output  : - 
+Comments: one text from a fixed table per fault bit, nothing is built
 ====================================================================== */
-String status2text(uint8_t status)
+void printStatus(uint8_t status)
 {
-  // Default 
-  status_text = "";
-  
-  if( status == 0 )
-    status_text += F("OK!");
-  else {
-    if( status & MAX31865_FAULT_HIGH_THRESHOLD )
-      status_text += F("RTD high thre. exceeded ");
-    if( status & MAX31865_FAULT_LOW_THRESHOLD )
-      status_text += F("RTD low thres. exceeded ");
-    if( status & MAX31865_FAULT_REFIN )
-      status_text += F("REFIN- > 0.85x V_BIAS ");
-    if( status & MAX31865_FAULT_REFIN_FORCE )
-      status_text += F("REFIN- < 0.85x V_BIAS F- Open ");
-    if( status & MAX31865_FAULT_RTDIN_FORCE )
-      status_text += F("RTDIN- < 0.85x V_BIAS F- Open ");
-    if( status & MAX31865_FAULT_VOLTAGE )
-      status_text += F("Overvoltage / undervoltage ");
+  if( status == 0 ) {
+    Serial.print(F("OK!"));
+    return;
   }
 
-  return (status_text);
+  for (uint8_t bit = MAX31865_FAULT_HIGH_THRESHOLD; bit != 0; bit >>= 1) {
+    if( status & bit ) {
+      Serial.print(Max31865::faultText(bit));
+      Serial.print(' ');
+    }
+  }
+}
+
+/* ======================================================================
+Function: probe
+Purpose : configure the MAX31865 and check it answers
+Input   : -
+Output  : true if the board is plugged and talks
+Comments: called again while no board is found, so that it can be
+          plugged in at any time
+====================================================================== */
+bool probe()
+{
+  /* Configure once, the chip then converts on its own
+       V_BIAS enabled
+       Auto-conversion
+       3-wire 
+       50 Hz filter
+       Low threshold:  FAULT_LOW_THRESHOLD
+       High threshold:  FAULT_HIGH_THRESHOLD
+     The begin() read back of configuration and thresholds tells if the
+     board is plugged and talks
+  */
+  bool found = rtd.begin();
+
+  #ifdef ARDUINO_ARDUINODE_V13
+    if (found)
+      ledON(LED_BLU);
+    else
+      ledOFF(LED_BLU);
+  #endif  
+  if (!found)
+    Serial.println(F("No communication, is breakout board plugged ?"));
+  else
+    // check the connection of the board just plugged in
+    supervisor.request();
+
+  return found;
+}
+
+/* ======================================================================
+Function: formatMilli
+Purpose : milli degrees C as text with one decimal
+Input   : text buffer, temperature
+Output  : - 
+Comments: -
+====================================================================== */
+void formatMilli(char* text, int32_t milli)
+{
+  int32_t deci = (milli + (milli < 0 ? -50 : 50)) / 100;
+  uint32_t magnitude = deci < 0 ? -deci : deci;
+  sprintf(text, "%s%lu.%lu", deci < 0 ? "-" : "", (unsigned long) (magnitude / 10), (unsigned long) (magnitude % 10));
 }
 
 /* ======================================================================
@@ -218,11 +265,8 @@ void setup()
   Serial.println(F(__FILE__));
   Serial.println(F(__DATE__ " " __TIME__ "\r\n"));
 
-  /* Initialize SPI communication. */
-  // device can go up to 5MHz, set it to 4MHz
-  SPI.begin();
-  SPI.setClockDivider( SPI_CLOCK_DIV4 );
-  SPI.setDataMode( SPI_MODE1 );
+  /* Initialize SPI communication, 4MHz mode 1 per transaction */
+  rtdBus.begin();
 
   // Ports Initialization
   // ====================
@@ -245,7 +289,6 @@ void setup()
     oledPWR_ON();
   #endif
   
-  pinMode(10, OUTPUT);        // SPI SS (avoid becoming SPI Slave)
   #ifdef LED_MAX31865
     pinMode(LED_MAX31865, OUTPUT);    // RFM breakout board LED
     // small blink
@@ -255,10 +298,6 @@ void setup()
 
   #endif
 
-  #ifdef DRDY_MAX31865
-    pinMode(DRDY_MAX31865, INPUT_PULLUP); // RFM breakout board DRDY
-  #endif
-
   #ifdef ARDUINO_ARDUINODE_V13
     // Small light to indicate we're all fine
     ledON(LED_GRN);
@@ -274,6 +313,18 @@ void setup()
 
   // Allow display reading and MAX31865 to warm up
   delay( 1000 );
+
+  rtd.setThreeWire(USE_3WIRES);
+  rtd.setFilter50Hz(true);
+  rtd.setFaultThresholds(FAULT_LOW_THRESHOLD, FAULT_HIGH_THRESHOLD);
+  max31865_found = probe();
+
+  // Fault detection: manual mode, because on MAX31865 breakout board, RC
+  // constant is > 100us, wait 5*RC between the stages
+  // see MAX31865 datasheet page 14 / Section Fault Detection Cycle (D3:D2)
+  supervisor.setInterval(FAULT_CHECK_INTERVAL);
+  supervisor.setSettleTime(60);
+  supervisor.setMaxStep(MAX_CODE_STEP);
 }
 
 /* ======================================================================
@@ -281,209 +332,93 @@ Function: loop
 Purpose : main Arduino loop
 Input   : -
 Output  : - 
-Comments: read temperature and display on serial and OLED
+Comments: never waits, the fault check runs between conversions
 ====================================================================== */
 void loop() 
 {
+  static unsigned long lastSampled = 0;
   static unsigned long lastRefreshed = 0;
-  uint8_t status;
-  
-  // Do measure every MEASURE_INTERVAL (in ms) ?
-  if( millis()-lastRefreshed >= MEASURE_INTERVAL)
+  unsigned long now = millis();
+
+  // No board, look for it again every MEASURE_INTERVAL
+  if (!max31865_found) {
+    if (now-lastRefreshed >= MEASURE_INTERVAL) {
+      lastRefreshed = now;
+      Serial.print( now/1000);
+      Serial.print(F("\t"));
+      max31865_found = probe();
+    }
+    return;
+  }
+
+  // Runs a fault detection stage when due
+  supervisor.update(now);
+
+  // Take the latest conversion, one burst read
+  if( supervisor.isMeasuring() && now-lastSampled >= SAMPLE_INTERVAL)
   {
-    // reset our last measure
-    lastRefreshed += MEASURE_INTERVAL;
+    lastSampled = now;
+    rtd_fault = rtd.readAll();
+
+    // An unplugged board reads all zeros or all ones, not the thresholds
+    if (rtd.getLowThreshold() != FAULT_LOW_THRESHOLD || rtd.getHighThreshold() != FAULT_HIGH_THRESHOLD) {
+      #ifdef ARDUINO_ARDUINODE_V13
+        ledOFF(LED_BLU);
+      #endif  
+      max31865_found = false;
+      Serial.println(F("MAX31865 lost, is breakout board plugged ?"));
+      return;
+    }
 
-    // default not found
-    max31865_state = MAX31865_STATE_NOT_FOUND;
+    rtd_code = rtd.getCode();
+    supervisor.check(rtd_code, rtd_fault);
+    samples++;
+  }
 
-    Serial.print( millis()/1000);
-    Serial.print(F("\tChecking MAX31865 SPI chip..."));
+  // Print every MEASURE_INTERVAL (in ms)
+  if( now-lastRefreshed >= MEASURE_INTERVAL)
+  {
+    // reset our last measure
+    lastRefreshed += MEASURE_INTERVAL;
 
     // Indicate onboard MAX31865 we do a measure
     #ifdef LED_MAX31865
       digitalWrite(LED_MAX31865, 0);
     #endif
 
-    /* Reconfigure this allow us to plug/unplug the module and check PT100/PT1000
-         V_BIAS enabled
-         No Auto-conversion
-         1-shot disabled
-         3-wire 
-         Fault detection: we need to manual mode, set manual 1 => First stage 
-                          because on MAX31865 beakout board, RC constant is > 100us 
-                          see MAX31865 datasheet page 14 / Section Fault Detection Cycle (D3:D2)
-         Fault status:  auto-clear
-         50 Hz filter
-         Low threshold:  FAULT_LOW_THRESHOLD
-         High threshold:  FAULT_HIGH_THRESHOLD
-    */
-
-    // 1st do full configuration, enable vbias and wait 5*RC constant 
-    // see MAX31865 datasheet page 14 / Section Fault Detection Cycle (D3:D2)
-    rtd.configure( true, false, false, USE_3WIRES, MAX31865_FAULT_DETECTION_NONE, 
-                    true, true, FAULT_LOW_THRESHOLD, FAULT_HIGH_THRESHOLD );
-    //delay(60);
-
-    // We will read back thresold, to check it's same we wrote
-     rtd.read_all( );
-
-    // Spi read 0xffff or 0x0000, mainly no com with device
-    if ( ( rtd.low_threshold()==  0x0 || rtd.low_threshold() == 0xffff ) &&
-         ( rtd.high_threshold()== 0x0 || rtd.high_threshold()== 0xffff ) )
-    {
-      #ifdef ARDUINO_ARDUINODE_V13
-        ledOFF(LED_BLU);
-      #endif  
-      max31865_state = MAX31865_STATE_NOT_FOUND;
-      Serial.println(F("No communication, is breakout board plugged ?"));
+    Serial.print( now/1000);
+    sprintf(buffer, "\t%u samples, checks:%lu ", samples, (unsigned long) supervisor.getCycleCount());
+    Serial.print(buffer);
+    samples = 0;
 
-      // Blue LED off (on = indicate MAX31865 seen and talk)
-    }
-    // we found something, but not what we wrote on threshold registers, bad com!!!
-    else if ( (rtd.low_threshold()!= FAULT_LOW_THRESHOLD) || (rtd.high_threshold()!=FAULT_HIGH_THRESHOLD))
-    {
-      // Blue LED off (on = indicate MAX31865 seen and talk)
-      #ifdef ARDUINO_ARDUINODE_V13
-        ledOFF(LED_BLU);
-      #endif  
-      max31865_state = MAX31865_STATE_TRANSMIT_ERROR;
-      Serial.println(F("SPI transmission error, verify wiring!"));
-      Serial.print(F("\t    Set low threshold to 0x"));
-      Serial.print( FAULT_LOW_THRESHOLD,HEX);
-      Serial.print(F( " just read 0x"));
-      Serial.println( rtd.low_threshold(),HEX);
-      Serial.print(F( "\t    Set high threshold to 0x"));
-      Serial.print( FAULT_HIGH_THRESHOLD,HEX);
-      Serial.print(F( " just read 0x"));
-      Serial.println( rtd.high_threshold(),HEX);
-    }
-    // ok all seems fine untils there we can talk to device to do action
-    else
-    {
-      // Blue LED indicate MAX31865 seen and talk
-      #ifdef ARDUINO_ARDUINODE_V13
-        ledON(LED_BLU);
-      #endif  
+    sprintf(buffer, "status=%02X => ", supervisor.getFaults() );
+    Serial.print(buffer);
+    printStatus(supervisor.getFaults());
+    Serial.println();
 
-      max31865_state = MAX31865_STATE_OK;
-      Serial.println(F("Found OK!"));
-      Serial.print(F("\t  Checking manual fault detection Stage 1 "));
-
-      // Stage 1
-      // Now we're ready to start fault detection (RTD connection)
-      // V_BIAS enabled , No Auto-conversion, 1-shot disabled, Fault detection Stage 1
-      rtd.configure( true, false, false, MAX31865_FAULT_DETECTION_MANUAL_1 );
-
-      // wait some time MAX31865 has finished the test
-      // no indication in datasheet on how much time it take 
-      // but without this delay value returned is not 0x20 but 0x00
-      delay(2);
-
-      // After stage 1, fault status should return 0x20
-      // MAX31865 datasheet page 14 / Section Fault Detection Cycle (D3:D2)
-      sprintf_P(buffer, PSTR("status=%02X => OK!"), rtd.fault_status() );
-      Serial.println(buffer);
-      Serial.print(F("\t  Checking manual fault detection Stage 2 "));
-
-      // Wait 5 * RC constant before stage 2
-      // see MAX31865 datasheet page 14 / Section Fault Detection Cycle (D3:D2)
-      delay(60);
-
-      // Stage 2
-      // V_BIAS enabled , No Auto-conversion, 1-shot disabled,
-      rtd.configure( true, false, false, MAX31865_FAULT_DETECTION_MANUAL_2 );
-
-      // wait some time MAX31865 has finished the test
-      // no indication in datasheet on how much time it take 
-      // but without this delay value returned may be inconsistent
-      delay(2);
-
-      // ok what device is saying about Fault Detection ?
-      status = rtd.fault_status();
-
-      sprintf_P(buffer, PSTR("status=%02X => "), status );
-      Serial.print(buffer);
-
-      status2text(status);
-      Serial.println(status_text);
-
-      // Ok all wnet fine ? we'll do a measure
-      if (status==0 )
-      {
-        max31865_state = MAX31865_STATE_OK;
-
-        Serial.print(F("\t  Starting conversion..."));
-
-        // Start 1 shot measure
-        // V_BIAS enabled , No Auto-conversion, 1-shot enabled, No Fault detection
-        rtd.configure( true, false, true, MAX31865_FAULT_DETECTION_NONE );
-
-        // onboard MAX31865 will push DRDY line low when measure's done
-        #ifdef DRDY_MAX31865
-          // Time out start
-          unsigned long timeout = millis();
-
-          // wait chip says finished or timeout (datasheet says max 66ms)
-          while ( digitalRead(DRDY_MAX31865)==1 && millis()-timeout < 70);
-
-          if ( millis()-timeout>=70)
-            // Display conversion time         
-            Serial.print(F("(timed-out "));
-          else
-            // Display conversion time         
-            Serial.print(F("(in "));
-
-          Serial.print(millis()-timeout,DEC);
-          Serial.print(F("ms) "));
-        #else
-          // 50 Hz max conversion time in one shot
-          delay(70);
-        #endif
-
-        // Read MAX31865 all registers values
-        status = rtd.read_all();
-
-        sprintf_P(buffer, PSTR("Status:%02X "), status );
-        Serial.println(buffer);
-
-        Serial.print(F( "\t  RTD:"));
-        Serial.print( rtd.raw_resistance());
-
-        // display temperature reading on serial
-        double temperature = rtd.temperature();
-        Serial.print(F( " Ohms => Temp:"));
-        Serial.print( temperature,1);
-        Serial.println(F(" C" ));
-      }
-
-      // disable V_BIAS and one shot to reduce power
-      rtd.configure( false, false, false, MAX31865_FAULT_DETECTION_NONE);
-
-    } // device seen
-
-    // All is good ?
-    if( max31865_state==MAX31865_STATE_OK && status==0 && rtd.raw_resistance()!=0 )
-    {
-      // We displayed all, add what you want there
-    }
+    uint32_t milliohms = Max31865::resistance(rtd_code, RREF);
+    sprintf(buffer, "\t  RTD:%lu.%03lu", (unsigned long) (milliohms / 1000), (unsigned long) (milliohms % 1000));
+    Serial.print(buffer);
+
+    // display temperature reading on serial
+    formatMilli(buffer, Rtd::toMilliCelsius(rtd_code));
+    Serial.print(F( " Ohms => Temp:"));
+    Serial.print(buffer);
+    Serial.println(F(" C" ));
 
     #ifdef LED_MAX31865
       // measure done
       digitalWrite(LED_MAX31865, 1);
     #endif
-
-    Serial.println(F("\tDone!\r\n"));
   }
 
   // Manage blink led (Red error, Green OK)
   #ifdef ARDUINO_ARDUINODE_V13
     uint8_t led ;
-    led = status==0?LED_GRN:LED_RED;
+    led = supervisor.getFaults()==0 && rtd_fault==0?LED_GRN:LED_RED;
     if (millis() % 200 < 50 )
       ledON(led);
     else
       ledOFF(led);
   #endif
 }
-
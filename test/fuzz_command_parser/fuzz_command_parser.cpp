@@ -0,0 +1,46 @@
+// libFuzzer entry point for CommandParser. Not a PlatformIO test suite, the
+// folder name keeps the test runner away from it. Built and run with clang,
+// the first three lines are one command:
+//
+//   clang++ -std=gnu++11 -g -fsanitize=fuzzer,address,undefined -Iinclude
+//     -o fuzz_command_parser src/CommandParser.cpp
+//     test/fuzz_command_parser/fuzz_command_parser.cpp
+//   ./fuzz_command_parser -max_len=256
+//
+// Any input is fed byte by byte. Only a line end may complete a line, and a
+// completed command is well formed: a known type, no more arguments than
+// COMMAND_MAX_ARGS and none on an error. After a line end a valid command
+// always parses, whatever came before.
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "CommandParser.h"
+
+static void check(bool ok) {
+  if (!ok)
+    abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  CommandParser parser;
+
+  for (size_t i = 0; i < size; i++) {
+    char c = (char) data[i];
+    if (!parser.feed(c))
+      continue;
+    check(c == '\n' || c == '\r');
+    const Command& command = parser.getCommand();
+    check(command.type > CMD_NONE && command.type <= CMD_ERROR);
+    check(command.argc <= COMMAND_MAX_ARGS);
+    check(command.type != CMD_ERROR || command.argc == 0);
+  }
+
+  const char* probe = "\nF 4 -1\n";
+  bool done = false;
+  for (const char* c = probe; *c; c++)
+    done = parser.feed(*c);
+  const Command& command = parser.getCommand();
+  check(done && command.type == CMD_FAN_DUTY && command.argc == 2
+        && command.args[0] == 4 && command.args[1] == -1);
+  return 0;
+}
@@ -0,0 +1,193 @@
+// TempAcquisition on the simulated bus: the control loop keeps its tick
+// while the probes convert, in every mode.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+#include "TempAcquisition.h"
+
+// the sketch's control tick in ms
+#define CONTROL_TICK 100
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void addProbes(OneWire& wire, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, i + 1)->setTemperature((20 + i) * 128);
+}
+
+// index of a device in getAddress() order
+static uint8_t indexOf(DallasTemperature& sensors, OneWireSimDevice* device) {
+  DeviceAddress address;
+  uint8_t i = 0;
+  while (sensors.getAddress(address, i) && memcmp(address, device->getAddress(), 8) != 0)
+    i++;
+  return i;
+}
+
+// the old loop: a blocking conversion, one read per probe and a second of
+// delay, about 1.75 s per pass at 12 bits
+void test_blocking_loop_period(void) {
+  OneWire wire(1);
+  addProbes(wire, 4);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+
+  unsigned long start = millis();
+  for (uint8_t pass = 0; pass < 5; pass++) {
+    sensors.requestTemperatures();
+    for (uint8_t i = 0; i < 4; i++)
+      sensors.getTempCByIndex(i);
+    delay(1000);
+  }
+  unsigned long period = (millis() - start) / 5;
+  TEST_ASSERT_GREATER_OR_EQUAL(1750, period);
+  TEST_ASSERT_LESS_THAN(1850, period);
+}
+
+// runs the loop for a simulated time and returns the longest pass,
+// counting the samples delivered
+static unsigned long runLoop(TempAcquisition& acquisition, unsigned long duration, uint16_t* samples) {
+  unsigned long longest = 0;
+  unsigned long end = millis() + duration;
+  *samples = 0;
+  while (millis() < end) {
+    unsigned long start = millis();
+    acquisition.update(start);
+    for (uint8_t i = 0; i < acquisition.getSensorCount(); i++) {
+      if (acquisition.isFresh(i))
+        (*samples)++;
+    }
+    delay(CONTROL_TICK);
+    if (millis() - start > longest)
+      longest = millis() - start;
+  }
+  return longest;
+}
+
+// the loop runs at the control tick plus the bus traffic of one update(),
+// never the conversion time. The heaviest update() reads and re-arms all
+// four probes in alarm mode, about 90 ms of 1-Wire slots.
+void test_loop_runs_at_the_control_tick(void) {
+  const TempAcquisition::Mode modes[] = {
+    TempAcquisition::MODE_BROADCAST, TempAcquisition::MODE_PIPELINED, TempAcquisition::MODE_ALARM
+  };
+
+  for (uint8_t m = 0; m < 3; m++) {
+    OneWire wire(1);
+    addProbes(wire, 4);
+    DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+    sensors.begin();
+    TempAcquisition acquisition(&sensors);
+    acquisition.setMode(modes[m]);
+    acquisition.begin();
+    TEST_ASSERT_EQUAL(modes[m], acquisition.getMode());
+
+    uint16_t samples;
+    unsigned long longest = runLoop(acquisition, 10000, &samples);
+    TEST_ASSERT_LESS_THAN(CONTROL_TICK + 100, longest);
+    TEST_ASSERT_GREATER_THAN(0, samples);
+    for (uint8_t i = 0; i < 4; i++)
+      TEST_ASSERT_EQUAL((20 + i) * 128, acquisition.getTemp(indexOf(sensors, wire.getDevice(i))));
+  }
+}
+
+// broadcast mode delivers every probe once per conversion, at most a tick
+// after the conversion time
+void test_broadcast_sample_rate(void) {
+  OneWire wire(1);
+  addProbes(wire, 4);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TempAcquisition acquisition(&sensors);
+  acquisition.begin();
+
+  uint16_t samples;
+  runLoop(acquisition, 10000, &samples);
+  // 750 ms conversions rounded up to the tick
+  TEST_ASSERT_GREATER_OR_EQUAL(4 * 10, samples);
+  TEST_ASSERT_LESS_OR_EQUAL(4 * 14, samples);
+}
+
+// a probe moving in alarm mode is read within a conversion of the move,
+// the quiet ones only by the refresh
+void test_alarm_mode_follows_a_moving_probe(void) {
+  OneWire wire(1);
+  addProbes(wire, 4);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TempAcquisition acquisition(&sensors);
+  acquisition.setMode(TempAcquisition::MODE_ALARM);
+  acquisition.begin();
+
+  OneWireSimDevice* probe = wire.getDevice(2);
+  uint8_t index = indexOf(sensors, probe);
+  uint16_t samples;
+  runLoop(acquisition, 2000, &samples);
+
+  // within the window nothing is read
+  probe->setTemperature(22 * 128 + TEMP_ACQ_ALARM_WINDOW * 128);
+  runLoop(acquisition, 2000, &samples);
+  TEST_ASSERT_EQUAL(0, samples);
+  TEST_ASSERT_EQUAL(22 * 128, acquisition.getTemp(index));
+
+  // one whole degree past it alarms
+  probe->setTemperature(22 * 128 + (TEMP_ACQ_ALARM_WINDOW + 1) * 128);
+  runLoop(acquisition, 2000, &samples);
+  TEST_ASSERT_EQUAL(1, samples);
+  TEST_ASSERT_EQUAL(22 * 128 + (TEMP_ACQ_ALARM_WINDOW + 1) * 128, acquisition.getTemp(index));
+}
+
+// bus time per second of 8 probes, some of them moving two degrees
+// every conversion
+static uint32_t busTime(TempAcquisition::Mode mode, uint8_t moving) {
+  OneWire wire(1);
+  addProbes(wire, 8);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TempAcquisition acquisition(&sensors);
+  acquisition.setMode(mode);
+  acquisition.begin();
+
+  uint16_t samples;
+  runLoop(acquisition, 2000, &samples);
+  wire.resetStats();
+  for (uint8_t step = 0; step < 20; step++) {
+    for (uint8_t i = 0; i < moving; i++)
+      wire.getDevice(i)->setTemperature((20 + i + (step % 2) * 2) * 128);
+    runLoop(acquisition, 1000, &samples);
+  }
+  return wire.getStats().micros / 20;
+}
+
+// alarm mode against broadcast by the number of moving probes: one search
+// instead of eight reads while few move, the refresh and the re-arming on
+// top when many do. Broadcast reads all eight whatever moves.
+void test_alarm_mode_bus_time(void) {
+  static const uint8_t moving[] = { 0, 1, 2, 4, 8 };
+  uint32_t broadcast = busTime(TempAcquisition::MODE_BROADCAST, 0);
+
+  for (uint8_t m = 0; m < sizeof(moving); m++) {
+    uint32_t alarm = busTime(TempAcquisition::MODE_ALARM, moving[m]);
+    char text[96];
+    snprintf(text, sizeof(text), "8 probes, %u moving: broadcast %lu us/s, alarm %lu us/s",
+             moving[m], (unsigned long) broadcast, (unsigned long) alarm);
+    TEST_MESSAGE(text);
+    if (moving[m] <= 2)
+      TEST_ASSERT_LESS_THAN(broadcast, alarm);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_blocking_loop_period);
+  RUN_TEST(test_loop_runs_at_the_control_tick);
+  RUN_TEST(test_broadcast_sample_rate);
+  RUN_TEST(test_alarm_mode_follows_a_moving_probe);
+  RUN_TEST(test_alarm_mode_bus_time);
+  return UNITY_END();
+}
@@ -0,0 +1,166 @@
+// CommandParser: the command set, malformed and overlong lines, numbers out
+// of range and random input.
+
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CommandParser.h"
+
+static CommandParser parser;
+static uint8_t lines;
+
+void setUp(void) {
+  parser.reset();
+  lines = 0;
+}
+
+void tearDown(void) {}
+
+// feeds a string, returns the last command completed
+static Command parse(const char* text) {
+  Command command = { CMD_NONE, 0, { 0, 0 } };
+  for (const char* c = text; *c; c++) {
+    if (parser.feed(*c)) {
+      command = parser.getCommand();
+      lines++;
+    }
+  }
+  return command;
+}
+
+void test_commands(void) {
+  Command command = parse("O 3\n");
+  TEST_ASSERT_EQUAL(CMD_OFFSET, command.type);
+  TEST_ASSERT_EQUAL(1, command.argc);
+  TEST_ASSERT_EQUAL(3, command.args[0]);
+
+  command = parse("-2\r\n");
+  TEST_ASSERT_EQUAL(CMD_OFFSET, command.type);
+  TEST_ASSERT_EQUAL(-2, command.args[0]);
+
+  command = parse("s45\n");
+  TEST_ASSERT_EQUAL(CMD_SETPOINT, command.type);
+  TEST_ASSERT_EQUAL(45, command.args[0]);
+
+  command = parse("C 2\n");
+  TEST_ASSERT_EQUAL(CMD_CURVE, command.type);
+  TEST_ASSERT_EQUAL(1, command.argc);
+  TEST_ASSERT_EQUAL(2, command.args[0]);
+
+  command = parse("c 1,0\n");
+  TEST_ASSERT_EQUAL(CMD_CURVE, command.type);
+  TEST_ASSERT_EQUAL(2, command.argc);
+  TEST_ASSERT_EQUAL(1, command.args[0]);
+  TEST_ASSERT_EQUAL(0, command.args[1]);
+
+  command = parse("F 2 -1\n");
+  TEST_ASSERT_EQUAL(CMD_FAN_DUTY, command.type);
+  TEST_ASSERT_EQUAL(2, command.args[0]);
+  TEST_ASSERT_EQUAL(-1, command.args[1]);
+
+  TEST_ASSERT_EQUAL(CMD_TELEMETRY, parse("T 1\n").type);
+  TEST_ASSERT_EQUAL(CMD_STATS, parse("D\n").type);
+  TEST_ASSERT_EQUAL(CMD_STATS, parse("D 0\n").type);
+  TEST_ASSERT_EQUAL(CMD_STATUS, parse("?\n").type);
+  TEST_ASSERT_EQUAL(10, lines);
+}
+
+// empty and blank lines, and the \n of \r\n, complete nothing
+void test_blank_lines(void) {
+  parse("\n\r\n\r\r  \n\t,\n");
+  TEST_ASSERT_EQUAL(0, lines);
+}
+
+void test_malformed_lines(void) {
+  const char* bad[] = {
+    "X\n", "F 1\n", "O 1 2 3\n", "O -\n", "O +\n", "S 4a\n", "C\n", "D 1\n",
+    "? 1\n", "O 1-2\n", "F 1 2 3\n", "--1\n", "T\n"
+  };
+  for (uint8_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    Command command = parse(bad[i]);
+    TEST_ASSERT_EQUAL_MESSAGE(CMD_ERROR, command.type, bad[i]);
+    TEST_ASSERT_EQUAL(0, command.argc);
+  }
+  // the line after an error parses
+  TEST_ASSERT_EQUAL(CMD_SETPOINT, parse("S 40\n").type);
+}
+
+// a line longer than COMMAND_MAX_LENGTH is rejected as a whole, even when
+// its start is a valid command
+void test_overlong_line(void) {
+  char line[COMMAND_MAX_LENGTH + 8];
+  memset(line, ' ', sizeof(line));
+  line[0] = 'S';
+  memcpy(line + sizeof(line) - 4, "40\n", 4);
+  TEST_ASSERT_EQUAL(CMD_ERROR, parse(line).type);
+
+  line[COMMAND_MAX_LENGTH - 3] = '4';
+  line[COMMAND_MAX_LENGTH - 2] = '0';
+  line[COMMAND_MAX_LENGTH - 1] = '\n';
+  line[COMMAND_MAX_LENGTH] = 0;
+  Command command = parse(line);
+  TEST_ASSERT_EQUAL(CMD_SETPOINT, command.type);
+  TEST_ASSERT_EQUAL(40, command.args[0]);
+}
+
+// without a terminator nothing is completed, the bytes wait for it
+void test_missing_terminator(void) {
+  parse("F 2 50");
+  TEST_ASSERT_EQUAL(0, lines);
+  Command command = parse("\r");
+  TEST_ASSERT_EQUAL(CMD_FAN_DUTY, command.type);
+  TEST_ASSERT_EQUAL(50, command.args[1]);
+
+  // reset() drops what was received
+  parse("S 1");
+  parser.reset();
+  command = parse("2\n");
+  TEST_ASSERT_EQUAL(CMD_OFFSET, command.type);
+  TEST_ASSERT_EQUAL(2, command.args[0]);
+}
+
+// numbers saturate at the int16_t range instead of wrapping
+void test_out_of_range_values(void) {
+  Command command = parse("99999999999\n");
+  TEST_ASSERT_EQUAL(CMD_OFFSET, command.type);
+  TEST_ASSERT_EQUAL(32767, command.args[0]);
+
+  command = parse("F 1 -70000\n");
+  TEST_ASSERT_EQUAL(CMD_FAN_DUTY, command.type);
+  TEST_ASSERT_EQUAL(-32767, command.args[1]);
+
+  command = parse("F 65537 101\n");
+  TEST_ASSERT_EQUAL(32767, command.args[0]);
+  TEST_ASSERT_EQUAL(101, command.args[1]);
+}
+
+// random bytes: only line ends complete a line, a completed command is
+// well formed, and the parser recovers at the next line
+void test_random_input(void) {
+  srand(1);
+  for (long i = 0; i < 1000000; i++) {
+    char c = rand() % 256;
+    if (parser.feed(c)) {
+      TEST_ASSERT_TRUE(c == '\n' || c == '\r');
+      const Command& command = parser.getCommand();
+      TEST_ASSERT_TRUE(command.type > CMD_NONE && command.type <= CMD_ERROR);
+      TEST_ASSERT_TRUE(command.argc <= COMMAND_MAX_ARGS);
+    }
+  }
+  parse("\n");
+  Command command = parse("F 3 75\n");
+  TEST_ASSERT_EQUAL(CMD_FAN_DUTY, command.type);
+  TEST_ASSERT_EQUAL(75, command.args[1]);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_commands);
+  RUN_TEST(test_blank_lines);
+  RUN_TEST(test_malformed_lines);
+  RUN_TEST(test_overlong_line);
+  RUN_TEST(test_missing_terminator);
+  RUN_TEST(test_out_of_range_values);
+  RUN_TEST(test_random_input);
+  return UNITY_END();
+}
@@ -0,0 +1,90 @@
+// The table driven CRC8 of DallasTemperature against OneWire's, and bit
+// errors on the simulated bus.
+
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// every address OneWire's CRC accepts is valid, every single bit flip of
+// it isn't
+void test_address_crc_matches_onewire(void) {
+  OneWire wire(1);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  srand(1);
+
+  for (int n = 0; n < 2000; n++) {
+    DeviceAddress address;
+    for (uint8_t i = 0; i < 7; i++)
+      address[i] = rand();
+    address[7] = OneWire::crc8(address, 7);
+    TEST_ASSERT_TRUE(sensors.validAddress(address));
+
+    for (uint8_t bit = 0; bit < 64; bit++) {
+      address[bit / 8] ^= 1 << (bit % 8);
+      TEST_ASSERT_FALSE(sensors.validAddress(address));
+      address[bit / 8] ^= 1 << (bit % 8);
+    }
+  }
+}
+
+// a corrupted scratchpad is refused and a good one accepted
+void test_scratchpad_crc_on_the_bus(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 7);
+  device->setTemperature(-1234);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+
+  uint8_t scratchPad[9];
+  TEST_ASSERT_TRUE(sensors.isConnected(device->getAddress(), scratchPad));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(device->getScratchPad(), scratchPad, 9);
+
+  device->injectCrcErrors(2);
+  TEST_ASSERT_FALSE(sensors.isConnected(device->getAddress(), scratchPad));
+  TEST_ASSERT_FALSE(sensors.isConnected(device->getAddress(), scratchPad));
+  TEST_ASSERT_TRUE(sensors.isConnected(device->getAddress(), scratchPad));
+}
+
+// with read bits flipped at random, no scratchpad that passes the check
+// differs from the device's
+void test_bit_errors_are_caught(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 9);
+  device->setTemperature(4321);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+  device->setBitErrorRate(5000);
+
+  uint16_t good = 0;
+  uint16_t refused = 0;
+  for (int n = 0; n < 2000; n++) {
+    uint8_t scratchPad[9];
+    if (sensors.isConnected(device->getAddress(), scratchPad)) {
+      TEST_ASSERT_EQUAL_UINT8_ARRAY(device->getScratchPad(), scratchPad, 9);
+      good++;
+    } else {
+      refused++;
+    }
+  }
+  // 72 bits at 0.5% each, about a third of the reads are hit
+  TEST_ASSERT_GREATER_THAN(0, good);
+  TEST_ASSERT_GREATER_THAN(0, refused);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_address_crc_matches_onewire);
+  RUN_TEST(test_scratchpad_crc_on_the_bus);
+  RUN_TEST(test_bit_errors_are_caught);
+  return UNITY_END();
+}
@@ -0,0 +1,603 @@
+// DallasTemperature on the simulated bus: what each call costs in resets
+// and slots, and that the cheaper paths still return what the sensors hold.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// slots of everything the bus did since the last resetStats()
+static uint32_t slots(OneWire& wire) {
+  return wire.getStats().writeSlots + wire.getStats().readSlots;
+}
+
+// the simulated device at an index of the library, which follows the
+// search order and not the order the devices were added in
+static OneWireSimDevice* deviceAt(OneWire& wire, DallasTemperature& sensors, uint8_t index) {
+  DeviceAddress address;
+  TEST_ASSERT_TRUE(sensors.getAddress(address, index));
+  for (uint8_t i = 0; i < wire.getDeviceCount(); i++)
+    if (memcmp(address, wire.getDevice(i)->getAddress(), 8) == 0)
+      return wire.getDevice(i);
+  TEST_FAIL_MESSAGE("address not on the bus");
+  return nullptr;
+}
+
+// once begin() cached the table an address costs no bus time at all, the
+// last index no more than the first
+void test_get_address_uses_the_cache(void) {
+  OneWire wire(1);
+  for (uint32_t i = 0; i < 8; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x1000 + i * 0x111);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_EQUAL(8, sensors.getDeviceCount());
+
+  wire.resetStats();
+  DeviceAddress address;
+  for (uint8_t i = 0; i < 8; i++)
+    TEST_ASSERT_TRUE(sensors.getAddress(address, i));
+  TEST_ASSERT_EQUAL(0, wire.getStats().resets);
+  TEST_ASSERT_EQUAL(0, slots(wire));
+
+  // an index past the table still asks the bus, which has nothing there
+  TEST_ASSERT_FALSE(sensors.getAddress(address, 8));
+  TEST_ASSERT_GREATER_THAN(0, wire.getStats().resets);
+}
+
+// reading every sensor by index: one search pass per read before the
+// cache, a fixed cost per device with it
+void test_read_by_index_cost(void) {
+  OneWire wire(1);
+  for (uint32_t i = 0; i < 8; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x1000 + i * 0x111);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+
+  // what getAddress() used to do for the last index
+  wire.resetStats();
+  uint8_t address[8];
+  wire.reset_search();
+  for (uint8_t i = 0; i < 8; i++)
+    wire.search(address);
+  uint32_t search = slots(wire);
+
+  wire.resetStats();
+  sensors.getTempCByIndex(0);
+  uint32_t first = slots(wire);
+  wire.resetStats();
+  sensors.getTempCByIndex(7);
+  uint32_t last = slots(wire);
+
+  char text[96];
+  snprintf(text, sizeof(text), "search to index 7: %lu slots, cached read: %lu slots",
+           (unsigned long) search, (unsigned long) last);
+  TEST_MESSAGE(text);
+  TEST_ASSERT_EQUAL(first, last);
+  TEST_ASSERT_LESS_THAN(search, last);
+
+  for (uint8_t i = 0; i < 8; i++)
+    TEST_ASSERT_EQUAL_FLOAT(deviceAt(wire, sensors, i)->getTemperature() / 128.0,
+                            sensors.getTempCByIndex(i));
+}
+
+// the table is only as new as the last begin(), rescan() brings it up to
+// date after a sensor was plugged or unplugged
+void test_rescan_follows_hot_plug(void) {
+  OneWire wire(1);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  OneWireSimDevice* unplugged = wire.addDevice(ONEWIRE_SIM_DS18B20, 2);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_EQUAL(2, sensors.getDeviceCount());
+
+  unplugged->setPresent(false);
+  TEST_ASSERT_EQUAL(2, sensors.getDeviceCount());
+  sensors.rescan();
+  TEST_ASSERT_EQUAL(1, sensors.getDeviceCount());
+  TEST_ASSERT_TRUE(deviceAt(wire, sensors, 0) != unplugged);
+
+  OneWireSimDevice* plugged = wire.addDevice(ONEWIRE_SIM_DS1822, 3);
+  plugged->setTemperature(31 * 128);
+  sensors.rescan();
+  TEST_ASSERT_EQUAL(2, sensors.getDeviceCount());
+  sensors.requestTemperatures();
+  bool found = false;
+  for (uint8_t i = 0; i < 2; i++) {
+    if (deviceAt(wire, sensors, i) == plugged) {
+      TEST_ASSERT_EQUAL_FLOAT(31.0, sensors.getTempCByIndex(i));
+      found = true;
+    }
+  }
+  TEST_ASSERT_TRUE(found);
+}
+
+// more sensors than the table holds: the rest are counted and found by a
+// search of the bus, as before the table
+void test_table_capacity(void) {
+  OneWire wire(1);
+  for (uint32_t i = 0; i < DALLAS_MAX_DEVICES + 2; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, i + 1);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_EQUAL(DALLAS_MAX_DEVICES + 2, sensors.getDeviceCount());
+
+  DeviceAddress address;
+  wire.resetStats();
+  TEST_ASSERT_TRUE(sensors.getAddress(address, DALLAS_MAX_DEVICES - 1));
+  TEST_ASSERT_EQUAL(0, slots(wire));
+  TEST_ASSERT_TRUE(sensors.getAddress(address, DALLAS_MAX_DEVICES + 1));
+  TEST_ASSERT_GREATER_THAN(0, slots(wire));
+  TEST_ASSERT_EQUAL_HEX8(address[7], OneWire::crc8(address, 7));
+}
+
+// readAllTemperatures() against a getTemp() loop after the same broadcast,
+// for 1, 4 and 16 sensors: the same values for less bus time
+void test_read_all_cost(void) {
+  static const uint8_t sizes[] = { 1, 4, 16 };
+
+  for (uint8_t s = 0; s < sizeof(sizes); s++) {
+    uint8_t n = sizes[s];
+    OneWire wire(1);
+    for (uint8_t i = 0; i < n; i++)
+      wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i)->setTemperature(20 * 128 + i * 40);
+
+    DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+    sensors.begin();
+    sensors.requestTemperatures();
+
+    int16_t loop[16];
+    wire.resetStats();
+    for (uint8_t i = 0; i < n; i++) {
+      DeviceAddress address;
+      sensors.getAddress(address, i);
+      loop[i] = sensors.getTemp(address);
+    }
+    OneWireSimStats before = wire.getStats();
+
+    int16_t all[16];
+    bool valid[16];
+    wire.resetStats();
+    TEST_ASSERT_EQUAL(n, sensors.readAllTemperatures(all, valid, 16));
+    OneWireSimStats after = wire.getStats();
+
+    for (uint8_t i = 0; i < n; i++) {
+      TEST_ASSERT_TRUE(valid[i]);
+      TEST_ASSERT_EQUAL(loop[i], all[i]);
+      TEST_ASSERT_EQUAL(deviceAt(wire, sensors, i)->getTemperature(), all[i]);
+    }
+    TEST_ASSERT_LESS_THAN(before.resets, after.resets);
+    TEST_ASSERT_LESS_THAN(before.micros, after.micros);
+
+    char text[128];
+    snprintf(text, sizeof(text), "%2u sensors: getTemp() loop %lu resets %lu us, readAllTemperatures() %lu resets %lu us",
+             n, (unsigned long) before.resets, (unsigned long) before.micros,
+             (unsigned long) after.resets, (unsigned long) after.micros);
+    TEST_MESSAGE(text);
+  }
+}
+
+// a sensor that doesn't answer or sends a bad CRC is flagged and reads
+// DEVICE_DISCONNECTED_RAW, the others are unaffected
+void test_read_all_flags_failures(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 4; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i)->setTemperature(25 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+  deviceAt(wire, sensors, 1)->setPresent(false);
+  deviceAt(wire, sensors, 2)->injectCrcErrors(1);
+
+  int16_t temperatures[4];
+  bool valid[4];
+  TEST_ASSERT_EQUAL(2, sensors.readAllTemperatures(temperatures, valid, 4));
+  TEST_ASSERT_TRUE(valid[0]);
+  TEST_ASSERT_FALSE(valid[1]);
+  TEST_ASSERT_FALSE(valid[2]);
+  TEST_ASSERT_TRUE(valid[3]);
+  TEST_ASSERT_EQUAL(25 * 128, temperatures[0]);
+  TEST_ASSERT_EQUAL(DEVICE_DISCONNECTED_RAW, temperatures[1]);
+  TEST_ASSERT_EQUAL(DEVICE_DISCONNECTED_RAW, temperatures[2]);
+  TEST_ASSERT_EQUAL(25 * 128, temperatures[3]);
+
+  // the error was a single one, the next pass is clean again
+  TEST_ASSERT_EQUAL(3, sensors.readAllTemperatures(temperatures, nullptr, 4));
+}
+
+// a short array takes the first devices only and nothing is written past it
+void test_read_all_short_array(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 4; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i)->setTemperature(22 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+
+  int16_t temperatures[4] = { 1, 1, 1, 1 };
+  bool valid[4] = { false, false, false, false };
+  TEST_ASSERT_EQUAL(2, sensors.readAllTemperatures(temperatures, valid, 2));
+  TEST_ASSERT_EQUAL(22 * 128, temperatures[1]);
+  TEST_ASSERT_EQUAL(1, temperatures[2]);
+  TEST_ASSERT_FALSE(valid[2]);
+}
+
+// a fast read clocks the two temperature bytes instead of nine, every Nth
+// sample is a full one
+void test_fast_read_cost(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 4; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i)->setTemperature(30 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+  int16_t temperatures[4];
+
+  // the first pass has no previous value to compare with
+  sensors.setFastRead(4);
+  TEST_ASSERT_EQUAL(4, sensors.getFastReadInterval());
+  wire.resetStats();
+  TEST_ASSERT_EQUAL(4, sensors.readAllTemperatures(temperatures, nullptr, 4));
+  uint32_t full = wire.getStats().readSlots;
+  TEST_ASSERT_EQUAL(4 * 72, full);
+
+  // three fast passes, then a full one
+  for (uint8_t pass = 0; pass < 3; pass++) {
+    wire.resetStats();
+    TEST_ASSERT_EQUAL(4, sensors.readAllTemperatures(temperatures, nullptr, 4));
+    TEST_ASSERT_EQUAL(4 * 16, wire.getStats().readSlots);
+    TEST_ASSERT_EQUAL(30 * 128, temperatures[3]);
+  }
+  wire.resetStats();
+  sensors.readAllTemperatures(temperatures, nullptr, 4);
+  TEST_ASSERT_EQUAL(full, wire.getStats().readSlots);
+
+  // off again, every read is a full one
+  sensors.setFastRead(1);
+  wire.resetStats();
+  sensors.readAllTemperatures(temperatures, nullptr, 4);
+  TEST_ASSERT_EQUAL(full, wire.getStats().readSlots);
+}
+
+// a fast value that moved more than the step is confirmed by a full read
+// right away, a real jump comes through
+void test_fast_read_confirms_a_jump(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  device->setTemperature(30 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.setFastRead(8, 2 * 128);
+  int16_t temperature;
+  sensors.requestTemperatures();
+  sensors.readAllTemperatures(&temperature, nullptr, 1);
+
+  device->setTemperature(31 * 128);
+  sensors.requestTemperatures();
+  wire.resetStats();
+  sensors.readAllTemperatures(&temperature, nullptr, 1);
+  TEST_ASSERT_EQUAL(16, wire.getStats().readSlots);
+  TEST_ASSERT_EQUAL(31 * 128, temperature);
+
+  device->setTemperature(40 * 128);
+  sensors.requestTemperatures();
+  wire.resetStats();
+  sensors.readAllTemperatures(&temperature, nullptr, 1);
+  TEST_ASSERT_EQUAL(16 + 72, wire.getStats().readSlots);
+  TEST_ASSERT_EQUAL(40 * 128, temperature);
+}
+
+// runs passes over sensors with bit errors, counts the readings that came
+// back valid but wrong and the largest error among them
+struct ErrorRun {
+  uint32_t micros;  // reading, the conversions left out
+  uint32_t valid;
+  uint32_t wrong;
+  int32_t worst;
+};
+
+static ErrorRun runWithBitErrors(uint8_t interval, int16_t maxStep, uint32_t perMillion) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 8; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.setFastRead(interval, maxStep);
+  for (uint8_t i = 0; i < 8; i++)
+    wire.getDevice(i)->setBitErrorRate(perMillion);
+
+  ErrorRun run = { 0, 0, 0, 0 };
+  int16_t temperatures[8];
+  bool valid[8];
+  for (int pass = 0; pass < 500; pass++) {
+    // a slow drift, well inside the step
+    for (uint8_t i = 0; i < 8; i++)
+      wire.getDevice(i)->setTemperature(30 * 128 + (pass / 10 + i) * 8);
+    sensors.requestTemperatures();
+    wire.resetStats();
+    sensors.readAllTemperatures(temperatures, valid, 8);
+    run.micros += wire.getStats().micros;
+    for (uint8_t i = 0; i < 8; i++) {
+      if (!valid[i])
+        continue;
+      run.valid++;
+      int32_t error = temperatures[i] - deviceAt(wire, sensors, i)->getTemperature();
+      if (error < 0)
+        error = -error;
+      if (error != 0)
+        run.wrong++;
+      if (error > run.worst)
+        run.worst = error;
+    }
+  }
+  return run;
+}
+
+// the trade-off on a bus flipping one read bit in 2000: full reads let the
+// CRC catch corrupted values, fast reads let some through, but never more
+// than the step away from the last full one plus a bit's worth of drift
+void test_fast_read_with_bit_errors(void) {
+  static const uint8_t intervals[] = { 1, 4, 16 };
+  ErrorRun runs[3];
+
+  for (uint8_t i = 0; i < 3; i++) {
+    runs[i] = runWithBitErrors(intervals[i], 2 * 128, 500);
+    char text[128];
+    snprintf(text, sizeof(text), "full read every %2u: %lu us on the bus, %lu valid, %lu wrong, worst %ld/128 C",
+             intervals[i], (unsigned long) runs[i].micros, (unsigned long) runs[i].valid,
+             (unsigned long) runs[i].wrong, (long) runs[i].worst);
+    TEST_MESSAGE(text);
+  }
+
+  TEST_ASSERT_LESS_THAN(runs[0].micros, runs[1].micros);
+  TEST_ASSERT_LESS_THAN(runs[1].micros, runs[2].micros);
+  TEST_ASSERT_LESS_OR_EQUAL(runs[0].valid / 1000, runs[0].wrong);
+  for (uint8_t i = 1; i < 3; i++)
+    TEST_ASSERT_LESS_OR_EQUAL(2 * 128 + 16, runs[i].worst);
+}
+
+// 16 probes sharing their alarm registers take one SKIP ROM write,
+// tens of ms with the EEPROM copy instead of seconds of searches and reads
+void test_bus_resolution_cost(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 16; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+
+  wire.resetStats();
+  sensors.setResolution(9);
+  uint32_t saved = wire.getStats().micros;
+  for (uint8_t i = 0; i < 16; i++) {
+    TEST_ASSERT_EQUAL(9, wire.getDevice(i)->getResolution());
+    TEST_ASSERT_EQUAL(1, wire.getDevice(i)->getEepromWrites());
+  }
+  TEST_ASSERT_EQUAL(9, sensors.getResolution());
+
+  wire.resetStats();
+  sensors.setResolution(12, false);
+  uint32_t unsaved = wire.getStats().micros;
+  for (uint8_t i = 0; i < 16; i++) {
+    TEST_ASSERT_EQUAL(12, wire.getDevice(i)->getResolution());
+    TEST_ASSERT_EQUAL(1, wire.getDevice(i)->getEepromWrites());
+  }
+  TEST_ASSERT_EQUAL(12, sensors.getResolution());
+
+  char text[96];
+  snprintf(text, sizeof(text), "16 probes: %lu us on the bus with the EEPROM copy, %lu us without",
+           (unsigned long) saved, (unsigned long) unsaved);
+  TEST_MESSAGE(text);
+  TEST_ASSERT_LESS_THAN(50000, saved);
+  TEST_ASSERT_LESS_THAN(10000, unsaved);
+
+  // the resolutions come from the cache, and nothing is written again
+  wire.resetStats();
+  for (uint8_t i = 0; i < 16; i++)
+    TEST_ASSERT_EQUAL(12, sensors.getResolution(wire.getDevice(i)->getAddress()));
+  sensors.setResolution(12);
+  TEST_ASSERT_EQUAL(0, wire.getStats().resets);
+}
+
+// with different alarm registers each device is written on its own, the
+// ones already at the resolution are left alone
+void test_device_resolution_writes_only_differences(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 6; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i);
+  wire.addDevice(ONEWIRE_SIM_DS18S20, 0x200);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.setAlarmWindow(wire.getDevice(0)->getAddress(), 10, 50, false));
+  TEST_ASSERT_TRUE(sensors.setResolution(wire.getDevice(1)->getAddress(), 10, true, false));
+  TEST_ASSERT_TRUE(sensors.setResolution(wire.getDevice(2)->getAddress(), 10, true, false));
+
+  uint32_t eeprom[7];
+  for (uint8_t i = 0; i < 7; i++)
+    eeprom[i] = wire.getDevice(i)->getEepromWrites();
+
+  wire.resetStats();
+  sensors.setResolution(10);
+  TEST_ASSERT_EQUAL(4, wire.getStats().eepromWrites);
+  for (uint8_t i = 0; i < 6; i++)
+    TEST_ASSERT_EQUAL(10, wire.getDevice(i)->getResolution());
+  TEST_ASSERT_EQUAL(eeprom[1], wire.getDevice(1)->getEepromWrites());
+  TEST_ASSERT_EQUAL(eeprom[2], wire.getDevice(2)->getEepromWrites());
+  TEST_ASSERT_EQUAL(eeprom[6], wire.getDevice(6)->getEepromWrites());
+  // the DS18S20 counts as 12 bits
+  TEST_ASSERT_EQUAL(12, sensors.getResolution());
+
+  // the alarm window set before survived the write
+  TEST_ASSERT_EQUAL(50, sensors.getHighAlarmTemp(wire.getDevice(0)->getAddress()));
+  TEST_ASSERT_EQUAL(10, sensors.getLowAlarmTemp(wire.getDevice(0)->getAddress()));
+}
+
+// the same alarm registers everywhere but some devices already at the
+// resolution, or a DS18S20 on the bus: only the devices that change copy
+// to EEPROM. Without the copy the broadcast still serves.
+void test_resolution_copies_only_changed_devices(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 6; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x100 + i);
+  OneWireSimDevice* ds18s20 = wire.addDevice(ONEWIRE_SIM_DS18S20, 0x200);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.setResolution(wire.getDevice(0)->getAddress(), 10, true, false));
+  TEST_ASSERT_TRUE(sensors.setResolution(wire.getDevice(1)->getAddress(), 10, true, false));
+
+  wire.resetStats();
+  sensors.setResolution(10);
+  TEST_ASSERT_EQUAL(4, wire.getStats().eepromWrites);
+  for (uint8_t i = 0; i < 6; i++) {
+    TEST_ASSERT_EQUAL(10, wire.getDevice(i)->getResolution());
+    TEST_ASSERT_EQUAL(i < 2 ? 0 : 1, wire.getDevice(i)->getEepromWrites());
+  }
+  TEST_ASSERT_EQUAL(0, ds18s20->getEepromWrites());
+
+  // all of them change, the DS18S20 still keeps its EEPROM
+  wire.resetStats();
+  sensors.setResolution(11);
+  TEST_ASSERT_EQUAL(6, wire.getStats().eepromWrites);
+  TEST_ASSERT_EQUAL(0, ds18s20->getEepromWrites());
+
+  // without the copy one SKIP ROM write does it
+  wire.resetStats();
+  sensors.setResolution(9, false);
+  TEST_ASSERT_EQUAL(0, wire.getStats().eepromWrites);
+  TEST_ASSERT_EQUAL(2, wire.getStats().resets);
+  for (uint8_t i = 0; i < 6; i++)
+    TEST_ASSERT_EQUAL(9, wire.getDevice(i)->getResolution());
+}
+
+// index of an address among the simulated devices, the count if unknown
+static uint8_t simIndex(OneWire& wire, const uint8_t* address) {
+  uint8_t i = 0;
+  while (i < wire.getDeviceCount() && memcmp(address, wire.getDevice(i)->getAddress(), 8) != 0)
+    i++;
+  return i;
+}
+
+// alarmSweep() against the alarm flags of the simulated sensors on 300
+// random buses: mixed families, serial numbers random or close together,
+// random windows and buffer sizes. It finds exactly the alarming devices,
+// each once, in fewer slots than walking all 64 bits for every one of them.
+void test_alarm_sweep_on_random_buses(void) {
+  srand(18);
+  uint32_t sweepSlots = 0;
+  uint32_t walkSlots = 0;
+
+  for (int trial = 0; trial < 300; trial++) {
+    OneWire wire(1);
+    uint8_t n = 1 + rand() % DALLAS_MAX_DEVICES;
+    bool close = rand() % 2;
+    for (uint8_t i = 0; i < n; i++) {
+      uint8_t family = rand() % 4 == 0 ? ONEWIRE_SIM_DS18S20
+                       : rand() % 2 ? ONEWIRE_SIM_DS18B20 : ONEWIRE_SIM_DS1822;
+      wire.addDevice(family, close ? i + 1 : (uint32_t) rand());
+    }
+
+    DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+    sensors.begin();
+    TEST_ASSERT_EQUAL(n, sensors.getDeviceCount());
+    for (uint8_t i = 0; i < n; i++) {
+      int8_t low = 10 + rand() % 20;
+      TEST_ASSERT_TRUE(sensors.setAlarmWindow(wire.getDevice(i)->getAddress(), low, low + rand() % 10));
+      wire.getDevice(i)->setTemperature((rand() % 50) * 128);
+    }
+    sensors.requestTemperatures();
+    // the flags latch with the next bus activity
+    wire.reset();
+
+    bool expected[ONEWIRE_SIM_MAX_DEVICES];
+    bool anyExpected = false;
+    for (uint8_t i = 0; i < n; i++) {
+      expected[i] = wire.getDevice(i)->hasAlarm();
+      anyExpected |= expected[i];
+    }
+
+    bool found[ONEWIRE_SIM_MAX_DEVICES] = { false };
+    uint8_t count = 1 + rand() % 4;
+    DeviceAddress buffer[4];
+    uint8_t got;
+    int calls = 0;
+    sensors.resetAlarmSearch();
+    wire.resetStats();
+    do {
+      got = sensors.alarmSweep(buffer, count);
+      for (uint8_t k = 0; k < got; k++) {
+        uint8_t i = simIndex(wire, buffer[k]);
+        TEST_ASSERT_LESS_THAN(n, i);
+        TEST_ASSERT_FALSE(found[i]);
+        found[i] = true;
+      }
+      TEST_ASSERT_LESS_THAN(n + 2, ++calls);
+    } while (got == count);
+    sweepSlots += slots(wire);
+
+    uint8_t alarming = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL(expected[i], found[i]);
+      alarming += expected[i];
+    }
+    // the search command and three slots per ROM bit, per device
+    walkSlots += alarming * (8 + 64 * 3);
+
+    // the answer is in the first bit pair
+    wire.resetStats();
+    TEST_ASSERT_EQUAL(anyExpected, sensors.hasAlarm());
+    TEST_ASSERT_EQUAL(8 + 2, slots(wire));
+
+    // alarmSearch() one device per call, the same devices
+    DeviceAddress address;
+    uint8_t searched = 0;
+    sensors.resetAlarmSearch();
+    while (sensors.alarmSearch(address)) {
+      TEST_ASSERT_TRUE(expected[simIndex(wire, address)]);
+      searched++;
+    }
+    TEST_ASSERT_EQUAL(alarming, searched);
+  }
+
+  char text[96];
+  snprintf(text, sizeof(text), "300 buses: alarmSweep() %lu slots, full walks %lu slots",
+           (unsigned long) sweepSlots, (unsigned long) walkSlots);
+  TEST_MESSAGE(text);
+  TEST_ASSERT_LESS_THAN(walkSlots / 2, sweepSlots);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_get_address_uses_the_cache);
+  RUN_TEST(test_read_by_index_cost);
+  RUN_TEST(test_rescan_follows_hot_plug);
+  RUN_TEST(test_table_capacity);
+  RUN_TEST(test_read_all_cost);
+  RUN_TEST(test_read_all_flags_failures);
+  RUN_TEST(test_read_all_short_array);
+  RUN_TEST(test_fast_read_cost);
+  RUN_TEST(test_fast_read_confirms_a_jump);
+  RUN_TEST(test_fast_read_with_bit_errors);
+  RUN_TEST(test_bus_resolution_cost);
+  RUN_TEST(test_device_resolution_writes_only_differences);
+  RUN_TEST(test_resolution_copies_only_changed_devices);
+  RUN_TEST(test_alarm_sweep_on_random_buses);
+  return UNITY_END();
+}
@@ -0,0 +1,157 @@
+// FanCurve tables against the piecewise linear formula they are compiled
+// from, the follower's hysteresis, and the table load against the float
+// path it replaced.
+
+#include <unity.h>
+#include <stdio.h>
+#include <time.h>
+#include "FanCurve.h"
+
+// the sketch's curves
+typedef FanCurve<30, 20, 70, 100> LinearCurve;
+typedef FanCurve<35, 20, 50, 35, 60, 60, 70, 100> QuietCurve;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// piecewise linear in floating point, the breakpoints as pairs
+static double reference(const int* points, unsigned count, double celsius) {
+  if (celsius <= points[0])
+    return points[1];
+  for (unsigned k = 0; k + 1 < count; k++) {
+    double t0 = points[2 * k], t1 = points[2 * k + 2];
+    if (celsius < t1)
+      return points[2 * k + 1] + (points[2 * k + 3] - points[2 * k + 1]) * (celsius - t0) / (t1 - t0);
+  }
+  return points[2 * count - 1];
+}
+
+// every entry is the formula at the start of its step, truncated
+template <class Curve>
+static void checkTable(void) {
+  for (unsigned i = 0; i < FAN_CURVE_STEPS; i++) {
+    double celsius = Curve::stepRaw(i) / 128.0;
+    double expected = reference(Curve::points, Curve::pointCount, celsius);
+    TEST_ASSERT_FLOAT_WITHIN(1.0, expected, Curve::table()[i]);
+    TEST_ASSERT_TRUE(Curve::table()[i] <= expected + 1e-9);
+  }
+}
+
+void test_table_matches_the_formula(void) {
+  checkTable<LinearCurve>();
+  checkTable<QuietCurve>();
+  TEST_ASSERT_TRUE(LinearCurve::isMonotonic());
+  TEST_ASSERT_TRUE(QuietCurve::isInRange());
+}
+
+// a lookup lands on the step below the raw value, clamped at both ends
+void test_lookup(void) {
+  TEST_ASSERT_EQUAL(20, LinearCurve::lookup(-20 * 128));
+  TEST_ASSERT_EQUAL(20, LinearCurve::lookup(30 * 128));
+  TEST_ASSERT_EQUAL(60, LinearCurve::lookup(50 * 128));
+  TEST_ASSERT_EQUAL(60, LinearCurve::lookup(50 * 128 + 63));
+  TEST_ASSERT_EQUAL(61, LinearCurve::lookup(50 * 128 + 64));
+  TEST_ASSERT_EQUAL(100, LinearCurve::lookup(70 * 128));
+  TEST_ASSERT_EQUAL(100, LinearCurve::lookup(125 * 128));
+  TEST_ASSERT_EQUAL(35, QuietCurve::lookup(50 * 128));
+  TEST_ASSERT_EQUAL(60, QuietCurve::lookup(60 * 128));
+  TEST_ASSERT_EQUAL(0, fanCurveStep(-55 * 128));
+  TEST_ASSERT_EQUAL(250, fanCurveStep(125 * 128));
+  TEST_ASSERT_EQUAL(FAN_CURVE_STEPS - 1, fanCurveStep(130 * 128));
+}
+
+// the linear curve stays within a percent of map() on whole degrees over
+// the range the sketch used it
+void test_linear_curve_against_map(void) {
+  for (int16_t raw = 30 * 128; raw <= 70 * 128; raw += 8) {
+    long celsius = raw / 128;
+    long mapped = (celsius - 30) * (100 - 20) / (70 - 30) + 20;
+    long duty = LinearCurve::lookup(raw);
+    TEST_ASSERT_TRUE(duty >= mapped && duty <= mapped + 1);
+  }
+}
+
+// a disconnected probe reads -55 degrees, below every curve, but must run
+// the fans flat out rather than at the bottom duty
+void test_disconnected_probe_runs_full_duty(void) {
+  TEST_ASSERT_EQUAL(100, LinearCurve::lookup(TEMP128_INVALID));
+  TEST_ASSERT_EQUAL(100, QuietCurve::lookup(TEMP128_INVALID));
+  TEST_ASSERT_EQUAL(20, LinearCurve::lookup(TEMP128_INVALID + 1));
+
+  FanCurveFollower follower;
+  follower.setCurve(LinearCurve::table(), 4);
+  TEST_ASSERT_EQUAL(40, follower.update(40 * 128));
+  TEST_ASSERT_EQUAL(100, follower.update(TEMP128_INVALID));
+  TEST_ASSERT_EQUAL(100, follower.getDutyCycle());
+  // readings return, the duty falls through the hysteresis band
+  TEST_ASSERT_EQUAL(44, follower.update(40 * 128));
+  TEST_ASSERT_EQUAL(40, follower.update(38 * 128));
+}
+
+// rising follows the curve at once, falling waits for the band
+void test_follower_hysteresis(void) {
+  FanCurveFollower follower;
+  TEST_ASSERT_EQUAL(0, follower.update(50 * 128));
+  follower.setCurve(LinearCurve::table(), 4);
+
+  TEST_ASSERT_EQUAL(40, follower.update(40 * 128));
+  TEST_ASSERT_EQUAL(60, follower.update(50 * 128));
+  // 4 steps of half a degree
+  TEST_ASSERT_EQUAL(60, follower.update(49 * 128));
+  TEST_ASSERT_EQUAL(60, follower.update(48 * 128));
+  TEST_ASSERT_EQUAL(59, follower.update(47 * 128 + 64));
+  TEST_ASSERT_EQUAL(56, follower.update(46 * 128));
+  TEST_ASSERT_EQUAL(56, follower.update(47 * 128));
+  TEST_ASSERT_EQUAL(62, follower.update(51 * 128));
+  TEST_ASSERT_EQUAL(62, follower.getDutyCycle());
+}
+
+// the path the sketch had: raw to float degrees, then map()
+static long mapPath(int16_t raw) {
+  float celsius = (float) raw * 0.0078125f;
+  return ((long) celsius - 30) * (100 - 20) / (70 - 30) + 20;
+}
+
+static volatile long sink;
+
+// table load against float and map() over every raw value of the probes'
+// range, reported only. The table is not the faster path on a host, an
+// optimised x86 build measured about 6 ns against 3 ns: the clamping and
+// the table load cost more than one multiply and divide there. Nothing
+// here measures the ESP32.
+void test_lookup_benchmark(void) {
+  const int rounds = 50;
+  long sum = 0;
+
+  clock_t start = clock();
+  for (int r = 0; r < rounds; r++)
+    for (int32_t raw = -55 * 128; raw <= 125 * 128; raw++)
+      sum += LinearCurve::lookup((int16_t) raw);
+  clock_t table = clock() - start;
+  sink = sum;
+
+  sum = 0;
+  start = clock();
+  for (int r = 0; r < rounds; r++)
+    for (int32_t raw = -55 * 128; raw <= 125 * 128; raw++)
+      sum += mapPath((int16_t) raw);
+  clock_t path = clock() - start;
+  sink = sum;
+
+  double count = rounds * 180.0 * 128;
+  char text[96];
+  snprintf(text, sizeof(text), "table %.2f ns, float and map() %.2f ns per evaluation",
+           table * 1e9 / CLOCKS_PER_SEC / count, path * 1e9 / CLOCKS_PER_SEC / count);
+  TEST_MESSAGE(text);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_table_matches_the_formula);
+  RUN_TEST(test_lookup);
+  RUN_TEST(test_linear_curve_against_map);
+  RUN_TEST(test_disconnected_probe_runs_full_duty);
+  RUN_TEST(test_follower_hysteresis);
+  RUN_TEST(test_lookup_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,218 @@
+// FanPid against the former map() law on a simulated NUC: a thermal RC
+// model cooled by a fan whose airflow follows its duty, sampled by a probe
+// with 1/16 degree C steps and a bit of noise every 750 ms.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "FanPid.h"
+#include "FixedTemp.h"
+
+// control tick and probe period in ms, as in the sketch
+#define TICK_MS 100
+#define SAMPLE_MS 750
+
+// the sketch's controller settings
+#define SETPOINT_C 45
+#define MIN_DUTY 20
+#define MAX_DUTY 100
+#define DUTY_SLEW_RATE 10
+
+// heat capacity in J/K, ambient in degrees C, conductance in W/K without
+// airflow and added at full airflow
+#define PLANT_CAPACITY 400.0
+#define PLANT_AMBIENT 25.0
+#define PLANT_STILL 0.3
+#define PLANT_AIRFLOW 1.5
+
+// fan: no airflow below the minimum duty it starts at, full at 100%
+#define FAN_START_DUTY 15
+#define FAN_MAX_RPM 3000
+
+struct Plant {
+  double temperature;
+  double power;
+
+  void step(uint8_t duty, uint16_t ms) {
+    double airflow = duty < FAN_START_DUTY ? 0 : duty / 100.0;
+    double conductance = PLANT_STILL + PLANT_AIRFLOW * airflow;
+    temperature += (power - conductance * (temperature - PLANT_AMBIENT)) / PLANT_CAPACITY * ms / 1000;
+  }
+
+  unsigned int rpm(uint8_t duty) {
+    return duty < FAN_START_DUTY ? 0 : (unsigned int) FAN_MAX_RPM * duty / 100;
+  }
+
+  // a DS18B20 at 12 bits, noise of one step either way
+  Temp128 sample(void) {
+    int16_t steps = (int16_t) (temperature * 16) + rand() % 3 - 1;
+    return steps * 8;
+  }
+};
+
+// the control law a run uses
+typedef uint8_t (*Law)(Temp128 measured, unsigned int rpm, uint16_t dt);
+
+static FanPid pid;
+
+static uint8_t pidLaw(Temp128 measured, unsigned int rpm, uint16_t dt) {
+  return pid.update(measured, rpm, dt);
+}
+
+// speed=map(temperatureC, 30,70,20,100) on whole degrees, unclamped
+static uint8_t mapLaw(Temp128 measured, unsigned int, uint16_t) {
+  long celsius = measured / 128;
+  long duty = (celsius - 30) * (100 - 20) / (70 - 30) + 20;
+  if (duty < 0)
+    duty = 0;
+  if (duty > 255)
+    duty = 255;
+  return duty > 100 ? 100 : duty;
+}
+
+struct Result {
+  double settlingSeconds;   // until the temperature stays within 1 C of its end value
+  double finalTemperature;  // mean over the last minute
+  double meanDuty;          // over the whole run
+  double meanPower;         // fan power, duty cubed, relative to full speed
+  unsigned long dutyTravel; // sum of duty changes over the last minute
+};
+
+// load steps from idle to work at t = 0, run for the given time
+static Result run(Law law, double idle, double work, unsigned long seconds) {
+  Plant plant;
+  TempFilter filter;
+  Result result = { 0, 0, 0, 0, 0 };
+
+  srand(7);
+  plant.power = idle;
+  plant.temperature = PLANT_AMBIENT + idle / (PLANT_STILL + PLANT_AIRFLOW * 0.4);
+  pid.setSetpoint(SETPOINT_C * 128);
+  pid.setOutputLimits(MIN_DUTY, MAX_DUTY);
+  pid.setSlewRate(DUTY_SLEW_RATE);
+  pid.setStallCheck(true);
+  pid.reset(40);
+
+  unsigned long ticks = seconds * 1000 / TICK_MS;
+  unsigned long lastMinute = ticks - 60000 / TICK_MS;
+  double *history = new double[ticks];
+  Temp128 measured = filter.update(plant.sample());
+  uint8_t duty = 40;
+  uint8_t lastDuty = duty;
+  double dutySum = 0;
+  double powerSum = 0;
+
+  plant.power = work;
+  for (unsigned long t = 0; t < ticks; t++) {
+    if (t * TICK_MS % SAMPLE_MS < TICK_MS)
+      measured = filter.update(plant.sample());
+    duty = law(measured, plant.rpm(duty), TICK_MS);
+    plant.step(duty, TICK_MS);
+
+    history[t] = plant.temperature;
+    dutySum += duty;
+    powerSum += (duty / 100.0) * (duty / 100.0) * (duty / 100.0);
+    if (t >= lastMinute) {
+      result.finalTemperature += plant.temperature;
+      result.dutyTravel += duty > lastDuty ? duty - lastDuty : lastDuty - duty;
+    }
+    lastDuty = duty;
+  }
+
+  result.finalTemperature /= ticks - lastMinute;
+  result.meanDuty = dutySum / ticks;
+  result.meanPower = powerSum / ticks;
+  unsigned long settled = ticks;
+  while (settled > 0 && history[settled - 1] < result.finalTemperature + 1
+         && history[settled - 1] > result.finalTemperature - 1)
+    settled--;
+  result.settlingSeconds = settled * TICK_MS / 1000.0;
+  delete[] history;
+  return result;
+}
+
+static void report(const char* name, const Result& r) {
+  char text[128];
+  snprintf(text, sizeof(text), "%s: settles in %.0f s at %.2f C, mean duty %.1f%%, fan power %.3f, duty travel %lu%%/min",
+           name, r.settlingSeconds, r.finalTemperature, r.meanDuty, r.meanPower, r.dutyTravel);
+  TEST_MESSAGE(text);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// a load step from 5 W to 20 W. The plant's time constant is some 10
+// minutes, the integral takes a little longer than the proportional law to
+// get there, and then holds the duty nearly still on the noisy probe.
+void test_load_step(void) {
+  Result p = run(pidLaw, 5, 20, 1800);
+  Result m = run(mapLaw, 5, 20, 1800);
+  report("pid", p);
+  report("map", m);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.5, SETPOINT_C, p.finalTemperature);
+  TEST_ASSERT_TRUE(p.settlingSeconds < m.settlingSeconds * 3 / 2);
+  TEST_ASSERT_TRUE(p.dutyTravel <= 10);
+}
+
+// the PID ends at the setpoint whatever the load, the map() law wherever
+// its line crosses the plant
+void test_setpoint_across_loads(void) {
+  Result p16 = run(pidLaw, 5, 16, 1800);
+  Result p28 = run(pidLaw, 5, 28, 1800);
+  Result m16 = run(mapLaw, 5, 16, 1800);
+  Result m28 = run(mapLaw, 5, 28, 1800);
+  report("pid 16 W", p16);
+  report("pid 28 W", p28);
+  report("map 16 W", m16);
+  report("map 28 W", m28);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.5, SETPOINT_C, p16.finalTemperature);
+  TEST_ASSERT_FLOAT_WITHIN(0.5, SETPOINT_C, p28.finalTemperature);
+  TEST_ASSERT_TRUE(m28.finalTemperature - m16.finalTemperature > 2);
+}
+
+// with a light load the PID stays on its minimum duty below the setpoint,
+// the map() law spends more airflow holding the NUC cooler than needed
+void test_light_load_energy(void) {
+  Result p = run(pidLaw, 3, 8, 1800);
+  Result m = run(mapLaw, 3, 8, 1800);
+  report("pid", p);
+  report("map", m);
+
+  TEST_ASSERT_TRUE(p.meanPower < m.meanPower);
+  TEST_ASSERT_TRUE(p.meanDuty < m.meanDuty);
+  TEST_ASSERT_TRUE(p.finalTemperature <= SETPOINT_C + 0.5);
+}
+
+// the PID output never leaves its limits or changes faster than the slew
+// rate, the stall check stays quiet while the fan turns
+void test_output_limits_and_slew(void) {
+  Plant plant;
+  plant.power = 60;
+  plant.temperature = 30;
+  pid.setSetpoint(SETPOINT_C * 128);
+  pid.setOutputLimits(MIN_DUTY, MAX_DUTY);
+  pid.setSlewRate(DUTY_SLEW_RATE);
+  pid.setStallCheck(true);
+  pid.reset(MIN_DUTY);
+
+  uint8_t last = MIN_DUTY;
+  for (int t = 0; t < 6000; t++) {
+    uint8_t duty = pid.update(plant.sample(), plant.rpm(last), TICK_MS);
+    plant.step(duty, TICK_MS);
+    TEST_ASSERT_TRUE(duty >= MIN_DUTY && duty <= MAX_DUTY);
+    TEST_ASSERT_TRUE(abs(duty - last) <= 2);
+    TEST_ASSERT_FALSE(pid.isStalled());
+    last = duty;
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_load_step);
+  RUN_TEST(test_setpoint_across_loads);
+  RUN_TEST(test_light_load_energy);
+  RUN_TEST(test_output_limits_and_slew);
+  return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// FanTacho on synthetic tacho edge timestamps.
+
+#include <unity.h>
+#include "FanRpm.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// edges of a fan at a steady speed, FAN_PULSES_PER_REV per revolution
+static uint32_t spin(FanTacho& tacho, uint32_t start, unsigned int rpm, uint8_t revolutions) {
+  uint32_t pulse = 60000000UL / rpm / FAN_PULSES_PER_REV;
+  uint32_t now = start;
+  for (uint8_t i = 0; i < revolutions * FAN_PULSES_PER_REV; i++) {
+    now += pulse;
+    tacho.edge(now);
+  }
+  return now;
+}
+
+void test_rpm_from_period(void) {
+  TEST_ASSERT_EQUAL(0, FanTacho::rpmFromPeriod(0));
+  TEST_ASSERT_EQUAL(1000, FanTacho::rpmFromPeriod(60000));
+  TEST_ASSERT_EQUAL(3000, FanTacho::rpmFromPeriod(20000));
+  TEST_ASSERT_EQUAL(60000000UL, FanTacho::rpmFromPeriod(1));
+}
+
+// one revolution after the first edge gives the speed
+void test_speed_after_one_revolution(void) {
+  FanTacho tacho;
+  TEST_ASSERT_EQUAL(0, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), 0));
+
+  uint32_t now = spin(tacho, 1000000, 1500, 1);
+  TEST_ASSERT_EQUAL(0, tacho.getPeriod());
+  now = spin(tacho, now, 1500, 1);
+  TEST_ASSERT_EQUAL(40000, tacho.getPeriod());
+  TEST_ASSERT_EQUAL(1500, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), now));
+}
+
+// a new speed shows after one revolution at it, not after a second
+void test_speed_change_latency(void) {
+  FanTacho tacho;
+  uint32_t now = spin(tacho, 1000000, 1200, 3);
+  TEST_ASSERT_EQUAL(1200, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), now));
+
+  now = spin(tacho, now, 2400, 1);
+  TEST_ASSERT_EQUAL(2400, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), now));
+}
+
+// PWM crosstalk closer than FAN_MIN_EDGE_US to a pulse is ignored
+void test_crosstalk_is_filtered(void) {
+  FanTacho tacho;
+  uint32_t now = spin(tacho, 1000000, 1800, 2);
+  for (uint8_t i = 0; i < 10; i++) {
+    tacho.edge(now + FAN_MIN_EDGE_US / 2);
+    now = spin(tacho, now, 1800, 1);
+  }
+  TEST_ASSERT_EQUAL(1800, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), now));
+}
+
+// a fan slowing down reports the lower bound of the revolution in progress,
+// and 0 once it stopped
+void test_slowing_and_stall(void) {
+  FanTacho tacho;
+  uint32_t now = spin(tacho, 1000000, 3000, 2);
+  uint32_t period = tacho.getPeriod();
+  uint32_t last = tacho.getLastEdge();
+
+  TEST_ASSERT_EQUAL(3000, FanTacho::rpmFromEdges(period, last, now + 5000));
+  TEST_ASSERT_EQUAL(1000, FanTacho::rpmFromEdges(period, last, now + 30000));
+  TEST_ASSERT_EQUAL(0, FanTacho::rpmFromEdges(period, last, now + FAN_STALL_TIMEOUT_US + 1));
+}
+
+// edges after a stall start over, the revolution across the stall counts
+// for nothing
+void test_restart_after_stall(void) {
+  FanTacho tacho;
+  uint32_t now = spin(tacho, 1000000, 2000, 2);
+  now += FAN_STALL_TIMEOUT_US + 100000;
+  tacho.edge(now);
+  TEST_ASSERT_EQUAL(0, tacho.getPeriod());
+
+  now = spin(tacho, now, 600, 1);
+  TEST_ASSERT_EQUAL(600, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), now));
+}
+
+// the microsecond clock wraps after about 71 minutes
+void test_clock_wrap(void) {
+  FanTacho tacho;
+  uint32_t now = spin(tacho, 0xFFFFFFFFUL - 50000, 1500, 3);
+  TEST_ASSERT_TRUE(now < 0xFFFFFFFFUL - 50000);
+  TEST_ASSERT_EQUAL(1500, FanTacho::rpmFromEdges(tacho.getPeriod(), tacho.getLastEdge(), now));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rpm_from_period);
+  RUN_TEST(test_speed_after_one_revolution);
+  RUN_TEST(test_speed_change_latency);
+  RUN_TEST(test_crosstalk_is_filtered);
+  RUN_TEST(test_slowing_and_stall);
+  RUN_TEST(test_restart_after_stall);
+  RUN_TEST(test_clock_wrap);
+  return UNITY_END();
+}
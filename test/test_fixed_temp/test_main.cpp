@@ -0,0 +1,180 @@
+// The fixed-point temperature path against the floating point it replaced:
+// conversion and text exact to the hundredth, the filter and the PID within
+// a step of a float model of the same law.
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FixedTemp.h"
+#include "FanPid.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_from_celsius_and_offset(void) {
+  TEST_ASSERT_EQUAL(45 * 128, FixedTemp::fromCelsius(45));
+  TEST_ASSERT_EQUAL(-10 * 128, FixedTemp::fromCelsius(-10));
+  TEST_ASSERT_EQUAL(INT16_MAX, FixedTemp::fromCelsius(300));
+  // -55 C exactly is the missing reading marker, anything below is clipped
+  // just above it
+  TEST_ASSERT_EQUAL(TEMP128_INVALID + 1, FixedTemp::fromCelsius(-60));
+
+  TEST_ASSERT_EQUAL(21 * 128 + 64, FixedTemp::addOffset(20 * 128, 192));
+  TEST_ASSERT_EQUAL(TEMP128_INVALID, FixedTemp::addOffset(TEMP128_INVALID, 128));
+  TEST_ASSERT_EQUAL(INT16_MAX, FixedTemp::addOffset(INT16_MAX - 10, 128));
+  TEST_ASSERT_EQUAL(TEMP128_INVALID + 1, FixedTemp::addOffset(TEMP128_INVALID + 10, -128));
+}
+
+// every raw value, against rounding the float half away from zero
+void test_centi_celsius_is_exact(void) {
+  for (int32_t raw = INT16_MIN; raw <= INT16_MAX; raw++)
+    TEST_ASSERT_EQUAL(lround(raw * 100.0 / 128), FixedTemp::toCentiCelsius((Temp128) raw));
+}
+
+// every value a probe reads above the marker, against printf of the float.
+// They differ only on exact halves of a hundredth, which printf rounds to
+// even.
+void test_format_against_printf(void) {
+  char text[TEMP128_TEXT_SIZE];
+  char expected[16];
+
+  for (int32_t raw = TEMP128_INVALID + 1; raw <= 125 * 128; raw++) {
+    uint8_t length = FixedTemp::format(text, (Temp128) raw);
+    TEST_ASSERT_EQUAL(strlen(text), length);
+    snprintf(expected, sizeof(expected), "%.2f", raw / 128.0);
+    if ((raw * 100) % 128 == 64 || (raw * 100) % 128 == -64)
+      TEST_ASSERT_FLOAT_WITHIN(0.0100001, raw / 128.0, atof(text));
+    else
+      TEST_ASSERT_EQUAL_STRING(expected, text);
+  }
+
+  FixedTemp::format(text, -1);
+  TEST_ASSERT_EQUAL_STRING("-0.01", text);
+  FixedTemp::format(text, TEMP128_INVALID);
+  TEST_ASSERT_EQUAL_STRING("-127.00", text);
+  TEST_ASSERT_EQUAL(7, FixedTemp::format(text, INT16_MIN));
+}
+
+// the Q8 filter stays within one step of the float filter on a noisy ramp
+void test_filter_against_float(void) {
+  srand(8);
+  for (uint8_t shift = 1; shift <= 4; shift++) {
+    TempFilter filter(shift);
+    double reference = 0;
+    for (int i = 0; i < 20000; i++) {
+      Temp128 sample = 20 * 128 + i / 4 + rand() % 33 - 16;
+      Temp128 value = filter.update(sample);
+      reference = i == 0 ? sample : reference + (sample - reference) / (1 << shift);
+      TEST_ASSERT_FLOAT_WITHIN(1.0, reference, value);
+    }
+  }
+
+  TempFilter filter;
+  filter.update(30 * 128);
+  TEST_ASSERT_EQUAL(TEMP128_INVALID, filter.update(TEMP128_INVALID));
+  TEST_ASSERT_EQUAL(40 * 128, filter.update(40 * 128));
+}
+
+// the same control law in double
+struct PidModel {
+  double kp, ki, kd, setpoint, low, high, slew;
+  double integral, derivative, output, last;
+  bool hasLast;
+
+  double update(double measured, double dt) {
+    double error = measured - setpoint;
+    double p = kp * error;
+    double lastIntegral = integral;
+    integral = fmin(fmax(integral + ki * error * dt, 0), high);
+    if (hasLast)
+      derivative += (kd * (measured - last) / dt - derivative) / 4;
+    last = measured;
+    hasLast = true;
+    double u = p + integral + derivative;
+    if ((u > high && error > 0) || (u < low && error < 0)) {
+      u -= integral - lastIntegral;
+      integral = lastIntegral;
+    }
+    u = fmin(fmax(u, low), high);
+    if (slew != 0)
+      u = fmin(fmax(u, output - slew * dt), output + slew * dt);
+    output = u;
+    return output;
+  }
+};
+
+// a noisy probe swinging through the setpoint: the fixed-point duty follows
+// the float model within one percent
+void test_pid_against_float(void) {
+  FanPid pid;
+  pid.setTunings(6 * 256, 64, 20 * 256);
+  pid.setSetpoint(45 * 128);
+  pid.setOutputLimits(20, 100);
+  pid.setSlewRate(10);
+  pid.reset(40);
+
+  PidModel model = { 6, 0.25, 20, 45, 20, 100, 10, 40, 0, 40, 0, false };
+
+  srand(88);
+  int worst = 0;
+  for (int i = 0; i < 20000; i++) {
+    double celsius = 45 + 8 * sin(i / 300.0) + (rand() % 5 - 2) / 16.0;
+    Temp128 raw = (Temp128) lround(celsius * 16) * 8;
+    int duty = pid.update(raw, 1000, 100);
+    double expected = model.update(raw / 128.0, 0.1);
+    int error = abs(duty - (int) lround(expected));
+    if (error > worst)
+      worst = error;
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(1, worst);
+}
+
+static volatile int32_t sink;
+
+// one control iteration on each path: offset, filter, control law and the
+// text of the status line. Reported only, the host has an FPU.
+void test_control_iteration_benchmark(void) {
+  const int iterations = 200000;
+  char text[16];
+
+  FanPid pid;
+  TempFilter filter;
+  clock_t start = clock();
+  for (int i = 0; i < iterations; i++) {
+    Temp128 t = FixedTemp::addOffset(30 * 128 + (i & 2047), -256);
+    t = filter.update(t);
+    sink = pid.update(t, 1000, 100);
+    sink = FixedTemp::format(text, t);
+  }
+  clock_t fixed = clock() - start;
+
+  PidModel model = { 4, 0.1, 0, 45, 20, 100, 0, 20, 0, 20, 0, false };
+  float smoothed = 0;
+  start = clock();
+  for (int i = 0; i < iterations; i++) {
+    float t = (30 * 128 + (i & 2047)) * 0.0078125f - 2;
+    smoothed += (t - smoothed) / 4;
+    sink = (int32_t) model.update(smoothed, 0.1);
+    sink = snprintf(text, sizeof(text), "%.2f", smoothed);
+  }
+  clock_t floating = clock() - start;
+
+  char message[96];
+  snprintf(message, sizeof(message), "fixed %.0f ns, float %.0f ns per control iteration",
+           fixed * 1e9 / CLOCKS_PER_SEC / iterations, floating * 1e9 / CLOCKS_PER_SEC / iterations);
+  TEST_MESSAGE(message);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_from_celsius_and_offset);
+  RUN_TEST(test_centi_celsius_is_exact);
+  RUN_TEST(test_format_against_printf);
+  RUN_TEST(test_filter_against_float);
+  RUN_TEST(test_pid_against_float);
+  RUN_TEST(test_control_iteration_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,293 @@
+// Max31865 against a register level fake of the chip on a fake SPI bus:
+// configuration, the reader side queue, fault latch and clear, the burst
+// read of the polled mode and the fault detection cycle of
+// RtdFaultSupervisor.
+
+#include <unity.h>
+#include <string.h>
+#include "Max31865.h"
+#include "RtdFaultSupervisor.h"
+
+// register file of one chip, the address auto-increments within a transfer
+class FakeChip : public Max31865Bus {
+public:
+  uint8_t registers[MAX31865_REG_COUNT];
+  bool present;
+  bool open;     // the RTD input is open, found by a fault detection cycle
+  bool hung;     // a fault detection cycle never finishes
+  uint32_t transfers;
+
+  FakeChip() : present(true), open(false), hung(false), transfers(0) {
+    memset(registers, 0, sizeof(registers));
+  }
+
+  // a finished conversion, a fault sets the low bit of the RTD register and
+  // latches its status until cleared
+  void convert(uint16_t code, uint8_t fault = 0) {
+    uint16_t rtd = code << 1;
+    if (fault != 0) {
+      registers[MAX31865_REG_FAULT_STATUS] |= fault;
+      rtd |= 1;
+    }
+    registers[MAX31865_REG_RTD_MSB] = rtd >> 8;
+    registers[MAX31865_REG_RTD_MSB + 1] = rtd;
+  }
+
+  void transfer(uint8_t* data, uint8_t length) {
+    transfers++;
+    if (!present) {
+      memset(data, 0xFF, length);
+      return;
+    }
+    uint8_t address = data[0] & ~MAX31865_WRITE;
+    bool write = data[0] & MAX31865_WRITE;
+    for (uint8_t i = 1; i < length; i++) {
+      uint8_t reg = (address + i - 1) % MAX31865_REG_COUNT;
+      if (!write)
+        data[i] = registers[reg];
+      else if (reg == MAX31865_REG_CONFIG)
+        writeConfig(data[i]);
+      else if (reg >= MAX31865_REG_HIGH_FAULT_MSB && reg < MAX31865_REG_FAULT_STATUS)
+        registers[reg] = data[i];
+    }
+  }
+
+private:
+  // fault clear and one-shot clear themselves, the second manual stage
+  // checks the inputs and ends the cycle
+  void writeConfig(uint8_t value) {
+    if (value & MAX31865_CONFIG_FAULT_CLEAR) {
+      registers[MAX31865_REG_FAULT_STATUS] = 0;
+      registers[MAX31865_REG_RTD_MSB + 1] &= ~1;
+    }
+    value &= ~(MAX31865_CONFIG_FAULT_CLEAR | MAX31865_CONFIG_ONE_SHOT);
+    if ((value & MAX31865_FAULT_DETECT_MASK) == MAX31865_FAULT_DETECT_MANUAL_2 && !hung) {
+      if (open)
+        registers[MAX31865_REG_FAULT_STATUS] |= MAX31865_FAULT_RTDIN_FORCE | MAX31865_FAULT_VOLTAGE;
+      value &= ~MAX31865_FAULT_DETECT_MASK;
+    }
+    registers[MAX31865_REG_CONFIG] = value;
+  }
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_begin_configures_the_chip(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, 4);
+  rtd.setThreeWire(true);
+  rtd.setFilter50Hz(true);
+  rtd.setFaultThresholds(0x1000, 0x6000);
+
+  TEST_ASSERT_TRUE(rtd.begin());
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_CONFIG_VBIAS | MAX31865_CONFIG_AUTO | MAX31865_CONFIG_3WIRE | MAX31865_CONFIG_50HZ,
+                         chip.registers[MAX31865_REG_CONFIG]);
+  TEST_ASSERT_EQUAL_HEX16(0x1000, rtd.getLowThreshold());
+  TEST_ASSERT_EQUAL_HEX16(0x6000, rtd.getHighThreshold());
+}
+
+void test_absent_chip_fails_begin(void) {
+  FakeChip chip;
+  chip.present = false;
+  Max31865 rtd(&chip, 4);
+  TEST_ASSERT_FALSE(rtd.begin());
+}
+
+// samples come out in order with their DRDY time, a full queue drops the
+// newest and counts it
+void test_queue_and_overruns(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, 4);
+  TEST_ASSERT_TRUE(rtd.begin());
+
+  for (uint16_t i = 0; i < MAX31865_QUEUE_SIZE + 4; i++) {
+    chip.convert(0x2000 + i);
+    rtd.dataReady(i * 20000UL);
+    rtd.service();
+  }
+  TEST_ASSERT_EQUAL(MAX31865_QUEUE_SIZE, rtd.available());
+  TEST_ASSERT_EQUAL(4, rtd.getOverruns());
+
+  RtdSample sample;
+  for (uint16_t i = 0; i < MAX31865_QUEUE_SIZE; i++) {
+    TEST_ASSERT_TRUE(rtd.read(&sample));
+    TEST_ASSERT_EQUAL_HEX16(0x2000 + i, sample.code);
+    TEST_ASSERT_EQUAL(i * 20000UL, sample.time);
+    TEST_ASSERT_EQUAL(0, sample.fault);
+  }
+  TEST_ASSERT_FALSE(rtd.read(&sample));
+}
+
+// the sample carries the latched status, the reader clears it and leaves
+// auto conversion running
+void test_fault_is_reported_and_cleared(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, 4);
+  TEST_ASSERT_TRUE(rtd.begin());
+  uint8_t config = chip.registers[MAX31865_REG_CONFIG];
+
+  chip.convert(0x7FFF, MAX31865_FAULT_HIGH_THRESHOLD);
+  rtd.dataReady(100);
+  rtd.service();
+
+  RtdSample sample;
+  TEST_ASSERT_TRUE(rtd.read(&sample));
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_HIGH_THRESHOLD, sample.fault);
+  TEST_ASSERT_EQUAL_HEX8(0, chip.registers[MAX31865_REG_FAULT_STATUS]);
+  TEST_ASSERT_EQUAL_HEX8(config, chip.registers[MAX31865_REG_CONFIG]);
+
+  chip.convert(0x2000);
+  rtd.service();
+  TEST_ASSERT_TRUE(rtd.read(&sample));
+  TEST_ASSERT_EQUAL(0, sample.fault);
+}
+
+// without DRDY a poll is one transaction over all registers
+void test_burst_read(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, MAX31865_NO_DRDY);
+  rtd.setFaultThresholds(0x1000, 0x6000);
+  TEST_ASSERT_TRUE(rtd.begin());
+
+  chip.convert(0x2345, MAX31865_FAULT_LOW_THRESHOLD);
+  uint32_t before = chip.transfers;
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_LOW_THRESHOLD, rtd.readAll());
+  TEST_ASSERT_EQUAL(1, chip.transfers - before);
+  TEST_ASSERT_EQUAL_HEX16(0x2345, rtd.getCode());
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_LOW_THRESHOLD, rtd.getFault());
+  TEST_ASSERT_EQUAL_HEX16(0x1000, rtd.getLowThreshold());
+  TEST_ASSERT_EQUAL_HEX16(0x6000, rtd.getHighThreshold());
+}
+
+void test_end_turns_off_the_bias(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, MAX31865_NO_DRDY);
+  TEST_ASSERT_TRUE(rtd.begin());
+  rtd.end();
+  TEST_ASSERT_EQUAL_HEX8(0, chip.registers[MAX31865_REG_CONFIG] & (MAX31865_CONFIG_VBIAS | MAX31865_CONFIG_AUTO));
+}
+
+void test_resistance(void) {
+  TEST_ASSERT_EQUAL(215000, Max31865::resistance(0x4000, 430));
+  TEST_ASSERT_EQUAL(0, Max31865::resistance(0, 430));
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, Max31865::temperature(100.0f / 430 * 32768 + 0.5f, 100, 430));
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 100.0f, Max31865::temperature(138.51f / 430 * 32768 + 0.5f, 100, 430));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, -100.0f, Max31865::temperature(60.26f / 430 * 32768 + 0.5f, 100, 430));
+}
+
+// a cycle stops auto conversion, runs both stages and goes back to it
+void test_supervisor_runs_a_cycle(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, MAX31865_NO_DRDY);
+  TEST_ASSERT_TRUE(rtd.begin());
+  uint8_t config = chip.registers[MAX31865_REG_CONFIG];
+  RtdFaultSupervisor supervisor(&rtd);
+  supervisor.setInterval(10000);
+  supervisor.setSettleTime(60);
+
+  // the first update runs a cycle right away
+  supervisor.update(0);
+  TEST_ASSERT_FALSE(supervisor.isMeasuring());
+  TEST_ASSERT_EQUAL_HEX8(0, chip.registers[MAX31865_REG_CONFIG] & MAX31865_CONFIG_AUTO);
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_DETECT_MANUAL_1, chip.registers[MAX31865_REG_CONFIG] & MAX31865_FAULT_DETECT_MASK);
+
+  supervisor.update(59);
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_DETECT_MANUAL_1, chip.registers[MAX31865_REG_CONFIG] & MAX31865_FAULT_DETECT_MASK);
+  supervisor.update(60);
+  supervisor.update(61);
+  TEST_ASSERT_TRUE(supervisor.isMeasuring());
+  TEST_ASSERT_EQUAL(1, supervisor.getCycleCount());
+  TEST_ASSERT_EQUAL_HEX8(0, supervisor.getFaults());
+  TEST_ASSERT_EQUAL_HEX8(config, chip.registers[MAX31865_REG_CONFIG]);
+
+  // next one after the interval
+  supervisor.update(10000);
+  TEST_ASSERT_TRUE(supervisor.isMeasuring());
+  supervisor.update(10061);
+  TEST_ASSERT_FALSE(supervisor.isMeasuring());
+}
+
+// an open input is found by the cycle, reported and cleared afterwards
+void test_supervisor_finds_an_open_input(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, MAX31865_NO_DRDY);
+  TEST_ASSERT_TRUE(rtd.begin());
+  RtdFaultSupervisor supervisor(&rtd);
+  supervisor.setInterval(0);
+
+  chip.open = true;
+  uint32_t now = 0;
+  while (supervisor.getCycleCount() == 0)
+    supervisor.update(now++);
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_RTDIN_FORCE | MAX31865_FAULT_VOLTAGE, supervisor.getFaults());
+  TEST_ASSERT_EQUAL_HEX8(0, chip.registers[MAX31865_REG_FAULT_STATUS]);
+
+  // without an interval only a suspect reading starts the next cycle, no
+  // sooner than the retry time
+  chip.open = false;
+  supervisor.check(0x7FFF, 0);
+  supervisor.update(now);
+  TEST_ASSERT_TRUE(supervisor.isMeasuring());
+  now += RTD_FAULT_RETRY_MS;
+  while (supervisor.getCycleCount() == 1)
+    supervisor.update(now++);
+  TEST_ASSERT_EQUAL_HEX8(0, supervisor.getFaults());
+}
+
+// a cycle the chip never finishes is given up and reported as such, not
+// with the status of the unfinished cycle
+void test_supervisor_reports_a_timeout(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, MAX31865_NO_DRDY);
+  TEST_ASSERT_TRUE(rtd.begin());
+  uint8_t config = chip.registers[MAX31865_REG_CONFIG];
+  RtdFaultSupervisor supervisor(&rtd);
+  supervisor.setInterval(0);
+  supervisor.setSettleTime(60);
+
+  chip.hung = true;
+  supervisor.update(0);
+  supervisor.update(60);
+  supervisor.update(60 + RTD_FAULT_TIMEOUT_MS - 1);
+  TEST_ASSERT_FALSE(supervisor.isMeasuring());
+  supervisor.update(60 + RTD_FAULT_TIMEOUT_MS);
+  TEST_ASSERT_TRUE(supervisor.isMeasuring());
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_TIMEOUT, supervisor.getFaults());
+  TEST_ASSERT_EQUAL_HEX8(config, chip.registers[MAX31865_REG_CONFIG]);
+  TEST_ASSERT_TRUE(strlen(Max31865::faultText(MAX31865_FAULT_TIMEOUT)) > 0);
+}
+
+// a faulted sample serviced during a cycle doesn't put the chip back into
+// auto conversion
+void test_service_leaves_a_cycle_alone(void) {
+  FakeChip chip;
+  Max31865 rtd(&chip, 4);
+  TEST_ASSERT_TRUE(rtd.begin());
+
+  chip.convert(0x7FFF, MAX31865_FAULT_HIGH_THRESHOLD);
+  rtd.startFaultDetection(MAX31865_FAULT_DETECT_MANUAL_1);
+  rtd.service();
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_FAULT_DETECT_MANUAL_1, chip.registers[MAX31865_REG_CONFIG] & MAX31865_FAULT_DETECT_MASK);
+  TEST_ASSERT_EQUAL_HEX8(0, chip.registers[MAX31865_REG_CONFIG] & MAX31865_CONFIG_AUTO);
+
+  rtd.resume();
+  TEST_ASSERT_EQUAL_HEX8(MAX31865_CONFIG_AUTO, chip.registers[MAX31865_REG_CONFIG] & MAX31865_CONFIG_AUTO);
+  TEST_ASSERT_EQUAL_HEX8(0, chip.registers[MAX31865_REG_FAULT_STATUS]);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_configures_the_chip);
+  RUN_TEST(test_absent_chip_fails_begin);
+  RUN_TEST(test_queue_and_overruns);
+  RUN_TEST(test_fault_is_reported_and_cleared);
+  RUN_TEST(test_burst_read);
+  RUN_TEST(test_end_turns_off_the_bias);
+  RUN_TEST(test_resistance);
+  RUN_TEST(test_supervisor_runs_a_cycle);
+  RUN_TEST(test_supervisor_finds_an_open_input);
+  RUN_TEST(test_supervisor_reports_a_timeout);
+  RUN_TEST(test_service_leaves_a_cycle_alone);
+  return UNITY_END();
+}
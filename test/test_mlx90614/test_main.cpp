@@ -0,0 +1,211 @@
+// Mlx90614 against a fake SMBus slave: packet error codes, the error flag,
+// a missing sensor, the queue and the integer conversions.
+
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include <thread>
+#include <atomic>
+#include "Mlx90614.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// CRC-8 with polynomial 0x07 one bit at a time, as the datasheet gives it
+static uint8_t pecBitwise(const uint8_t* data, uint8_t length) {
+  uint8_t crc = 0;
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+// an MLX90614 answering read word on its RAM, with faults to switch on
+struct FakeSlave : Mlx90614Bus {
+  uint8_t address;
+  uint16_t ram[32];
+  bool nack;
+  bool corrupt;
+  int transfers;
+
+  FakeSlave() : address(MLX90614_DEFAULT_ADDRESS), nack(false), corrupt(false), transfers(0) {
+    for (uint8_t i = 0; i < 32; i++)
+      ram[i] = 0;
+  }
+
+  bool read(uint8_t slave, uint8_t command, uint8_t* data, uint8_t length) {
+    transfers++;
+    if (nack || slave != address || length != 3)
+      return false;
+    uint16_t value = ram[command & 31];
+    uint8_t packet[5] = { (uint8_t) (slave << 1), command, (uint8_t) ((slave << 1) | 1),
+                          (uint8_t) value, (uint8_t) (value >> 8) };
+    data[0] = packet[3];
+    data[1] = packet[4];
+    data[2] = pecBitwise(packet, 5);
+    if (corrupt)
+      data[1] ^= 0x10;
+    return true;
+  }
+};
+
+// the example of the SMBus application note, then random packets
+void test_pec(void) {
+  const uint8_t example[] = { 0xB4, 0x07, 0xB5, 0xD2, 0x3A };
+  TEST_ASSERT_EQUAL_HEX8(0x30, Mlx90614::pec(example, 5));
+
+  srand(25);
+  for (int i = 0; i < 100000; i++) {
+    uint8_t data[5];
+    for (uint8_t k = 0; k < 5; k++)
+      data[k] = rand();
+    TEST_ASSERT_EQUAL_HEX8(pecBitwise(data, 5), Mlx90614::pec(data, 5));
+  }
+}
+
+// every raw value against the float conversion, Temp128 saturates outside
+// -256..256 C
+void test_conversions(void) {
+  for (uint32_t raw = 0; raw < 0x8000; raw++) {
+    double celsius = raw * 0.02 - 273.15;
+    TEST_ASSERT_EQUAL(lround(celsius * 100), Mlx90614::toCentiCelsius(raw));
+    double expected = fmin(fmax(celsius * 128, INT16_MIN), INT16_MAX);
+    TEST_ASSERT_FLOAT_WITHIN(0.5 + 1e-6, expected, Mlx90614::toTemp128(raw));
+  }
+  TEST_ASSERT_EQUAL(1, Mlx90614::toCentiCelsius(13658));
+  TEST_ASSERT_EQUAL(INT16_MIN, Mlx90614::toTemp128(0));
+}
+
+void test_begin_needs_a_valid_pair(void) {
+  FakeSlave absent;
+  absent.nack = true;
+  Mlx90614 a(&absent);
+  TEST_ASSERT_FALSE(a.begin());
+
+  FakeSlave flagged;
+  flagged.ram[MLX90614_OBJECT_TEMP] = MLX90614_ERROR_FLAG;
+  flagged.ram[MLX90614_AMBIENT_TEMP] = 15000;
+  Mlx90614 b(&flagged);
+  TEST_ASSERT_FALSE(b.begin());
+
+  FakeSlave other;
+  other.address = 0x5B;
+  Mlx90614 c(&other);
+  TEST_ASSERT_FALSE(c.begin());
+  Mlx90614 d(&other, 0x5B);
+  other.ram[MLX90614_OBJECT_TEMP] = 15000;
+  other.ram[MLX90614_AMBIENT_TEMP] = 15000;
+  TEST_ASSERT_TRUE(d.begin());
+  TEST_ASSERT_EQUAL(0, d.available());
+}
+
+static int calls;
+static void onSample(const IrSample& sample, void* arg) {
+  calls++;
+  *(uint16_t*) arg = sample.object;
+}
+
+// one pair per service(), a bad transfer is counted and dropped whole
+void test_service(void) {
+  FakeSlave slave;
+  slave.ram[MLX90614_OBJECT_TEMP] = 0x3AD2;
+  slave.ram[MLX90614_AMBIENT_TEMP] = 0x3A00;
+  uint16_t last = 0;
+  calls = 0;
+
+  Mlx90614 ir(&slave);
+  ir.setCallback(onSample, &last);
+  TEST_ASSERT_TRUE(ir.begin());
+
+  int before = slave.transfers;
+  TEST_ASSERT_TRUE(ir.service(100));
+  TEST_ASSERT_EQUAL(2, slave.transfers - before);
+  IrSample sample;
+  TEST_ASSERT_TRUE(ir.read(&sample));
+  TEST_ASSERT_EQUAL_HEX16(0x3AD2, sample.object);
+  TEST_ASSERT_EQUAL_HEX16(0x3A00, sample.ambient);
+  TEST_ASSERT_EQUAL(100, sample.time);
+  TEST_ASSERT_EQUAL(1, calls);
+  TEST_ASSERT_EQUAL_HEX16(0x3AD2, last);
+
+  slave.corrupt = true;
+  TEST_ASSERT_FALSE(ir.service(200));
+  TEST_ASSERT_EQUAL(1, ir.getErrors());
+  slave.corrupt = false;
+  slave.nack = true;
+  TEST_ASSERT_FALSE(ir.service(300));
+  TEST_ASSERT_EQUAL(2, ir.getErrors());
+  slave.nack = false;
+  slave.ram[MLX90614_AMBIENT_TEMP] = 0x8123;
+  TEST_ASSERT_FALSE(ir.service(400));
+  TEST_ASSERT_EQUAL(3, ir.getErrors());
+  TEST_ASSERT_EQUAL(0, ir.available());
+  TEST_ASSERT_EQUAL(1, calls);
+}
+
+// a full queue drops the newest pairs and counts them
+void test_overrun(void) {
+  FakeSlave slave;
+  slave.ram[MLX90614_OBJECT_TEMP] = 15000;
+  slave.ram[MLX90614_AMBIENT_TEMP] = 15000;
+  Mlx90614 ir(&slave);
+  TEST_ASSERT_TRUE(ir.begin());
+
+  for (uint32_t i = 0; i < MLX90614_QUEUE_SIZE + 2; i++)
+    ir.service(i);
+  TEST_ASSERT_EQUAL(MLX90614_QUEUE_SIZE, ir.available());
+  TEST_ASSERT_EQUAL(2, ir.getOverruns());
+
+  IrSample sample;
+  TEST_ASSERT_TRUE(ir.read(&sample));
+  TEST_ASSERT_EQUAL(0, sample.time);
+}
+
+// the reader on its own thread, as the task runs it: every pair arrives
+// once and in order, or is counted as an overrun
+void test_reader_thread(void) {
+  FakeSlave slave;
+  slave.ram[MLX90614_OBJECT_TEMP] = 15000;
+  slave.ram[MLX90614_AMBIENT_TEMP] = 15000;
+  Mlx90614 ir(&slave);
+  TEST_ASSERT_TRUE(ir.begin());
+
+  const uint32_t count = 200000;
+  std::atomic<bool> done(false);
+  std::thread reader([&] {
+    for (uint32_t i = 1; i <= count; i++)
+      ir.service(i);
+    done = true;
+  });
+
+  uint32_t received = 0;
+  uint32_t previous = 0;
+  bool ordered = true;
+  IrSample sample;
+  for (;;) {
+    if (ir.read(&sample)) {
+      ordered = ordered && sample.time > previous;
+      previous = sample.time;
+      received++;
+    } else if (done && ir.available() == 0) {
+      break;
+    }
+  }
+  reader.join();
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL(count, received + ir.getOverruns());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_pec);
+  RUN_TEST(test_conversions);
+  RUN_TEST(test_begin_needs_a_valid_pair);
+  RUN_TEST(test_service);
+  RUN_TEST(test_overrun);
+  RUN_TEST(test_reader_thread);
+  return UNITY_END();
+}
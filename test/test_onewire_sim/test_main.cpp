@@ -0,0 +1,203 @@
+// Regression suite of the simulated 1-Wire bus: the DS18xxx models behave
+// like the datasheet says, so the library tests built on them mean something.
+
+#include <unity.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// every device on the bus found once, with a valid ROM CRC
+void test_search_finds_every_device(void) {
+  OneWire wire(1);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  wire.addDevice(ONEWIRE_SIM_DS18S20, 2);
+  wire.addDevice(ONEWIRE_SIM_DS1822, 3);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 0x123456);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 0xFEDCBA);
+
+  bool found[5] = { false };
+  uint8_t address[8];
+  uint8_t count = 0;
+  wire.reset_search();
+  while (wire.search(address)) {
+    TEST_ASSERT_EQUAL_HEX8(address[7], OneWire::crc8(address, 7));
+    bool known = false;
+    for (uint8_t i = 0; i < wire.getDeviceCount(); i++) {
+      if (memcmp(address, wire.getDevice(i)->getAddress(), 8) == 0) {
+        TEST_ASSERT_FALSE(found[i]);
+        found[i] = true;
+        known = true;
+      }
+    }
+    TEST_ASSERT_TRUE(known);
+    count++;
+  }
+  TEST_ASSERT_EQUAL(5, count);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_EQUAL(5, sensors.getDeviceCount());
+  TEST_ASSERT_EQUAL(5, sensors.getDS18Count());
+}
+
+// an absent device neither answers the search nor a read
+void test_absent_device_is_not_found(void) {
+  OneWire wire(1);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  OneWireSimDevice* gone = wire.addDevice(ONEWIRE_SIM_DS18B20, 2);
+  gone->setPresent(false);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_EQUAL(1, sensors.getDeviceCount());
+  TEST_ASSERT_FALSE(sensors.isConnected(gone->getAddress()));
+}
+
+// the alarm search returns exactly the devices outside their TL..TH window
+void test_alarm_search_finds_alarming_devices(void) {
+  OneWire wire(1);
+  OneWireSimDevice* devices[4];
+  for (uint8_t i = 0; i < 4; i++)
+    devices[i] = wire.addDevice(ONEWIRE_SIM_DS18B20, 10 + i);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  for (uint8_t i = 0; i < 4; i++) {
+    sensors.setHighAlarmTemp(devices[i]->getAddress(), 30);
+    sensors.setLowAlarmTemp(devices[i]->getAddress(), 10);
+  }
+  devices[0]->setTemperature(20 * 128);
+  devices[1]->setTemperature(35 * 128);
+  devices[2]->setTemperature(5 * 128);
+  devices[3]->setTemperature(30 * 128);
+  sensors.requestTemperatures();
+  // the devices latch the flag when the bus next moves
+  wire.reset();
+
+  TEST_ASSERT_FALSE(devices[0]->hasAlarm());
+  TEST_ASSERT_TRUE(devices[1]->hasAlarm());
+  TEST_ASSERT_TRUE(devices[2]->hasAlarm());
+  // the whole degree compares inclusive against TH
+  TEST_ASSERT_TRUE(devices[3]->hasAlarm());
+
+  uint8_t address[8];
+  uint8_t count = 0;
+  sensors.resetAlarmSearch();
+  while (sensors.alarmSearch(address)) {
+    TEST_ASSERT_FALSE(memcmp(address, devices[0]->getAddress(), 8) == 0);
+    count++;
+  }
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_TRUE(sensors.hasAlarm());
+}
+
+// an injected error fails the scratchpad CRC once, the next read is good
+void test_scratchpad_crc_error_is_detected(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  device->setTemperature(2345);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  sensors.requestTemperatures();
+
+  const uint8_t* scratchPad = device->getScratchPad();
+  TEST_ASSERT_EQUAL_HEX8(scratchPad[8], OneWire::crc8(scratchPad, 8));
+
+  device->injectCrcErrors(1);
+  TEST_ASSERT_EQUAL(DEVICE_DISCONNECTED_RAW, sensors.getTemp(device->getAddress()));
+  // 12 bits keep 1/16 degree C
+  TEST_ASSERT_EQUAL(2345 & ~7, sensors.getTemp(device->getAddress()));
+}
+
+// a parasite powered device says so and still converts with the pullup
+void test_parasite_power(void) {
+  OneWire wire(1);
+  OneWireSimDevice* powered = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  OneWireSimDevice* parasite = wire.addDevice(ONEWIRE_SIM_DS18B20, 2);
+  parasite->setParasite(true);
+  powered->setTemperature(21 * 128);
+  parasite->setTemperature(-10 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.isParasitePowerMode());
+  TEST_ASSERT_TRUE(sensors.readPowerSupply(parasite->getAddress()));
+  TEST_ASSERT_FALSE(sensors.readPowerSupply(powered->getAddress()));
+  TEST_ASSERT_TRUE(sensors.readPowerSupply());
+
+  sensors.requestTemperatures();
+  TEST_ASSERT_EQUAL(21 * 128, sensors.getTemp(powered->getAddress()));
+  TEST_ASSERT_EQUAL(-10 * 128, sensors.getTemp(parasite->getAddress()));
+}
+
+// the configuration register sets the resolution and the conversion time
+void test_resolution_sets_conversion_time(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  OneWireSimDevice* other = wire.addDevice(ONEWIRE_SIM_DS18B20, 2);
+  device->setTemperature(1000);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_EQUAL(12, device->getResolution());
+
+  TEST_ASSERT_TRUE(sensors.setResolution(device->getAddress(), 9, false, false));
+  TEST_ASSERT_EQUAL(9, device->getResolution());
+  TEST_ASSERT_EQUAL(12, other->getResolution());
+  TEST_ASSERT_EQUAL(9, sensors.getResolution(device->getAddress()));
+
+  // polled completion follows the device, 93.75 ms at 9 bits
+  unsigned long start = millis();
+  TEST_ASSERT_TRUE(sensors.requestTemperaturesByAddress(device->getAddress()));
+  unsigned long elapsed = millis() - start;
+  TEST_ASSERT_GREATER_OR_EQUAL(93, elapsed);
+  TEST_ASSERT_LESS_THAN(120, elapsed);
+  // 9 bits keep 1/2 degree C
+  TEST_ASSERT_EQUAL(1000 & ~63, sensors.getTemp(device->getAddress()));
+
+  start = millis();
+  TEST_ASSERT_TRUE(sensors.requestTemperaturesByAddress(other->getAddress()));
+  elapsed = millis() - start;
+  TEST_ASSERT_GREATER_OR_EQUAL(750, elapsed);
+  TEST_ASSERT_LESS_THAN(800, elapsed);
+
+  sensors.setResolution(10, false);
+  TEST_ASSERT_EQUAL(10, device->getResolution());
+  TEST_ASSERT_EQUAL(10, other->getResolution());
+  TEST_ASSERT_EQUAL(10, sensors.getResolution());
+  TEST_ASSERT_EQUAL(0, device->getEepromWrites());
+}
+
+// every reset and slot is counted and costs its standard time
+void test_bus_cost_is_counted(void) {
+  OneWire wire(1);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  wire.resetStats();
+
+  wire.reset();
+  wire.skip();
+  wire.write(0xBE);
+  wire.read();
+
+  const OneWireSimStats& stats = wire.getStats();
+  TEST_ASSERT_EQUAL(1, stats.resets);
+  TEST_ASSERT_EQUAL(16, stats.writeSlots);
+  TEST_ASSERT_EQUAL(8, stats.readSlots);
+  TEST_ASSERT_EQUAL(ONEWIRE_SIM_RESET_US + 24 * ONEWIRE_SIM_SLOT_US, stats.micros);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_search_finds_every_device);
+  RUN_TEST(test_absent_device_is_not_found);
+  RUN_TEST(test_alarm_search_finds_alarming_devices);
+  RUN_TEST(test_scratchpad_crc_error_is_detected);
+  RUN_TEST(test_parasite_power);
+  RUN_TEST(test_resolution_sets_conversion_time);
+  RUN_TEST(test_bus_cost_is_counted);
+  return UNITY_END();
+}
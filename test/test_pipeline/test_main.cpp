@@ -0,0 +1,198 @@
+// Pipelined conversions on the simulated bus.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// polls the pipeline every ms until a sample arrives, returns its time
+static unsigned long nextSample(DallasTemperature& sensors, uint8_t* index, int16_t* raw) {
+  for (int i = 0; i < 5000; i++) {
+    if (sensors.pollPipeline(index, raw))
+      return millis();
+    simAdvanceMicros(1000);
+  }
+  TEST_FAIL_MESSAGE("no sample within 5 s");
+  return 0;
+}
+
+// a resolution lowered during a conversion doesn't have the device read
+// before that conversion is done, which would return the previous sample
+void test_resolution_change_waits_for_the_conversion(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  device->setTemperature(20 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.startPipeline());
+
+  uint8_t index;
+  int16_t raw;
+  nextSample(sensors, &index, &raw);
+  TEST_ASSERT_EQUAL(20 * 128, raw);
+
+  // the next 12 bit conversion runs, the value moves and the resolution drops
+  unsigned long start = millis();
+  device->setTemperature(30 * 128);
+  TEST_ASSERT_TRUE(sensors.setResolution(device->getAddress(), 9, true, false));
+  TEST_ASSERT_EQUAL(12, device->getResolution());
+
+  unsigned long time = nextSample(sensors, &index, &raw);
+  TEST_ASSERT_GREATER_OR_EQUAL(750, time - start);
+  TEST_ASSERT_EQUAL(30 * 128, raw);
+
+  // written once that sample was read, the next one comes at 9 bits
+  TEST_ASSERT_EQUAL(9, device->getResolution());
+  TEST_ASSERT_EQUAL(9, sensors.getResolution(device->getAddress()));
+  start = millis();
+  device->setTemperature(25 * 128 + 77);
+  time = nextSample(sensors, &index, &raw);
+  TEST_ASSERT_LESS_THAN(120, time - start);
+  TEST_ASSERT_EQUAL((25 * 128 + 77) & ~63, raw);
+  TEST_ASSERT_EQUAL(0, device->getEepromWrites());
+}
+
+// the global setter goes device by device while the pipeline runs
+void test_global_resolution_during_the_pipeline(void) {
+  OneWire wire(1);
+  OneWireSimDevice* devices[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    devices[i] = wire.addDevice(ONEWIRE_SIM_DS18B20, i + 1);
+    devices[i]->setTemperature(i * 128);
+  }
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.startPipeline());
+
+  uint8_t index;
+  int16_t raw;
+  nextSample(sensors, &index, &raw);
+  sensors.setResolution(10, false);
+
+  // every device reads its own value throughout, at the new resolution in
+  // the end
+  bool seen[3] = { false, false, false };
+  for (int n = 0; n < 12; n++) {
+    nextSample(sensors, &index, &raw);
+    DeviceAddress address;
+    TEST_ASSERT_TRUE(sensors.getAddress(address, index));
+    uint8_t i = 0;
+    while (i < 3 && memcmp(address, devices[i]->getAddress(), 8) != 0)
+      i++;
+    TEST_ASSERT_LESS_THAN(3, i);
+    TEST_ASSERT_EQUAL(i * 128, raw);
+    seen[i] = true;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(seen[i]);
+    TEST_ASSERT_EQUAL(10, devices[i]->getResolution());
+  }
+}
+
+// a change still waiting when the pipeline stops is written then
+void test_stop_writes_a_pending_resolution(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.startPipeline());
+
+  uint8_t index;
+  int16_t raw;
+  sensors.pollPipeline(&index, &raw);
+  sensors.setResolution(device->getAddress(), 11, true, false);
+  TEST_ASSERT_EQUAL(12, device->getResolution());
+  sensors.stopPipeline();
+  TEST_ASSERT_EQUAL(11, device->getResolution());
+}
+
+// samples in the given ms of broadcast, wait for the slowest device, read all
+static unsigned long broadcastThroughput(OneWire& wire, unsigned long ms) {
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  unsigned long samples = 0;
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    int16_t raw[8];
+    sensors.requestTemperatures();
+    samples += sensors.readAllTemperatures(raw, nullptr, 8);
+  }
+  return samples;
+}
+
+// samples in the given ms of the pipeline, polled every ms when idle
+static unsigned long pipelineThroughput(OneWire& wire, unsigned long ms) {
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TEST_ASSERT_TRUE(sensors.startPipeline());
+  unsigned long samples = 0;
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    uint8_t index;
+    int16_t raw;
+    if (sensors.pollPipeline(&index, &raw)) {
+      TEST_ASSERT_NOT_EQUAL(DEVICE_DISCONNECTED_RAW, raw);
+      samples++;
+    } else {
+      simAdvanceMicros(1000);
+    }
+  }
+  sensors.stopPipeline();
+  return samples;
+}
+
+static void reportThroughput(const char* bus, unsigned long broadcast, unsigned long pipeline) {
+  char text[128];
+  snprintf(text, sizeof(text), "%s: broadcast %.1f samples/s, pipeline %.1f samples/s",
+           bus, broadcast / 10.0, pipeline / 10.0);
+  TEST_MESSAGE(text);
+}
+
+// 8 probes at 12 bits: both wait for the same conversions, the pipeline
+// reads each device while the others still convert
+void test_throughput_at_one_resolution(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 8; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, i + 1)->setTemperature(30 * 128);
+
+  unsigned long broadcast = broadcastThroughput(wire, 10000);
+  unsigned long pipeline = pipelineThroughput(wire, 10000);
+  reportThroughput("8 at 12 bits", broadcast, pipeline);
+  TEST_ASSERT_GREATER_OR_EQUAL(broadcast, pipeline);
+}
+
+// 2 probes at 12 bits and 6 at 9 bits: the broadcast waits 750 ms for all,
+// in the pipeline the fast ones come round eight times as often
+void test_throughput_at_mixed_resolutions(void) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 8; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, i + 1)->setTemperature(30 * 128);
+
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> setup(&wire);
+  setup.begin();
+  for (uint8_t i = 2; i < 8; i++)
+    setup.setResolution(wire.getDevice(i)->getAddress(), 9, true, false);
+
+  unsigned long broadcast = broadcastThroughput(wire, 10000);
+  unsigned long pipeline = pipelineThroughput(wire, 10000);
+  reportThroughput("2 at 12 bits, 6 at 9 bits", broadcast, pipeline);
+  TEST_ASSERT_GREATER_THAN(broadcast * 4, pipeline);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_resolution_change_waits_for_the_conversion);
+  RUN_TEST(test_global_resolution_during_the_pipeline);
+  RUN_TEST(test_stop_writes_a_pending_resolution);
+  RUN_TEST(test_throughput_at_one_resolution);
+  RUN_TEST(test_throughput_at_mixed_resolutions);
+  return UNITY_END();
+}
@@ -0,0 +1,174 @@
+// ResolutionManager on the simulated bus: which resolution a probe gets
+// when, and what the pipeline gains from it in response time.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+#include "TempAcquisition.h"
+#include "ResolutionManager.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_target(void) {
+  TEST_ASSERT_EQUAL(9, ResolutionManager::target(true, false));
+  TEST_ASSERT_EQUAL(9, ResolutionManager::target(true, true));
+  TEST_ASSERT_EQUAL(10, ResolutionManager::target(false, true));
+  TEST_ASSERT_EQUAL(12, ResolutionManager::target(false, false));
+}
+
+// a fast change drops the probe to 9 bits at once, it only goes back to
+// 12 after RESOLUTION_SETTLE_MS of quiet, and the EEPROM is never written
+void test_drop_and_settle(void) {
+  OneWire wire(1);
+  OneWireSimDevice* device = wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  ResolutionManager manager(&sensors);
+  manager.begin();
+  TEST_ASSERT_EQUAL(12, manager.getResolution(0));
+
+  TEST_ASSERT_FALSE(manager.update(0, 30 * 128, 0));
+  TEST_ASSERT_FALSE(manager.update(0, 30 * 128 + 64, 1000));
+  TEST_ASSERT_TRUE(manager.update(0, 31 * 128, 1500));
+  TEST_ASSERT_EQUAL(9, manager.getResolution(0));
+  TEST_ASSERT_EQUAL(9, device->getResolution());
+
+  // quiet from here on
+  unsigned long t = 1500;
+  while (t < 1500 + RESOLUTION_SETTLE_MS - 100) {
+    t += 100;
+    TEST_ASSERT_FALSE(manager.update(0, 31 * 128, t));
+  }
+  TEST_ASSERT_EQUAL(9, device->getResolution());
+  TEST_ASSERT_TRUE(manager.update(0, 31 * 128, 1500 + RESOLUTION_SETTLE_MS));
+  TEST_ASSERT_EQUAL(12, device->getResolution());
+  TEST_ASSERT_EQUAL(0, device->getEepromWrites());
+}
+
+// near a breakpoint 10 bits, a DS18S20 is never touched
+void test_breakpoint_and_fixed_resolution(void) {
+  OneWire wire(1);
+  wire.addDevice(ONEWIRE_SIM_DS18B20, 1);
+  wire.addDevice(ONEWIRE_SIM_DS18S20, 2);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  ResolutionManager manager(&sensors);
+  int16_t breakpoints[] = { 50 * 128 };
+  manager.setBreakpoints(breakpoints, 1);
+  manager.begin();
+
+  uint8_t b18 = 0;
+  DeviceAddress address;
+  sensors.getAddress(address, 0);
+  if (address[0] != DS18B20MODEL)
+    b18 = 1;
+
+  manager.update(b18, 48 * 128 + 64, 0);
+  TEST_ASSERT_FALSE(manager.update(b18, 48 * 128 + 96, 1000));
+  TEST_ASSERT_TRUE(manager.update(b18, 49 * 128 + 8, 2500));
+  TEST_ASSERT_EQUAL(10, manager.getResolution(b18));
+
+  manager.update(1 - b18, 20 * 128, 0);
+  TEST_ASSERT_FALSE(manager.update(1 - b18, 40 * 128, 1000));
+  TEST_ASSERT_EQUAL(12, manager.getResolution(1 - b18));
+}
+
+// 40 C, a ramp of 2 C/s from 10 to 20 s, 60 C to 40 s, then a step to 45 C
+static int16_t profile(unsigned long ms) {
+  double c;
+  if (ms < 10000)
+    c = 40;
+  else if (ms < 20000)
+    c = 40 + (ms - 10000) * 0.002;
+  else if (ms < 40000)
+    c = 60;
+  else
+    c = 45;
+  return (int16_t) (c * 128);
+}
+
+struct Response {
+  double rampError;       // mean distance of probe 0 to the truth on the ramp, C
+  unsigned long stepSeen; // ms until probe 0 is within half a degree of the step
+  uint32_t eepromWrites;
+};
+
+// four pipelined probes following the profile, with or without the manager
+static Response follow(bool adaptive) {
+  OneWire wire(1);
+  for (uint8_t i = 0; i < 4; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, 0x3000 + i * 7654321);
+  DallasTemperatureStatic<DALLAS_MAX_DEVICES> sensors(&wire);
+  sensors.begin();
+  TempAcquisition acquisition(&sensors);
+  acquisition.setMode(TempAcquisition::MODE_PIPELINED);
+  acquisition.begin();
+  ResolutionManager manager(&sensors);
+  int16_t breakpoints[] = { 35 * 128, 50 * 128, 60 * 128, 70 * 128 };
+  manager.setBreakpoints(breakpoints, 4);
+  manager.begin();
+
+  Response response = { 0, 0, 0 };
+  unsigned long errors = 0;
+  unsigned long start = millis();
+  unsigned long last = 0;
+  for (;;) {
+    unsigned long t = millis() - start;
+    if (t > 50000)
+      break;
+    for (uint8_t i = 0; i < 4; i++)
+      wire.getDevice(i)->setTemperature(profile(t));
+    acquisition.update(millis());
+    for (uint8_t i = 0; i < acquisition.getSensorCount(); i++)
+      if (adaptive && acquisition.isFresh(i))
+        manager.update(i, acquisition.getTemp(i), millis());
+
+    // once a simulated ms
+    if (t != last) {
+      last = t;
+      if (t >= 10000 && t < 22000) {
+        response.rampError += abs(acquisition.getTemp(0) - profile(t)) / 128.0;
+        errors++;
+      }
+      if (t >= 40000 && response.stepSeen == 0 && abs(acquisition.getTemp(0) - 45 * 128) <= 64)
+        response.stepSeen = t - 40000;
+    }
+    delayMicroseconds(200);
+  }
+  response.rampError /= errors;
+  response.eepromWrites = wire.getStats().eepromWrites;
+  return response;
+}
+
+// the adaptive probes track the ramp closer and see the step sooner, without
+// a single EEPROM write
+void test_response_time(void) {
+  Response fixed = follow(false);
+  Response adaptive = follow(true);
+
+  char text[128];
+  snprintf(text, sizeof(text), "fixed 12 bits: ramp error %.2f C, step seen after %lu ms",
+           fixed.rampError, fixed.stepSeen);
+  TEST_MESSAGE(text);
+  snprintf(text, sizeof(text), "adaptive: ramp error %.2f C, step seen after %lu ms",
+           adaptive.rampError, adaptive.stepSeen);
+  TEST_MESSAGE(text);
+
+  TEST_ASSERT_TRUE(adaptive.rampError < fixed.rampError);
+  TEST_ASSERT_GREATER_THAN(0, adaptive.stepSeen);
+  TEST_ASSERT_LESS_THAN(fixed.stepSeen, adaptive.stepSeen);
+  TEST_ASSERT_EQUAL(0, adaptive.eepromWrites);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_target);
+  RUN_TEST(test_drop_and_settle);
+  RUN_TEST(test_breakpoint_and_fixed_resolution);
+  RUN_TEST(test_response_time);
+  return UNITY_END();
+}
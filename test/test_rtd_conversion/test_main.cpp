@@ -0,0 +1,119 @@
+// RtdConversion tables against the Callendar-Van Dusen equation they are
+// compiled from, over every code in -200..850 C, and against the float
+// conversion of the driver.
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "RtdConversion.h"
+#include "Max31865.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// exact inverse of the full equation, C term included, by Newton iteration
+template <class Conversion>
+static double exactTemperature(double ohms) {
+  double t = (ohms / Conversion::resistanceAt(0) - 1) / RTD_CVD_A;
+  for (int i = 0; i < 40; i++) {
+    double h = 1e-4;
+    double slope = (Conversion::resistanceAt(t + h) - Conversion::resistanceAt(t - h)) / (2 * h);
+    t -= (Conversion::resistanceAt(t) - ohms) / slope;
+  }
+  return t;
+}
+
+// worst error of the table over every code of the range, below 0.01 C
+template <class Conversion>
+static void checkConversion(const char* name, double nominal, double reference) {
+  double worst = 0;
+  double worstFloat = 0;
+  unsigned codes = 0;
+
+  for (unsigned code = 1; code < 32768; code++) {
+    double t = exactTemperature<Conversion>(code * reference / 32768.0);
+    if (t < -200 || t > 850)
+      continue;
+    codes++;
+    double error = fabs(Conversion::toMilliCelsius(code) / 1000.0 - t);
+    if (error > worst)
+      worst = error;
+    error = fabs(Max31865::temperature(code, nominal, reference) - t);
+    if (error > worstFloat)
+      worstFloat = error;
+  }
+
+  char text[128];
+  snprintf(text, sizeof(text), "%s: %u codes, table worst %.4f C, float formula worst %.4f C",
+           name, codes, worst, worstFloat);
+  TEST_MESSAGE(text);
+  TEST_ASSERT_GREATER_THAN(1000, codes);
+  TEST_ASSERT_TRUE(worst < 0.01);
+}
+
+void test_pt100_430(void) {
+  checkConversion<Pt100Rref430>("PT100/430", 100, 430);
+}
+
+void test_pt1000_3900(void) {
+  checkConversion<Pt1000Rref3900>("PT1000/3900", 1000, 3900);
+}
+
+void test_pt1000_4300(void) {
+  checkConversion<Pt1000Rref4300>("PT1000/4300", 1000, 4300);
+}
+
+// table entries rise with the temperature and sit where the equation puts
+// them, the ends clamp
+void test_table_and_clamping(void) {
+  const uint32_t* table = Pt100Rref430::table();
+  for (unsigned i = 1; i < RTD_TABLE_STEPS; i++)
+    TEST_ASSERT_TRUE(table[i] > table[i - 1]);
+  // 100 ohms at 0 C
+  TEST_ASSERT_EQUAL((uint32_t) (100.0 / 430 * 2147483648.0 + 0.5), table[200 / RTD_TABLE_STEP_C]);
+
+  TEST_ASSERT_EQUAL(-200000, Pt100Rref430::toMilliCelsius(0));
+  TEST_ASSERT_EQUAL(850000, Pt100Rref430::toMilliCelsius(32767));
+  TEST_ASSERT_EQUAL(0, Pt100Rref430::toMilliCelsius((uint16_t) (100.0 / 430 * 32768 + 0.5)) / 100);
+}
+
+static volatile int64_t sink;
+static volatile float floatSink;
+
+// reported only, the host has an FPU the ESP32 lacks for doubles
+void test_conversion_benchmark(void) {
+  const int rounds = 100;
+  int64_t sum = 0;
+  float floatSum = 0;
+
+  clock_t start = clock();
+  for (int r = 0; r < rounds; r++)
+    for (unsigned code = 4000; code < 30000; code++)
+      sum += Pt100Rref430::toMilliCelsius(code);
+  clock_t table = clock() - start;
+  sink = sum;
+
+  start = clock();
+  for (int r = 0; r < rounds; r++)
+    for (unsigned code = 4000; code < 30000; code++)
+      floatSum += Max31865::temperature(code, 100, 430);
+  clock_t formula = clock() - start;
+  floatSink = floatSum;
+
+  double count = rounds * 26000.0;
+  char text[96];
+  snprintf(text, sizeof(text), "table %.1f ns, float formula %.1f ns per conversion",
+           table * 1e9 / CLOCKS_PER_SEC / count, formula * 1e9 / CLOCKS_PER_SEC / count);
+  TEST_MESSAGE(text);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_pt100_430);
+  RUN_TEST(test_pt1000_3900);
+  RUN_TEST(test_pt1000_4300);
+  RUN_TEST(test_table_and_clamping);
+  RUN_TEST(test_conversion_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+// SpscRing: order, full and empty, index wrap and one producer thread
+// against one consumer.
+
+#include <unity.h>
+#include <thread>
+#include <atomic>
+#include "SpscRing.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fifo_order_and_full(void) {
+  SpscRing<uint16_t, 4> ring;
+  uint16_t item;
+
+  TEST_ASSERT_FALSE(ring.pop(&item));
+  for (uint16_t i = 0; i < 4; i++)
+    TEST_ASSERT_TRUE(ring.push(i));
+  TEST_ASSERT_FALSE(ring.push(4));
+  TEST_ASSERT_EQUAL(4, ring.available());
+
+  for (uint16_t i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(ring.pop(&item));
+    TEST_ASSERT_EQUAL(i, item);
+  }
+  TEST_ASSERT_FALSE(ring.pop(&item));
+  TEST_ASSERT_EQUAL(0, ring.available());
+}
+
+// the free running indexes wrap at 256 many times over
+void test_index_wrap(void) {
+  SpscRing<uint32_t, 8> ring;
+  uint32_t next = 0;
+  uint32_t expected = 0;
+  uint32_t item;
+
+  for (int round = 0; round < 1000; round++) {
+    uint8_t n = round % 8 + 1;
+    for (uint8_t i = 0; i < n; i++)
+      TEST_ASSERT_TRUE(ring.push(next++));
+    TEST_ASSERT_EQUAL(n, ring.available());
+    for (uint8_t i = 0; i < n; i++) {
+      TEST_ASSERT_TRUE(ring.pop(&item));
+      TEST_ASSERT_EQUAL(expected++, item);
+    }
+  }
+}
+
+void test_clear(void) {
+  SpscRing<uint8_t, 2> ring;
+  uint8_t item;
+
+  ring.push(1);
+  ring.push(2);
+  ring.clear();
+  TEST_ASSERT_EQUAL(0, ring.available());
+  TEST_ASSERT_FALSE(ring.pop(&item));
+  TEST_ASSERT_TRUE(ring.push(3));
+  TEST_ASSERT_TRUE(ring.pop(&item));
+  TEST_ASSERT_EQUAL(3, item);
+}
+
+struct Pair {
+  uint32_t sequence;
+  uint32_t check;
+};
+
+// every item arrives once, in order and whole, or is counted as dropped
+void test_producer_and_consumer_threads(void) {
+  const uint32_t count = 1000000;
+  SpscRing<Pair, 16> ring;
+  std::atomic<bool> done(false);
+  uint32_t dropped = 0;
+
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < count; i++) {
+      Pair pair = { i, ~i };
+      if (!ring.push(pair))
+        dropped++;
+    }
+    done = true;
+  });
+
+  uint32_t received = 0;
+  uint32_t errors = 0;
+  bool first = true;
+  uint32_t last = 0;
+  Pair pair;
+  for (;;) {
+    if (ring.pop(&pair)) {
+      if (pair.check != ~pair.sequence || (!first && pair.sequence <= last))
+        errors++;
+      last = pair.sequence;
+      first = false;
+      received++;
+    } else if (done && ring.available() == 0) {
+      break;
+    }
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL(0, errors);
+  TEST_ASSERT_EQUAL(count, received + dropped);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_order_and_full);
+  RUN_TEST(test_index_wrap);
+  RUN_TEST(test_clear);
+  RUN_TEST(test_producer_and_consumer_threads);
+  return UNITY_END();
+}
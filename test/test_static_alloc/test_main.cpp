@@ -0,0 +1,93 @@
+// Nothing in the sensor stack allocates once begin() has run. malloc is
+// interposed and counts the calls made while armed. Runs in the
+// native_static env, built with REQUIRESSTATIC.
+
+#include <unity.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <OneWire.h>
+#include <WConstants.h>
+#include <DallasTemperature.h>
+#include "TempAcquisition.h"
+#include "ResolutionManager.h"
+
+static bool armed = false;
+static unsigned allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+  static void* (*next)(size_t) = (void* (*)(size_t)) dlsym(RTLD_NEXT, "malloc");
+  if (armed)
+    allocations++;
+  return next(size);
+}
+
+static OneWire wire(4);
+static DallasTemperatureStatic<8> sensors(&wire);
+static TempAcquisition acquisition(&sensors);
+static ResolutionManager resolution(&sensors);
+
+void setUp(void) {
+  allocations = 0;
+}
+
+void tearDown(void) {
+  armed = false;
+}
+
+// the counter sees an allocation, or the other tests prove nothing
+void test_counter_works(void) {
+  armed = true;
+  void* volatile block = malloc(4);
+  armed = false;
+  free(block);
+  TEST_ASSERT_EQUAL(1, allocations);
+}
+
+// a minute of acquisition in every mode, with resolution changes, alarm
+// handling and bulk reads
+void test_no_allocation_after_begin(void) {
+  for (uint8_t i = 0; i < 6; i++)
+    wire.addDevice(ONEWIRE_SIM_DS18B20, i + 1)->setTemperature((20 + i) * 128);
+  sensors.begin();
+
+  armed = true;
+  const TempAcquisition::Mode modes[] = {
+    TempAcquisition::MODE_BROADCAST, TempAcquisition::MODE_PIPELINED, TempAcquisition::MODE_ALARM
+  };
+  for (uint8_t m = 0; m < 3; m++) {
+    acquisition.setMode(modes[m]);
+    acquisition.begin();
+    resolution.begin();
+    unsigned long end = millis() + 20000;
+    while (millis() < end) {
+      unsigned long now = millis();
+      acquisition.update(now);
+      for (uint8_t i = 0; i < acquisition.getSensorCount(); i++) {
+        if (acquisition.isFresh(i))
+          resolution.update(i, acquisition.getTemp(i), now);
+      }
+      // one probe at a time heats up
+      if (now % 5000 == 0)
+        wire.getDevice(now / 5000 % 6)->setTemperature(30 * 128 + now / 100);
+      delay(1);
+    }
+    sensors.stopPipeline();
+  }
+
+  int16_t raw[8];
+  sensors.setWaitForConversion(true);
+  sensors.requestTemperatures();
+  sensors.readAllTemperatures(raw, nullptr, 8);
+  sensors.processAlarms();
+  sensors.setResolution(10);
+  armed = false;
+
+  TEST_ASSERT_EQUAL(0, allocations);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_counter_works);
+  RUN_TEST(test_no_allocation_after_begin);
+  return UNITY_END();
+}
@@ -0,0 +1,295 @@
+// Telemetry framing against reference COBS and CRC-16/CCITT code, and
+// tools/telemetry_decode.py on a capture written from encoded frames.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Telemetry.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// CRC-16/CCITT-FALSE a byte at a time without the bit loop
+static uint16_t referenceCrc(const uint8_t* data, unsigned length) {
+  uint16_t crc = 0xFFFF;
+  for (unsigned i = 0; i < length; i++) {
+    uint8_t x = (crc >> 8) ^ data[i];
+    x ^= x >> 4;
+    crc = (uint16_t) ((crc << 8) ^ ((uint16_t) x << 12) ^ ((uint16_t) x << 5) ^ x);
+  }
+  return crc;
+}
+
+// COBS as the paper states it: every run of up to 254 non-zero bytes is
+// prefixed with its length plus one, a full run implies no zero
+static unsigned referenceCobs(const uint8_t* data, unsigned length, uint8_t* out) {
+  unsigned n = 0, i = 0;
+  for (;;) {
+    unsigned run = 0;
+    while (i + run < length && data[i + run] != 0 && run < 254)
+      run++;
+    out[n++] = (uint8_t) (run + 1);
+    memcpy(out + n, data + i, run);
+    n += run;
+    i += run;
+    if (i == length)
+      return n;
+    if (run < 254)
+      i++;  // the zero the code stands for
+  }
+}
+
+static unsigned cobsDecode(const uint8_t* data, unsigned length, uint8_t* out) {
+  unsigned n = 0, i = 0;
+  while (i < length) {
+    uint8_t code = data[i++];
+    TEST_ASSERT_NOT_EQUAL(0, code);
+    TEST_ASSERT_TRUE(i + code - 1 <= length);
+    memcpy(out + n, data + i, code - 1);
+    n += code - 1;
+    i += code - 1;
+    if (code < 0xFF && i < length)
+      out[n++] = 0;
+  }
+  return n;
+}
+
+// encodes against the reference, round trips and never emits a 0
+static void checkCobs(const uint8_t* data, uint8_t length) {
+  uint8_t encoded[256], expected[256], decoded[256];
+  uint8_t n = Telemetry::cobsEncode(data, length, encoded);
+  unsigned m = referenceCobs(data, length, expected);
+
+  TEST_ASSERT_EQUAL(m, n);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, encoded, n);
+  TEST_ASSERT_EQUAL(length + 1, n);
+  TEST_ASSERT_NULL(memchr(encoded, 0, n));
+  TEST_ASSERT_EQUAL(length, cobsDecode(encoded, n, decoded));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, decoded, length);
+}
+
+void test_crc16(void) {
+  const uint8_t check[] = "123456789";
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, Telemetry::crc16(check, 9));
+  TEST_ASSERT_EQUAL_HEX16(0xFFFF, Telemetry::crc16(check, 0));
+
+  uint8_t data[255];
+  for (unsigned i = 0; i < sizeof(data); i++)
+    data[i] = (uint8_t) (i * 37 + 11);
+  for (unsigned length = 0; length <= sizeof(data); length++)
+    TEST_ASSERT_EQUAL_HEX16(referenceCrc(data, length), Telemetry::crc16(data, length));
+}
+
+void test_cobs_short(void) {
+  const uint8_t zero[] = { 0 };
+  const uint8_t zeros[] = { 0, 0, 0 };
+  const uint8_t mixed[] = { 0x11, 0x22, 0, 0x33 };
+  const uint8_t trailing[] = { 0x11, 0 };
+
+  uint8_t out[8];
+  TEST_ASSERT_EQUAL(1, Telemetry::cobsEncode(zero, 0, out));
+  TEST_ASSERT_EQUAL(1, out[0]);
+
+  checkCobs(zero, 1);
+  checkCobs(zeros, 3);
+  checkCobs(mixed, 4);
+  checkCobs(trailing, 2);
+
+  Telemetry::cobsEncode(mixed, 4, out);
+  const uint8_t expected[] = { 3, 0x11, 0x22, 2, 0x33 };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, 5);
+}
+
+// every length up to the 254 the encoder takes, with no zero, all zeros
+// and zeros at a spacing around the 254 byte block
+void test_cobs_lengths(void) {
+  uint8_t data[254];
+  for (unsigned length = 0; length <= sizeof(data); length++) {
+    memset(data, 0xA5, length);
+    checkCobs(data, length);
+    memset(data, 0, length);
+    checkCobs(data, length);
+    for (unsigned i = 0; i < length; i++)
+      data[i] = i % 7 == 6 ? 0 : (uint8_t) (i + 1);
+    checkCobs(data, length);
+  }
+
+  // one full block, and runs of 253 around a zero
+  memset(data, 0x5A, sizeof(data));
+  uint8_t out[256];
+  TEST_ASSERT_EQUAL(255, Telemetry::cobsEncode(data, 254, out));
+  TEST_ASSERT_EQUAL(0xFF, out[0]);
+  TEST_ASSERT_EQUAL(254, Telemetry::cobsEncode(data, 253, out));
+  TEST_ASSERT_EQUAL(0xFE, out[0]);
+  data[253] = 0;
+  checkCobs(data, 254);
+  data[253] = 0x5A;
+  data[0] = 0;
+  checkCobs(data, 254);
+}
+
+static TelemetryFrame sample(void) {
+  TelemetryFrame frame;
+  frame.timestamp = 0x12345678;
+  const int16_t temps[TELEMETRY_TEMPS] = { 25 * 128 + 64, -10 * 128, 0, -7040 };
+  const uint16_t rpm[TELEMETRY_FANS] = { 1500, 0, 65535, 256 };
+  const uint8_t duty[TELEMETRY_FANS] = { 40, 0, 100, 1 };
+  memcpy(frame.temperatures, temps, sizeof(temps));
+  memcpy(frame.rpm, rpm, sizeof(rpm));
+  memcpy(frame.duty, duty, sizeof(duty));
+  frame.flags = TELEMETRY_FLAG_NO_PROBE | TELEMETRY_FLAG_CURVE(2);
+  return frame;
+}
+
+// the documented layout, little endian
+static unsigned referencePayload(const TelemetryFrame& frame, uint8_t* p) {
+  unsigned n = 0;
+  p[n++] = TELEMETRY_VERSION;
+  for (unsigned b = 0; b < 4; b++)
+    p[n++] = (uint8_t) (frame.timestamp >> (8 * b));
+  for (unsigned i = 0; i < TELEMETRY_TEMPS; i++) {
+    p[n++] = (uint8_t) frame.temperatures[i];
+    p[n++] = (uint8_t) ((uint16_t) frame.temperatures[i] >> 8);
+  }
+  for (unsigned i = 0; i < TELEMETRY_FANS; i++) {
+    p[n++] = (uint8_t) frame.rpm[i];
+    p[n++] = (uint8_t) (frame.rpm[i] >> 8);
+  }
+  for (unsigned i = 0; i < TELEMETRY_FANS; i++)
+    p[n++] = frame.duty[i];
+  p[n++] = (uint8_t) frame.flags;
+  p[n++] = (uint8_t) (frame.flags >> 8);
+  return n;
+}
+
+static void checkFrame(const TelemetryFrame& frame) {
+  uint8_t buffer[TELEMETRY_FRAME_SIZE];
+  uint8_t length = Telemetry::encode(frame, buffer);
+  TEST_ASSERT_EQUAL(TELEMETRY_FRAME_SIZE, length);
+  TEST_ASSERT_EQUAL(0, buffer[length - 1]);
+  TEST_ASSERT_NULL(memchr(buffer, 0, length - 1));
+
+  uint8_t payload[TELEMETRY_PAYLOAD_SIZE + 2];
+  unsigned n = referencePayload(frame, payload);
+  TEST_ASSERT_EQUAL(TELEMETRY_PAYLOAD_SIZE, n);
+  uint16_t crc = referenceCrc(payload, n);
+  payload[n++] = (uint8_t) crc;
+  payload[n++] = (uint8_t) (crc >> 8);
+
+  uint8_t expected[TELEMETRY_FRAME_SIZE];
+  TEST_ASSERT_EQUAL(length - 1, referenceCobs(payload, n, expected));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, buffer, length - 1);
+}
+
+void test_frame_layout(void) {
+  checkFrame(sample());
+
+  // mostly zero bytes
+  TelemetryFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  checkFrame(frame);
+
+  // no zero byte in the payload
+  memset(&frame, 0xFF, sizeof(frame));
+  checkFrame(frame);
+}
+
+// --- tools/telemetry_decode.py ---
+
+static const char* decoder = "tools/telemetry_decode.py";
+
+// the CSV row the decoder prints for a frame
+static void csvRow(const TelemetryFrame& frame, char* text, size_t size) {
+  int n = snprintf(text, size, "%lu", (unsigned long) frame.timestamp);
+  for (unsigned i = 0; i < TELEMETRY_TEMPS; i++)
+    n += snprintf(text + n, size - n, ",%.4f", frame.temperatures[i] / 128.0);
+  for (unsigned i = 0; i < TELEMETRY_FANS; i++)
+    n += snprintf(text + n, size - n, ",%u", frame.rpm[i]);
+  for (unsigned i = 0; i < TELEMETRY_FANS; i++)
+    n += snprintf(text + n, size - n, ",%u", frame.duty[i]);
+  snprintf(text + n, size - n, ",0x%04X\n", frame.flags);
+}
+
+static void writeFrame(FILE* capture, const TelemetryFrame& frame) {
+  uint8_t buffer[TELEMETRY_FRAME_SIZE];
+  uint8_t length = Telemetry::encode(frame, buffer);
+  fwrite(buffer, 1, length, capture);
+}
+
+// runs the decoder on a capture, returns its CSV rows after the header
+static unsigned decode(const char* path, char rows[][160], unsigned count) {
+  char command[160];
+  snprintf(command, sizeof(command), "python3 %s %s 2>/dev/null", decoder, path);
+  FILE* csv = popen(command, "r");
+  if (csv == 0)
+    return 0;
+  char header[256];
+  unsigned n = 0;
+  if (fgets(header, sizeof(header), csv) != 0)
+    while (n < count && fgets(rows[n], sizeof(rows[n]), csv) != 0)
+      n++;
+  pclose(csv);
+  return n;
+}
+
+// Command replies stay text in binary mode. A line carries no 0, so it
+// runs into the next frame and takes it down with it, the frame after
+// that decodes again.
+void test_decoder(void) {
+  if (access(decoder, R_OK) != 0 || system("python3 -c pass 2>/dev/null") != 0)
+    TEST_IGNORE_MESSAGE("needs python3 and the project directory as working directory");
+
+  char path[] = "/tmp/telemetryXXXXXX";
+  int fd = mkstemp(path);
+  TEST_ASSERT_TRUE(fd >= 0);
+  FILE* capture = fdopen(fd, "wb");
+
+  TelemetryFrame first = sample();
+  TelemetryFrame lost = sample();
+  lost.timestamp += 50;
+  TelemetryFrame after = sample();
+  after.timestamp += 100;
+  after.duty[0] = 55;
+  TelemetryFrame damaged = sample();
+  damaged.timestamp += 150;
+  TelemetryFrame zeros;
+  memset(&zeros, 0, sizeof(zeros));
+
+  writeFrame(capture, first);
+  fputs("Unknown fan\r\n", capture);
+  writeFrame(capture, lost);
+  writeFrame(capture, after);
+
+  uint8_t buffer[TELEMETRY_FRAME_SIZE];
+  uint8_t length = Telemetry::encode(damaged, buffer);
+  buffer[length / 2] ^= 0x40;
+  fwrite(buffer, 1, length, capture);
+
+  writeFrame(capture, zeros);
+  fclose(capture);
+
+  char rows[8][160];
+  unsigned n = decode(path, rows, 8);
+  unlink(path);
+
+  char expected[160];
+  TEST_ASSERT_EQUAL(3, n);
+  csvRow(first, expected, sizeof(expected));
+  TEST_ASSERT_EQUAL_STRING(expected, rows[0]);
+  csvRow(after, expected, sizeof(expected));
+  TEST_ASSERT_EQUAL_STRING(expected, rows[1]);
+  csvRow(zeros, expected, sizeof(expected));
+  TEST_ASSERT_EQUAL_STRING(expected, rows[2]);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc16);
+  RUN_TEST(test_cobs_short);
+  RUN_TEST(test_cobs_lengths);
+  RUN_TEST(test_frame_layout);
+  RUN_TEST(test_decoder);
+  return UNITY_END();
+}
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Decode the controller's binary telemetry into CSV.
+
+Reads a raw capture of the serial port (a file, or stdin when no file is
+given) and writes one CSV row per valid frame. Frames are COBS encoded,
+0 terminated and carry a CRC-16/CCITT; damaged frames and text lines
+mixed into the stream are skipped. A text line has no 0 to end it, so the
+frame right after it is lost along with it.
+
+    stty -F /dev/ttyUSB0 115200 raw
+    python3 tools/telemetry_decode.py < /dev/ttyUSB0 > telemetry.csv
+"""
+
+import struct
+import sys
+
+TEMPS = 4
+FANS = 4
+VERSION = 1
+LAYOUT = struct.Struct("<BI%dh%dH%dBH" % (TEMPS, FANS, FANS))
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode(frame):
+    payload = cobs_decode(frame)
+    if payload is None or len(payload) != LAYOUT.size + 2:
+        return None
+    body, crc = payload[:-2], struct.unpack("<H", payload[-2:])[0]
+    if crc16(body) != crc:
+        return None
+    fields = LAYOUT.unpack(body)
+    if fields[0] != VERSION:
+        return None
+    timestamp = fields[1]
+    temps = ["%.4f" % (t / 128.0) for t in fields[2:2 + TEMPS]]
+    rpm = fields[2 + TEMPS:2 + TEMPS + FANS]
+    duty = fields[2 + TEMPS + FANS:2 + TEMPS + 2 * FANS]
+    flags = fields[-1]
+    return [timestamp] + temps + list(rpm) + list(duty) + ["0x%04X" % flags]
+
+
+def main():
+    source = open(sys.argv[1], "rb") if len(sys.argv) > 1 else sys.stdin.buffer
+    header = (["timestamp_ms"]
+              + ["temp%d_c" % i for i in range(TEMPS)]
+              + ["rpm%d" % i for i in range(FANS)]
+              + ["duty%d" % i for i in range(FANS)]
+              + ["flags"])
+    print(",".join(header))
+
+    pending = bytearray()
+    while True:
+        chunk = source.read(256)
+        if not chunk:
+            break
+        pending += chunk
+        while True:
+            end = pending.find(0)
+            if end < 0:
+                break
+            row = decode(bytes(pending[:end]))
+            del pending[:end + 1]
+            if row is not None:
+                print(",".join(str(v) for v in row))
+                sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()